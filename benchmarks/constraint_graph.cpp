@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+#include "synthetic.hpp"
+
+#include <arc_consistency.hpp>
+#include <constraint_graph.hpp>
+#include <disparity_graph.hpp>
+#include <labeling_finder.hpp>
+#include <lowest_penalties.hpp>
+
+using sp::graph::arc_consistency::solve_csp_worklist;
+using sp::graph::constraint::ConstraintGraph;
+using sp::graph::constraint::solve_csp;
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::lowest_penalties::LowestPenalties;
+using sp::labeling::finder::calculate_minimal_consistent_threshold;
+using sp::labeling::finder::fetch_available_penalties;
+using sp::types::BOOL;
+using sp::types::FLOAT;
+
+static void solve(
+    benchmark::State& state,
+    BOOL (*solver)(struct ConstraintGraph*)
+)
+{
+    struct DisparityGraph graph{synthetic::build_disparity_graph(state)};
+    cache_node_penalties(&graph);
+    struct LowestPenalties lowest_penalties{&graph};
+    FLOAT threshold = calculate_minimal_consistent_threshold(
+        &lowest_penalties,
+        &graph,
+        fetch_available_penalties(&lowest_penalties)
+    );
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        struct ConstraintGraph constraint_graph{
+            &graph,
+            &lowest_penalties,
+            threshold
+        };
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(solver(&constraint_graph));
+    }
+    state.SetItemsProcessed(
+        state.iterations() * graph.right.width * graph.right.height
+    );
+}
+
+static void solve_csp_benchmark(benchmark::State& state)
+{
+    solve(state, solve_csp);
+}
+BENCHMARK(solve_csp_benchmark)
+    ->Apply(synthetic::apply_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void solve_csp_worklist_benchmark(benchmark::State& state)
+{
+    solve(state, solve_csp_worklist);
+}
+BENCHMARK(solve_csp_worklist_benchmark)
+    ->Apply(synthetic::apply_sizes)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,136 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+#include "synthetic.hpp"
+
+#include <disparity_graph.hpp>
+
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::disparity::edge_penalty;
+using sp::graph::disparity::node_penalty;
+using sp::types::Edge;
+using sp::types::FLOAT;
+using sp::types::Node;
+using sp::types::ULONG;
+
+static void penalize_nodes(benchmark::State& state, bool cached)
+{
+    struct DisparityGraph graph{synthetic::build_disparity_graph(state)};
+    if (cached)
+    {
+        cache_node_penalties(&graph);
+    }
+    ULONG nodes = 0;
+    for (auto _ : state)
+    {
+        FLOAT penalty = 0;
+        nodes = 0;
+        struct Node node{{0, 0}, 0};
+        for (node.pixel.y = 0; node.pixel.y < graph.right.height; ++node.pixel.y)
+        {
+            for (
+                node.pixel.x = 0;
+                node.pixel.x < graph.right.width;
+                ++node.pixel.x
+            )
+            {
+                for (
+                    node.disparity = 0;
+                    node.pixel.x + node.disparity < graph.left.width
+                        && node.disparity < graph.disparity_levels;
+                    ++node.disparity
+                )
+                {
+                    penalty += node_penalty(&graph, node);
+                    ++nodes;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(penalty);
+    }
+    state.SetItemsProcessed(state.iterations() * nodes);
+}
+
+static void node_penalty_benchmark(benchmark::State& state)
+{
+    penalize_nodes(state, false);
+}
+BENCHMARK(node_penalty_benchmark)->Apply(synthetic::apply_sizes);
+
+static void cached_node_penalty_benchmark(benchmark::State& state)
+{
+    penalize_nodes(state, true);
+}
+BENCHMARK(cached_node_penalty_benchmark)->Apply(synthetic::apply_sizes);
+
+static void edge_penalty_benchmark(benchmark::State& state)
+{
+    struct DisparityGraph graph{synthetic::build_disparity_graph(state)};
+    ULONG edges = 0;
+    for (auto _ : state)
+    {
+        FLOAT penalty = 0;
+        edges = 0;
+        struct Edge edge{{{0, 0}, 0}, {{0, 0}, 0}};
+        for (
+            edge.node.pixel.y = 0;
+            edge.node.pixel.y + 1 < graph.right.height;
+            ++edge.node.pixel.y
+        )
+        {
+            for (
+                edge.node.pixel.x = 0;
+                edge.node.pixel.x < graph.right.width;
+                ++edge.node.pixel.x
+            )
+            {
+                edge.neighbor.pixel = {edge.node.pixel.x, edge.node.pixel.y + 1};
+                for (
+                    edge.node.disparity = 0;
+                    edge.node.pixel.x + edge.node.disparity < graph.left.width
+                        && edge.node.disparity < graph.disparity_levels;
+                    ++edge.node.disparity
+                )
+                {
+                    for (
+                        edge.neighbor.disparity = 0;
+                        edge.neighbor.pixel.x + edge.neighbor.disparity
+                            < graph.left.width
+                        && edge.neighbor.disparity < graph.disparity_levels;
+                        ++edge.neighbor.disparity
+                    )
+                    {
+                        penalty += edge_penalty(&graph, edge);
+                        ++edges;
+                    }
+                }
+            }
+        }
+        benchmark::DoNotOptimize(penalty);
+    }
+    state.SetItemsProcessed(state.iterations() * edges);
+}
+BENCHMARK(edge_penalty_benchmark)->Apply(synthetic::apply_sizes);
@@ -0,0 +1,107 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+#include "synthetic.hpp"
+
+#include <arc_consistency.hpp>
+#include <constraint_graph.hpp>
+#include <disparity_graph.hpp>
+#include <labeling_finder.hpp>
+#include <lowest_penalties.hpp>
+
+using sp::graph::arc_consistency::solve_csp_worklist;
+using sp::graph::constraint::ConstraintGraph;
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::lowest_penalties::LowestPenalties;
+using sp::labeling::finder::calculate_minimal_consistent_threshold;
+using sp::labeling::finder::fetch_available_penalties;
+using sp::labeling::finder::find_labeling;
+using sp::types::FLOAT;
+
+static void fetch_available_penalties_benchmark(benchmark::State& state)
+{
+    struct DisparityGraph graph{synthetic::build_disparity_graph(state)};
+    cache_node_penalties(&graph);
+    struct LowestPenalties lowest_penalties{&graph};
+    for (auto _ : state)
+    {
+        auto available_penalties = fetch_available_penalties(&lowest_penalties);
+        benchmark::DoNotOptimize(available_penalties.data());
+        state.counters["penalties"] = available_penalties.size();
+    }
+}
+BENCHMARK(fetch_available_penalties_benchmark)
+    ->Apply(synthetic::apply_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void minimal_consistent_threshold_benchmark(benchmark::State& state)
+{
+    struct DisparityGraph graph{synthetic::build_disparity_graph(state)};
+    cache_node_penalties(&graph);
+    struct LowestPenalties lowest_penalties{&graph};
+    auto available_penalties = fetch_available_penalties(&lowest_penalties);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            calculate_minimal_consistent_threshold(
+                &lowest_penalties,
+                &graph,
+                available_penalties
+            )
+        );
+    }
+    state.counters["penalties"] = available_penalties.size();
+}
+BENCHMARK(minimal_consistent_threshold_benchmark)
+    ->Apply(synthetic::apply_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void find_labeling_benchmark(benchmark::State& state)
+{
+    struct DisparityGraph graph{synthetic::build_disparity_graph(state)};
+    cache_node_penalties(&graph);
+    struct LowestPenalties lowest_penalties{&graph};
+    FLOAT threshold = calculate_minimal_consistent_threshold(
+        &lowest_penalties,
+        &graph,
+        fetch_available_penalties(&lowest_penalties)
+    );
+    struct ConstraintGraph solved_graph{&graph, &lowest_penalties, threshold};
+    solve_csp_worklist(&solved_graph);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        struct ConstraintGraph constraint_graph{solved_graph};
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(find_labeling(&constraint_graph));
+    }
+    state.SetItemsProcessed(
+        state.iterations() * graph.right.width * graph.right.height
+    );
+}
+BENCHMARK(find_labeling_benchmark)
+    ->Apply(synthetic::apply_sizes)
+    ->Unit(benchmark::kMillisecond);
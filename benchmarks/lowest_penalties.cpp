@@ -0,0 +1,50 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+#include "synthetic.hpp"
+
+#include <disparity_graph.hpp>
+#include <lowest_penalties.hpp>
+
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::lowest_penalties::LowestPenalties;
+
+static void lowest_penalties_benchmark(benchmark::State& state)
+{
+    struct DisparityGraph graph{synthetic::build_disparity_graph(state)};
+    cache_node_penalties(&graph);
+    for (auto _ : state)
+    {
+        struct LowestPenalties lowest_penalties{&graph};
+        benchmark::DoNotOptimize(lowest_penalties.neighborhoods.data());
+    }
+    state.SetItemsProcessed(
+        state.iterations() * graph.right.width * graph.right.height
+    );
+}
+BENCHMARK(lowest_penalties_benchmark)
+    ->Apply(synthetic::apply_sizes)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,119 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BENCHMARKS_SYNTHETIC_HPP
+#define BENCHMARKS_SYNTHETIC_HPP
+
+#include <benchmark/benchmark.h>
+
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <types.hpp>
+
+#include "random_images.hpp"
+
+#include <algorithm>
+
+/**
+ * \brief Synthetic problems to benchmark stages of the solution on.
+ */
+namespace synthetic
+{
+
+using sp::graph::disparity::DisparityGraph;
+using sp::image::Image;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+/**
+ * \brief Maximal intensity of synthetic images.
+ */
+const ULONG MAX_VALUE = 255;
+
+/**
+ * \brief Build a pair of images of a scene
+ * that consists of squares of 16 pixels
+ * with the lowest and the highest disparity
+ * placed as a chessboard.
+ *
+ * The left image is a noise made by random_images::fill_noise,
+ * so results are the same on each run.
+ * The right one is the left image shifted by the disparity of each pixel.
+ */
+inline struct DisparityGraph build_disparity_graph(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels
+)
+{
+    struct Image left_image{width, height, MAX_VALUE, ULONG_ARRAY(width * height)};
+    struct Image right_image{width, height, MAX_VALUE, ULONG_ARRAY(width * height)};
+    random_images::fill_noise(&left_image, 1);
+    for (ULONG y = 0; y < height; ++y)
+    {
+        for (ULONG x = 0; x < width; ++x)
+        {
+            ULONG disparity = ((x / 16 + y / 16) % 2) * (disparity_levels - 1);
+            right_image.data[x + width * y]
+                = left_image.data[std::min(x + disparity, width - 1) + width * y];
+        }
+    }
+    return DisparityGraph{left_image, right_image, disparity_levels, 1, 1};
+}
+
+/**
+ * \brief Build a problem from arguments of the benchmark:
+ * width of images and number of disparity levels.
+ *
+ * Height of images is three quarters of their width.
+ */
+inline struct DisparityGraph build_disparity_graph(
+    const benchmark::State& state
+)
+{
+    return build_disparity_graph(
+        static_cast<ULONG>(state.range(0)),
+        static_cast<ULONG>(state.range(0) * 3 / 4),
+        static_cast<ULONG>(state.range(1))
+    );
+}
+
+/**
+ * \brief Set sizes of images and numbers of disparity levels
+ * to run the benchmark with.
+ */
+inline void apply_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"width", "disparity_levels"});
+    for (long width : {32, 64, 128})
+    {
+        for (long disparity_levels : {8, 16})
+        {
+            benchmark->Args({width, disparity_levels});
+        }
+    }
+}
+
+}
+
+#endif
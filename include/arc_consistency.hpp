@@ -0,0 +1,264 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef ARC_CONSISTENCY_HPP
+#define ARC_CONSISTENCY_HPP
+
+#include <availability.hpp>
+#include <constraint_graph.hpp>
+#include <types.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Worklist-driven solution of CSP.
+ */
+namespace sp::graph::arc_consistency
+{
+
+using sp::graph::availability::NodesAvailability;
+using sp::graph::constraint::ConstraintGraph;
+using sp::graph::disparity::DisparityGraph;
+using sp::types::BOOL;
+using sp::types::Edge;
+using sp::types::Node;
+using sp::types::Pixel;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+/**
+ * \brief Summary of removals made by propagation.
+ */
+struct Propagation
+{
+    /**
+     * \brief `false` if all nodes were removed --- the problem is unsolvable.
+     */
+    BOOL solvable;
+    /**
+     * \brief Number of removed nodes.
+     */
+    ULONG removed_nodes;
+    /**
+     * \brief Top left corner of the bounding box of pixels
+     * that have lost nodes.
+     *
+     * Meaningless if no nodes were removed.
+     */
+    struct Pixel first;
+    /**
+     * \brief Bottom right corner (inclusive) of the bounding box of pixels
+     * that have lost nodes.
+     *
+     * Meaningless if no nodes were removed.
+     */
+    struct Pixel last;
+};
+
+/**
+ * \brief State of worklist-driven (AC-4) arc consistency
+ * for sp::graph::constraint::ConstraintGraph.
+ *
+ * sp::graph::constraint::solve_csp sweeps all nodes
+ * until nothing changes,
+ * so each iteration costs \f$O\left( |I| \cdot |D|^2 \right)\f$
+ * even if only a few nodes were removed.
+ *
+ * Here, for each available node \f$d\f$ of pixel \f$i\f$
+ * and each neighbor \f$j \in \mathcal{N}_i\f$
+ * we count supports: available nodes \f$d'\f$ of \f$j\f$,
+ * for which the edge \f$\left\langle d, d' \right\rangle\f$ is available.
+ * Removed nodes are put into a worklist.
+ * When a removed node is taken from the worklist,
+ * counters of its neighbors are decremented,
+ * and nodes that lost their last support in some direction
+ * are removed too.
+ * This way only pixels, neighbors of which have lost support,
+ * are revisited.
+ *
+ * The result is the same as the result of sp::graph::constraint::solve_csp.
+ *
+ * The state may outlive a single solution.
+ * If nodes of a pixel were removed from the graph directly,
+ * for example by sp::labeling::finder::choose_best_node,
+ * sp::graph::arc_consistency::propagate_from
+ * restores consistency spreading only as far as removals cascade.
+ */
+struct ArcConsistency
+{
+    /**
+     * \brief Graph which availability markers are updated.
+     */
+    struct ConstraintGraph* graph;
+    /**
+     * \brief Markers of nodes the counters are consistent with.
+     *
+     * Differs from sp::graph::constraint::ConstraintGraph::nodes_availability
+     * only in nodes removed from the graph directly
+     * and not yet passed to sp::graph::arc_consistency::propagate_from.
+     */
+    NodesAvailability known;
+    /**
+     * \brief Lowest disparity of the domain of each pixel.
+     *
+     * Domain of a pixel is the range from its lowest to its highest
+     * node available when the state was created.
+     * Nodes never become available again,
+     * so nodes outside of domains need no counters.
+     * Pixels are enumerated by sp::indexing::nodes_pixel_index.
+     */
+    ULONG_ARRAY domain_first;
+    /**
+     * \brief Position of the domain of each pixel
+     * in the list of nodes of all domains,
+     * followed by the total number of nodes in domains.
+     */
+    ULONG_ARRAY domain_offsets;
+    /**
+     * \brief Number of supports of each node of domains in each direction.
+     *
+     * Index of counter for a Node and a neighbor index
+     * is calculated by sp::graph::arc_consistency::support_index.
+     * The size follows the nodes that survived the threshold
+     * rather than all nodes of the graph.
+     * Counters of removed nodes are meaningless.
+     * Empty if counters don't fit into 16 bits
+     * (see sp::graph::arc_consistency::support_counter_bytes).
+     */
+    std::vector<std::uint16_t> supports;
+    /**
+     * \brief Counters of supports used instead of
+     * sp::graph::arc_consistency::ArcConsistency::supports
+     * when the number of disparity levels doesn't fit into 16 bits.
+     */
+    std::vector<std::uint32_t> wide_supports;
+    /**
+     * \brief Removed nodes that haven't been propagated yet.
+     */
+    std::vector<struct Node> worklist;
+    /**
+     * \brief Removals made since the state was created
+     * or since the last call of sp::graph::arc_consistency::propagate_from.
+     */
+    struct Propagation propagation;
+    /**
+     * \brief Count supports of all available nodes
+     * and put nodes without support into the worklist.
+     *
+     * If a pixel has no available nodes,
+     * all nodes of the graph are marked as unavailable.
+     * `counter_bytes` forces the width of counters of supports,
+     * zero chooses it by sp::graph::arc_consistency::support_counter_bytes.
+     */
+    ArcConsistency(struct ConstraintGraph* graph, ULONG counter_bytes = 0);
+};
+
+/**
+ * \brief Number of bytes of a counter of supports
+ * for a graph with the number of disparity levels.
+ *
+ * Counters take 16 bits unless a node can have more supports.
+ */
+ULONG support_counter_bytes(ULONG disparity_levels);
+/**
+ * \brief Index of the counter of supports of the node
+ * in the direction of the neighbor.
+ *
+ * The index is \f$k + 4 \cdot (o_p + d - f_p)\f$,
+ * where \f$k\f$ is the neighbor index,
+ * \f$o_p\f$ and \f$f_p\f$ are the offset and the lowest disparity
+ * of the domain of the pixel.
+ * The node should belong to the domain.
+ */
+ULONG support_index(
+    const struct ArcConsistency* state,
+    struct Node node,
+    ULONG neighbor_index
+);
+/**
+ * \brief Check the edge ignoring availability of its nodes.
+ *
+ * Same as sp::graph::constraint::is_edge_available,
+ * but markers of nodes are not used.
+ */
+BOOL edge_allowed(const struct ConstraintGraph* graph, struct Edge edge);
+/**
+ * \brief Count available nodes of the neighbor
+ * connected with the node by allowed edges.
+ */
+ULONG count_supports(
+    const struct ConstraintGraph* graph,
+    struct Node node,
+    ULONG neighbor_index
+);
+/**
+ * \brief Mark the node as unavailable
+ * and put it into the worklist
+ * if it was known as available.
+ */
+void remove_node(struct ArcConsistency* state, struct Node node);
+/**
+ * \brief Take removed nodes from the worklist
+ * until it's empty, decrementing counters of neighbors.
+ *
+ * As soon as a pixel loses all nodes,
+ * all nodes of the graph are marked as unavailable.
+ *
+ * @return
+ *  Boolean flag.
+ *  `true` if nonempty solution was found.
+ *  `false` if all nodes were removed --- the problem is unsolvable.
+ */
+BOOL propagate(struct ArcConsistency* state);
+/**
+ * \brief Restore consistency after nodes of the pixel
+ * were removed from the graph directly.
+ *
+ * Removed nodes of the pixel are put into the worklist,
+ * and sp::graph::arc_consistency::propagate processes them.
+ * Only pixels reached by the cascade of removals are visited.
+ *
+ * @return
+ *  Removals made by the call.
+ */
+struct Propagation propagate_from(
+    struct ArcConsistency* state,
+    struct Pixel pixel
+);
+/**
+ * \brief Remove all nodes that don't belong to any solution
+ * using sp::graph::arc_consistency::ArcConsistency.
+ *
+ * Drop-in replacement of sp::graph::constraint::solve_csp.
+ *
+ * @return
+ *  Boolean flag.
+ *  `true` if nonempty solution was found.
+ *  `false` if all nodes were removed --- the problem is unsolvable.
+ */
+BOOL solve_csp_worklist(struct ConstraintGraph* graph);
+
+}
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef AVAILABILITY_HPP
+#define AVAILABILITY_HPP
+
+#include <types.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * \brief Storage of availability markers of nodes.
+ */
+namespace sp::graph::availability
+{
+
+using sp::types::BOOL;
+using sp::types::ULONG;
+
+/**
+ * \brief Packed thread-safe array of availability markers of nodes.
+ *
+ * `std::vector<bool>` packs values into bits too,
+ * but writes to different bits of the same word
+ * from different threads are a data race.
+ * sp::graph::constraint::solve_csp removes nodes of neighboring pixels
+ * from different threads,
+ * so the markers are stored in atomic 64-bit words
+ * and bits are cleared with atomic `and` operations.
+ *
+ * Each pixel owns a mask of sp::graph::availability::NodesAvailability::WORD_BITS-aligned
+ * size, so nodes of different pixels never share a word.
+ * Bit \f$d\f$ of the mask of pixel \f$p\f$ marks
+ * availability of the Node with disparity \f$d\f$.
+ * Pixels are enumerated by sp::indexing::nodes_pixel_index.
+ */
+class NodesAvailability
+{
+public:
+    /**
+     * \brief Type of a word of the packed array.
+     */
+    using WORD = std::uint64_t;
+    /**
+     * \brief Number of bits in one word.
+     */
+    static const ULONG WORD_BITS = 64;
+    /**
+     * \brief Default constructor creates an empty array.
+     */
+    NodesAvailability() = default;
+    /**
+     * \brief Create an array with all nodes marked as unavailable.
+     */
+    NodesAvailability(ULONG pixels, ULONG disparity_levels);
+    /**
+     * \brief Copy constructor makes a deep copy of markers.
+     *
+     * Shouldn't be called while other threads modify the `other` array.
+     */
+    NodesAvailability(const NodesAvailability& other);
+    /**
+     * \brief Default move constructor.
+     */
+    NodesAvailability(NodesAvailability&&) noexcept = default;
+    /**
+     * \brief Copy assignment operator makes a deep copy of markers.
+     */
+    NodesAvailability& operator=(const NodesAvailability& other);
+    /**
+     * \brief Default move assignment operator.
+     */
+    NodesAvailability& operator=(NodesAvailability&&) noexcept = default;
+    /**
+     * \brief Default destructor.
+     */
+    ~NodesAvailability() = default;
+    /**
+     * \brief Check whether the node is available.
+     */
+    BOOL test(ULONG pixel, ULONG disparity) const
+    {
+        return (
+            this->word(pixel, disparity).load(std::memory_order_relaxed)
+            >> (disparity % WORD_BITS)
+        ) & 1u;
+    }
+    /**
+     * \brief Mark the node as available.
+     */
+    void set(ULONG pixel, ULONG disparity)
+    {
+        this->word(pixel, disparity).fetch_or(
+            WORD{1} << (disparity % WORD_BITS),
+            std::memory_order_relaxed
+        );
+    }
+    /**
+     * \brief Mark the node as unavailable.
+     *
+     * @return
+     *  `true` if the node was available before the call.
+     *  Only one of threads that reset the same node simultaneously
+     *  gets `true`.
+     */
+    BOOL reset(ULONG pixel, ULONG disparity)
+    {
+        const WORD mask = WORD{1} << (disparity % WORD_BITS);
+        return (
+            this->word(pixel, disparity).fetch_and(
+                ~mask,
+                std::memory_order_relaxed
+            ) & mask
+        ) != 0;
+    }
+    /**
+     * \brief Mark all nodes as unavailable.
+     */
+    void reset_all();
+    /**
+     * \brief Check whether at least one node is available.
+     */
+    BOOL any() const;
+    /**
+     * \brief Check whether at least one node of the pixel is available.
+     */
+    BOOL any(ULONG pixel) const;
+    /**
+     * \brief Find the first available node of the pixel
+     * with disparity not less than `disparity`.
+     *
+     * Unavailable nodes are skipped a word at a time,
+     * so iteration over available nodes of a pixel
+     * costs the number of available nodes
+     * rather than the number of disparities.
+     *
+     * @return
+     *  Disparity of the found node
+     *  or sp::graph::availability::NodesAvailability::get_disparity_levels
+     *  if there is no such node.
+     */
+    ULONG next(ULONG pixel, ULONG disparity) const;
+    /**
+     * \brief Count available nodes.
+     */
+    ULONG count() const;
+    /**
+     * \brief Count available nodes of the pixel.
+     */
+    ULONG count(ULONG pixel) const;
+    /**
+     * \brief Number of pixels.
+     */
+    ULONG get_pixels() const;
+    /**
+     * \brief Number of disparities per pixel.
+     */
+    ULONG get_disparity_levels() const;
+    /**
+     * \brief Total number of nodes,
+     * i.e. size of a flat array of markers.
+     */
+    ULONG size() const;
+    /**
+     * \brief Unpack markers into a flat array
+     * indexed by sp::indexing::node_index.
+     *
+     * Used to send markers to GPU.
+     */
+    template<typename T>
+    std::vector<T> flatten() const
+    {
+        std::vector<T> result(this->size());
+        for (ULONG pixel = 0; pixel < this->pixels; ++pixel)
+        {
+            for (
+                ULONG disparity = 0;
+                disparity < this->disparity_levels;
+                ++disparity
+            )
+            {
+                result[pixel * this->disparity_levels + disparity]
+                    = static_cast<T>(this->test(pixel, disparity));
+            }
+        }
+        return result;
+    }
+    /**
+     * \brief Pack markers from a flat array
+     * indexed by sp::indexing::node_index.
+     *
+     * Used to receive markers from GPU.
+     * The array should contain
+     * sp::graph::availability::NodesAvailability::size elements.
+     */
+    template<typename InputIt>
+    void assign(InputIt first, InputIt last)
+    {
+        this->reset_all();
+        for (ULONG index = 0; first != last; ++first, ++index)
+        {
+            if (*first)
+            {
+                this->set(
+                    index / this->disparity_levels,
+                    index % this->disparity_levels
+                );
+            }
+        }
+    }
+private:
+    /**
+     * \brief Number of pixels.
+     */
+    ULONG pixels = 0;
+    /**
+     * \brief Number of disparities per pixel.
+     */
+    ULONG disparity_levels = 0;
+    /**
+     * \brief Number of words in a mask of one pixel.
+     */
+    ULONG words_per_pixel = 0;
+    /**
+     * \brief Packed markers.
+     */
+    std::unique_ptr<std::atomic<WORD>[]> words;
+    /**
+     * \brief Word that contains the marker of the node.
+     */
+    std::atomic<WORD>& word(ULONG pixel, ULONG disparity) const
+    {
+        return this->words[
+            pixel * this->words_per_pixel + disparity / WORD_BITS
+        ];
+    }
+};
+
+}
+
+#endif
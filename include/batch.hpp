@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <types.hpp>
+
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Processing of many stereo pairs in one process.
+ */
+namespace sp::batch
+{
+
+using sp::types::BOOL;
+using sp::types::ULONG;
+
+/**
+ * \brief Paths of images of a stereo pair and of its disparity map.
+ */
+struct StereoPair
+{
+    /**
+     * \brief Path of the left image.
+     */
+    std::string left;
+    /**
+     * \brief Path of the right image.
+     */
+    std::string right;
+    /**
+     * \brief Path of the disparity map to write.
+     */
+    std::string output;
+};
+
+/**
+ * \brief Images with fewer pixels are processed concurrently
+ * by sp::batch::run_batch, one thread per pair.
+ */
+const ULONG SMALL_IMAGE_PIXELS = 1ul << 16u;
+
+/**
+ * \brief Read stereo pairs listed in a manifest.
+ *
+ * Each line contains paths of the left and right images
+ * and, optionally, the path of the disparity map separated by whitespace.
+ * Blank lines and lines starting with `#` are skipped.
+ * Relative paths are resolved against `base_directory`.
+ * If the disparity map is omitted,
+ * it's written to `output_directory` with the name of the left image.
+ *
+ * Throws `std::invalid_argument` if a line contains one path,
+ * more than three paths,
+ * the disparity map is omitted and `output_directory` is empty,
+ * or two lines write disparity maps to the same path
+ * (e.g. left images of the same name without explicit disparity maps).
+ */
+std::vector<struct StereoPair> read_manifest(
+    std::istream& in,
+    const std::string& base_directory,
+    const std::string& output_directory
+);
+/**
+ * \brief Read stereo pairs from a manifest file or a directory.
+ *
+ * A directory should contain `left` and `right` subdirectories
+ * with images of the same names.
+ * Disparity maps are written to `output_directory`
+ * with the same names.
+ * Pairs are sorted by names.
+ *
+ * A manifest is read by sp::batch::read_manifest
+ * with paths relative to its directory.
+ *
+ * Throws `std::invalid_argument` if the path cannot be read,
+ * or a left image has no right one.
+ */
+std::vector<struct StereoPair> read_batch(
+    const std::string& path,
+    const std::string& output_directory
+);
+/**
+ * \brief Process stereo pairs with a shared pool of threads.
+ *
+ * Pairs with images of at least `small_pixels` pixels
+ * are processed one by one, each by all threads.
+ * Smaller pairs are processed concurrently,
+ * one thread per pair, so a thread that finished a pair takes the next one.
+ * Nested parallelism is disabled meanwhile,
+ * so parallel regions of `solve` are run by the calling thread alone.
+ * Size of a pair is taken from the header of its left image;
+ * pairs with unreadable headers are considered small.
+ *
+ * `solve` is called once for each index of `pairs`,
+ * possibly from several threads simultaneously,
+ * should not throw and should return `false` if the pair failed.
+ * Threads keep their thread-local storage between pairs,
+ * so `solve` can reuse buffers kept there.
+ *
+ * @return
+ *  Number of failed pairs.
+ */
+ULONG run_batch(
+    const std::vector<struct StereoPair>& pairs,
+    ULONG small_pixels,
+    const std::function<BOOL(ULONG index)>& solve
+);
+
+}
+
+#endif
@@ -30,6 +30,8 @@
 #include <types.hpp>
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+#include <availability.hpp>
+
 /**
  * \brief Utilities to solve CSP.
  */
@@ -40,6 +42,7 @@ namespace graph
 namespace constraint
 {
 
+using sp::graph::availability::NodesAvailability;
 using sp::graph::disparity::DisparityGraph;
 using sp::graph::lowest_penalties::LowestPenalties;
 using sp::types::BOOL;
@@ -296,15 +299,24 @@ struct ConstraintGraph
      *
      * \f[
      *  k\left( \left\langle x, y \right\rangle, d \right) =
-     *  d + \max{D} \cdot \left( y + h \cdot x \right),
+     *  d + \max{D} \cdot \left( x + w \cdot y \right),
      * \f]
      *
      * where \f$\left\langle x, y \right\rangle\f$
      * are coordinates of Node::pixel,
      * \f$i\f$ is an index of used neighbor
      * and \f$d\f$ is a Node::disparity.
+     *
+     * On CPU markers are packed into bits
+     * of sp::graph::availability::NodesAvailability,
+     * so different threads can safely remove nodes
+     * of neighboring pixels.
      */
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    NodesAvailability nodes_availability;
+    #else
     __global BOOL_ARRAY nodes_availability;
+    #endif
     /**
      * \brief Threshold to compare penalty of an edge with the minimal one
      * against.
@@ -374,6 +386,21 @@ __device__ BOOL is_node_available(
     const struct ConstraintGraph* graph,
     struct Node node
 );
+/**
+ * \brief Skip unavailable nodes of the pixel
+ * starting from the disparity.
+ *
+ * On CPU returns the first available disparity not less than `disparity`
+ * or sp::graph::disparity::DisparityGraph::disparity_levels if none left,
+ * so loops over the domain of a pixel visit surviving nodes only.
+ * On GPU simply returns `disparity`,
+ * so callers should still check sp::graph::constraint::is_node_available.
+ */
+__device__ ULONG next_available_disparity(
+    const struct ConstraintGraph* graph,
+    struct Pixel pixel,
+    ULONG disparity
+);
 /**
  * \brief Check whether the Edge is still available.
  *
@@ -446,16 +473,68 @@ __device__ BOOL csp_solution_iteration(
 /**
  * \brief Remove all nodes that don't belong to any soluton.
  *
+ * Uses sp::graph::constraint::CspSchedule with default values.
+ *
  * @return
  *  Boolean flag.
  *  `true` if nonempty solution was found.
  *  `false` if all nodes were removed --- the problem is unsolvable.
  */
 __device__ BOOL solve_csp(struct ConstraintGraph* graph);
+#if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+/**
+ * \brief Distribution of sp::graph::constraint::solve_csp work among threads.
+ *
+ * The image is split into tiles processed by sp::scheduling::TileScheduler:
+ * threads steal tiles from each other,
+ * and a tile is swept again only if it or its neighbor
+ * lost nodes during the previous sweep.
+ */
+struct CspSchedule
+{
+    /**
+     * \brief Number of threads, zero to let OpenMP choose it.
+     */
+    ULONG threads;
+    /**
+     * \brief Number of columns in a tile.
+     */
+    ULONG tile_width;
+    /**
+     * \brief Number of rows in a tile.
+     */
+    ULONG tile_height;
+};
+/**
+ * \brief Default width of tiles of sp::graph::constraint::CspSchedule.
+ */
+const ULONG CSP_TILE_WIDTH = 32;
+/**
+ * \brief Default height of tiles of sp::graph::constraint::CspSchedule.
+ */
+const ULONG CSP_TILE_HEIGHT = 8;
+/**
+ * \brief Remove all nodes that don't belong to any soluton
+ * using specified schedule.
+ *
+ * The result doesn't depend on the schedule.
+ */
+BOOL solve_csp(
+    struct ConstraintGraph* graph,
+    const struct CspSchedule* schedule
+);
+#endif
 /**
  * \brief Check whether at least one node is available.
  */
 __device__ BOOL check_nodes_left(const struct ConstraintGraph* graph);
+/**
+ * \brief Check whether at least one node of the pixel is available.
+ */
+__device__ BOOL check_pixel_nodes_left(
+    const struct ConstraintGraph* graph,
+    struct Pixel pixel
+);
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
 }
@@ -0,0 +1,181 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef COUNTERS_HPP
+#define COUNTERS_HPP
+
+#include <types.hpp>
+
+/**
+ * \brief Add `value` to the counter of the current thread.
+ *
+ * Counters are compiled in only if `USE_COUNTERS` is defined
+ * (`WITH_COUNTERS` option of CMake).
+ * Otherwise, and on GPU, the macro expands to nothing.
+ */
+#if defined(USE_COUNTERS) \
+    && !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+#define COUNT(counter, value) \
+    (sp::counters::increment(sp::counters::counter, (value)))
+#else
+#define COUNT(counter, value)
+#endif
+
+#if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+/**
+ * \brief Counters of work done by CSP and labeling engines.
+ *
+ * Each thread increments its own cache line aligned copy of counters,
+ * so there is no contention between threads.
+ * Copies are summed up on sp::counters::collect_counters.
+ */
+namespace sp::counters
+{
+
+using sp::types::BOOL;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+/**
+ * \brief Kinds of counted events.
+ */
+enum Counter : ULONG
+{
+    /**
+     * \brief Sweeps over the image made by sp::graph::constraint::solve_csp.
+     */
+    CSP_SWEEPS,
+    /**
+     * \brief Available nodes checked for removal.
+     */
+    NODES_EXAMINED,
+    /**
+     * \brief Nodes removed as inconsistent.
+     */
+    NODES_REMOVED,
+    /**
+     * \brief Checks whether an edge supports a node.
+     */
+    EDGE_CHECKS,
+    /**
+     * \brief Searches for support stopped at the first found edge
+     * and scans stopped at the first pixel without nodes.
+     */
+    EARLY_BREAKS,
+    /**
+     * \brief Pixels found without available nodes.
+     */
+    COLLAPSED_PIXELS,
+    /**
+     * \brief Nodes chosen by sp::labeling::finder::choose_best_node.
+     */
+    CHOSEN_NODES,
+    /**
+     * \brief Number of counters.
+     */
+    COUNTERS_COUNT
+};
+
+/**
+ * \brief Names of counters to use in reports.
+ */
+const char* const COUNTER_NAMES[COUNTERS_COUNT] = {
+    "csp_sweeps",
+    "nodes_examined",
+    "nodes_removed",
+    "edge_checks",
+    "early_breaks",
+    "collapsed_pixels",
+    "chosen_nodes",
+};
+
+/**
+ * \brief Counters of one thread placed in their own cache line.
+ */
+struct alignas(64) ThreadCounters
+{
+    /**
+     * \brief Values of counters indexed by sp::counters::Counter.
+     */
+    ULONG values[COUNTERS_COUNT];
+};
+
+/**
+ * \brief Counters of the current thread.
+ *
+ * Null until the thread increments a counter for the first time.
+ */
+inline thread_local struct ThreadCounters* thread_counters = nullptr;
+
+/**
+ * \brief Allocate counters for the current thread
+ * and register them for sp::counters::collect_counters.
+ */
+struct ThreadCounters* register_thread_counters();
+
+/**
+ * \brief Add `value` to the counter of the current thread.
+ */
+inline void increment(Counter counter, ULONG value)
+{
+    if (thread_counters == nullptr)
+    {
+        thread_counters = register_thread_counters();
+    }
+    thread_counters->values[counter] += value;
+}
+
+/**
+ * \brief Check whether counters were compiled in.
+ */
+constexpr BOOL counters_enabled()
+{
+    #ifdef USE_COUNTERS
+    return true;
+    #else
+    return false;
+    #endif
+}
+
+/**
+ * \brief Sum counters of all threads.
+ *
+ * Should be called when counted work is finished,
+ * values being incremented concurrently may be inaccurate.
+ *
+ * @return
+ *  Values indexed by sp::counters::Counter.
+ */
+ULONG_ARRAY collect_counters();
+
+/**
+ * \brief Set counters of all threads to zero.
+ *
+ * Should be called when no counted work is running.
+ */
+void reset_counters();
+
+}
+#endif
+
+#endif
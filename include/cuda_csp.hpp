@@ -46,8 +46,8 @@ struct CUDAProblem
     float* reparametrization;
     int* changed;
     int* nodes_availability;
-    unsigned* left_image;
-    unsigned* right_image;
+    unsigned short* left_image;
+    unsigned short* right_image;
 };
 
 /**
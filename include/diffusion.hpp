@@ -0,0 +1,160 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DIFFUSION_HPP
+#define DIFFUSION_HPP
+
+#include <disparity_graph.hpp>
+#include <types.hpp>
+
+/**
+ * \brief Reparametrization of sp::graph::disparity::DisparityGraph
+ * by the diffusion (min-sum) algorithm.
+ *
+ * \section diffusion-step Step of diffusion
+ *
+ * Diffusion takes a pixel \f$i\f$ and equalizes
+ * its reparametrized vertex penalty
+ * with the lowest penalties of its edges
+ *
+ * \f[
+ *  m_{ij}\left( d; \varphi \right)
+ *  = \min\limits_{d' \in D}{g_{ij}\left( d, d'; \varphi \right)},
+ *  \quad j \in \mathcal{N}_i.
+ * \f]
+ *
+ * Denoting their mean value
+ *
+ * \f[
+ *  \mu_i\left( d; \varphi \right)
+ *  = \frac{1}{\left| \mathcal{N}_i \right| + 1} \left[
+ *      q_i\left( d; \varphi \right)
+ *      + \sum\limits_{j \in \mathcal{N}_i}
+ *          m_{ij}\left( d; \varphi \right)
+ *  \right],
+ * \f]
+ *
+ * the step updates
+ *
+ * \f[
+ *  \varphi_{ij}\left( d \right)
+ *  \leftarrow \varphi_{ij}\left( d \right)
+ *      + m_{ij}\left( d; \varphi \right)
+ *      - \mu_i\left( d; \varphi \right),
+ *  \quad j \in \mathcal{N}_i,
+ *  \quad d \in D,
+ * \f]
+ *
+ * so all the values become equal to \f$\mu_i\f$.
+ * The step doesn't change energy of any labeling
+ * and never decreases the lower bound
+ * \f$\widetilde{E}\left( \varphi \right)\f$
+ * described in sp::graph::disparity::DisparityGraph.
+ *
+ * \section diffusion-parallel Parallel processing
+ *
+ * The step for the pixel \f$i\f$ changes only
+ * \f$\varphi_{i \cdot}\f$
+ * and reads \f$\varphi_{j \cdot}\f$ of neighbors.
+ * Pixels are colored as a chessboard,
+ * and pixels of one color don't neighbor each other,
+ * so all of them are processed in parallel.
+ * One iteration processes black pixels first
+ * and white pixels after them.
+ */
+namespace sp::graph::diffusion
+{
+
+using sp::graph::disparity::DisparityGraph;
+using sp::types::FLOAT;
+using sp::types::Node;
+using sp::types::Pixel;
+using sp::types::ULONG;
+
+/**
+ * \brief Calculate the lowest penalty among edges
+ * that connect the Node with nodes of its neighbor.
+ *
+ * \f$m_{ij}\left( d; \varphi \right)\f$ in formulas
+ * of the module description.
+ *
+ * @return
+ *  Positive infinity if there are no such edges.
+ */
+FLOAT calculate_lowest_edge_penalty(
+    const struct DisparityGraph* graph,
+    struct Node node,
+    ULONG neighbor_index
+);
+/**
+ * \brief Perform diffusion step for each node of the Pixel.
+ *
+ * Updates cached node penalties of the Pixel
+ * if sp::graph::disparity::cache_node_penalties was called.
+ *
+ * @return
+ *  Maximal absolute change of reparametrization elements.
+ */
+FLOAT diffusion_process_pixel(
+    struct DisparityGraph* graph,
+    struct Pixel pixel
+);
+/**
+ * \brief Process all pixels of one color
+ * (parity of sum of coordinates).
+ *
+ * @return
+ *  Maximal absolute change of reparametrization elements.
+ */
+FLOAT diffusion_process_color(struct DisparityGraph* graph, ULONG color);
+/**
+ * \brief Process pixels of both colors one after another.
+ *
+ * @return
+ *  Maximal absolute change of reparametrization elements.
+ */
+FLOAT diffusion_iteration(struct DisparityGraph* graph);
+/**
+ * \brief Run diffusion iterations
+ * until their number reaches `max_iterations`
+ * or reparametrization converges:
+ * no element changes more than by `tolerance`.
+ *
+ * @return
+ *  Number of performed iterations.
+ */
+ULONG diffusion(
+    struct DisparityGraph* graph,
+    ULONG max_iterations,
+    FLOAT tolerance
+);
+/**
+ * \brief Calculate the lower bound
+ * \f$\widetilde{E}\left( \varphi \right)\f$
+ * of energy of labelings.
+ */
+FLOAT calculate_lower_bound(const struct DisparityGraph* graph);
+
+}
+
+#endif
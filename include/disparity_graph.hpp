@@ -45,7 +45,9 @@ using sp::types::Edge;
 using sp::types::FLOAT;
 using sp::types::FLOAT_ARRAY;
 using sp::types::Node;
+using sp::types::Pixel;
 using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
 
 /**
  * \brief Maximal number of neighbors of each vertex of disparity graph.
@@ -331,11 +333,14 @@ struct DisparityGraph
      * and find finer disparity map using
      * sp::graph::disparity::DisparityGraph::disparity_levels disparity values.
      *
-     * For now,
-     * we assume the minimal disparity for each pixel to be equal `0`,
+     * By default,
+     * the minimal disparity for each pixel is equal `0`,
      * so the sp::graph::disparity::DisparityGraph::disparity_levels is used as
      * \f$\max{D} - 1\f$ in set of available disparities
      * \f$D = \left\{ 0, 1, \dots, \max{D} - 1 \right\}\f$.
+     * On CPU the minimal disparity of each pixel
+     * can be set in
+     * sp::graph::disparity::DisparityGraph::minimal_disparities.
      */
     ULONG disparity_levels;
     /**
@@ -359,10 +364,10 @@ struct DisparityGraph
      *
      * Used "dimensions" are following (upper ones are more nested):
      *
-     * - Pixel::y of Node::pixel,
      * - Node::disparity,
      * - Index of current neighbor of Node instance,
-     * - Pixel::x of Node::pixel
+     * - Pixel::x of Node::pixel,
+     * - Pixel::y of Node::pixel
      *
      * Index of an element
      * of the sp::graph::disparity::DisparityGraph::reparametrization
@@ -371,10 +376,9 @@ struct DisparityGraph
      *
      * \f[
      *  k\left( \left\langle x, y \right\rangle, i, d \right) =
-     *      y + h \cdot \left(
-     *          d + \left| D \right| \cdot \left(
-     *              i + \max_j{\left| \mathcal{N}_j \right|} \cdot x \cdot w
-     *              \right)
+     *      d + \left| D \right| \cdot \left(
+     *          i + \max_j{\left| \mathcal{N}_j \right|}
+     *              \cdot \left( x + w \cdot y \right)
      *          \right),
      * \f]
      *
@@ -407,10 +411,55 @@ struct DisparityGraph
      * sp::graph::disparity::DisparityGraph::cleanness.
      */
     FLOAT smoothness;
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    /**
+     * \brief Optional cache of penalties of all nodes (cost volume).
+     *
+     * Empty by default.
+     * When filled by sp::graph::disparity::cache_node_penalties,
+     * sp::graph::disparity::node_penalty reads values from here
+     * instead of recalculating them.
+     * Index of a Node is calculated by sp::indexing::node_index,
+     * so the cache has the same layout as
+     * sp::graph::constraint::ConstraintGraph::nodes_availability.
+     *
+     * The cache knows nothing about changes of
+     * sp::graph::disparity::DisparityGraph::reparametrization.
+     * If you change it,
+     * call sp::graph::disparity::update_cached_node_penalties
+     * for each changed pixel
+     * or drop the cache by sp::graph::disparity::drop_cached_node_penalties.
+     */
+    FLOAT_ARRAY node_penalties;
+    /**
+     * \brief Optional minimal disparity of each pixel.
+     *
+     * Empty by default, which means zero for all pixels.
+     * Otherwise, Node::disparity \f$d\f$ of a pixel
+     * stands for the disparity \f$m + d\f$,
+     * where \f$m\f$ is the element of the array for the pixel
+     * (pixels are stored in row-major order),
+     * so each pixel has its own window
+     * of sp::graph::disparity::DisparityGraph::disparity_levels disparities.
+     * Penalties and existence of nodes and edges
+     * are calculated by the actual disparities
+     * (see sp::indexing::node_disparity),
+     * while all arrays are indexed by Node::disparity,
+     * so their size depends on the width of windows only.
+     *
+     * Should be set by sp::graph::disparity::set_minimal_disparities.
+     */
+    ULONG_ARRAY minimal_disparities;
+    #endif
     /**
      * \brief Create sp::graph::disparity::DisparityGraph entity
      * and initialize its
      * sp::graph::disparity::DisparityGraph::reparametrization.
+     *
+     * Memory of `storage` is reused for the reparametrization,
+     * so a graph of the same or smaller size
+     * can be created without allocations
+     * from the reparametrization of the previous one.
      */
     #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
     DisparityGraph() = default;
@@ -419,7 +468,8 @@ struct DisparityGraph
         struct Image right,
         ULONG disparity_levels,
         FLOAT cleanness,
-        FLOAT smoothness
+        FLOAT smoothness,
+        FLOAT_ARRAY storage = {}
     );
     #endif
 };
@@ -446,8 +496,87 @@ __device__ FLOAT edge_penalty(const struct DisparityGraph* graph, struct Edge ed
  *
  * Otherwise, the penalty is a norm of a difference
  * between disparities of Node instances that the Edge connects.
+ *
+ * On CPU the value is taken from
+ * sp::graph::disparity::DisparityGraph::node_penalties if it's cached.
  */
 __device__ FLOAT node_penalty(const struct DisparityGraph* graph, struct Node node);
+/**
+ * \brief Calculate penalty of Node ignoring the cache.
+ *
+ * Does the same as sp::graph::disparity::node_penalty,
+ * but always computes the value from images and reparametrization.
+ */
+__device__ FLOAT calculate_node_penalty(
+    const struct DisparityGraph* graph,
+    struct Node node
+);
+
+#if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+/**
+ * \brief Fill sp::graph::disparity::DisparityGraph::node_penalties
+ * with penalties of all existing nodes.
+ *
+ * Rows are processed in parallel if OpenMP is available.
+ */
+void cache_node_penalties(struct DisparityGraph* graph);
+/**
+ * \brief Recalculate cached penalties of all nodes of the pixel.
+ *
+ * Should be called after a change of
+ * sp::graph::disparity::DisparityGraph::reparametrization
+ * of the pixel.
+ * Does nothing if the cache is empty.
+ */
+void update_cached_node_penalties(
+    struct DisparityGraph* graph,
+    struct Pixel pixel
+);
+/**
+ * \brief Clear sp::graph::disparity::DisparityGraph::node_penalties,
+ * so penalties will be calculated on each request.
+ */
+void drop_cached_node_penalties(struct DisparityGraph* graph);
+/**
+ * \brief Set windows of disparities of pixels.
+ *
+ * Replaces sp::graph::disparity::DisparityGraph::minimal_disparities
+ * and recalculates sp::graph::disparity::DisparityGraph::node_penalties
+ * if they are cached.
+ * An empty array removes windows.
+ *
+ * Throws `std::invalid_argument` if the number of values
+ * differs from the number of pixels,
+ * or a window of a pixel doesn't contain any existing disparity.
+ */
+void set_minimal_disparities(
+    struct DisparityGraph* graph,
+    ULONG_ARRAY minimal_disparities
+);
+/**
+ * \brief Number of existing nodes of the pixel.
+ *
+ * Nodes with disparities from zero to the result (exclusive) exist.
+ */
+ULONG pixel_disparities(const struct DisparityGraph* graph, struct Pixel pixel);
+/**
+ * \brief Penalties of all existing nodes of the pixel (cost row).
+ *
+ * Element `d` of the result is the penalty of the node with disparity `d`,
+ * the same as sp::graph::disparity::node_penalty returns.
+ * If sp::graph::disparity::DisparityGraph::node_penalties is filled,
+ * a pointer to the cached row is returned.
+ * Otherwise penalties are calculated into `buffer` at once:
+ * the kernel is vectorized over disparities
+ * and compiled for several instruction sets on x86,
+ * the best one is chosen at runtime.
+ */
+const FLOAT* pixel_node_penalties(
+    const struct DisparityGraph* graph,
+    struct Pixel pixel,
+    FLOAT_ARRAY* buffer
+);
+#endif
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
 }
@@ -38,8 +38,8 @@ struct Problem
 {
     program program;
     command_queue queue;
-    compute::vector<cl_ulong> left_image;
-    compute::vector<cl_ulong> right_image;
+    compute::vector<cl_ushort> left_image;
+    compute::vector<cl_ushort> right_image;
     compute::vector<cl_float> min_penalties_pixels;
     compute::vector<cl_float> min_penalties_edges;
     compute::vector<cl_float> reparametrization;
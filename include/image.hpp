@@ -27,6 +27,11 @@
 #include <types.hpp>
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+#include <cstdint>
+#include <initializer_list>
+#include <variant>
+#include <vector>
+
 /**
  * \brief Image processing utilities.
  */
@@ -38,6 +43,187 @@ namespace image
 using sp::types::BOOL;
 using sp::types::ULONG;
 using sp::types::ULONG_ARRAY;
+
+/**
+ * \brief Intensities of an image stored in the narrowest unsigned type
+ * that can hold them: one byte, two bytes, or sp::types::ULONG.
+ *
+ * 8-bit images take one byte per pixel instead of eight,
+ * which reduces memory traffic of penalty calculations.
+ * Values are read and written as sp::types::ULONG;
+ * writing a value that doesn't fit widens the storage.
+ * Performance-critical code should use sp::image::Pixels::visit
+ * to get a pointer of the actual type and be specialized for it.
+ */
+class Pixels
+{
+public:
+    /**
+     * \brief Proxy to write intensities with `data[index] = value`.
+     */
+    class Reference
+    {
+    private:
+        /**
+         * \brief Storage that contains the intensity.
+         */
+        Pixels* pixels;
+        /**
+         * \brief Index of the intensity.
+         */
+        ULONG index;
+    public:
+        /**
+         * \brief Reference to the intensity with specified index.
+         */
+        Reference(Pixels* pixels, ULONG index);
+        /**
+         * \brief Read the intensity.
+         */
+        operator ULONG() const;
+        /**
+         * \brief Write the intensity.
+         */
+        Reference& operator=(ULONG value);
+        /**
+         * \brief Copy an intensity, not the reference.
+         */
+        Reference& operator=(const Reference& other);
+    };
+
+    /**
+     * \brief Empty storage.
+     */
+    Pixels() = default;
+    /**
+     * \brief Storage of listed intensities.
+     */
+    Pixels(std::initializer_list<ULONG> values);
+    /**
+     * \brief Storage of intensities contained in the array.
+     */
+    Pixels(const ULONG_ARRAY& values);
+    /**
+     * \brief Storage of `size` zero intensities
+     * that can hold values up to `max_value` without widening.
+     */
+    Pixels(ULONG size, ULONG max_value);
+
+    /**
+     * \brief Number of intensities.
+     */
+    ULONG size() const;
+    /**
+     * \brief Number of bytes occupied by one intensity.
+     */
+    ULONG bytes_per_pixel() const;
+    /**
+     * \brief Read the intensity with specified index.
+     */
+    ULONG operator[](ULONG index) const
+    {
+        switch (this->values.index())
+        {
+        case 0:
+            return (*std::get_if<0>(&this->values))[index];
+        case 1:
+            return (*std::get_if<1>(&this->values))[index];
+        default:
+            return (*std::get_if<2>(&this->values))[index];
+        }
+    }
+    /**
+     * \brief Access the intensity with specified index for writing.
+     */
+    Reference operator[](ULONG index);
+    /**
+     * \brief Write the intensity with specified index.
+     */
+    void set(ULONG index, ULONG value);
+    /**
+     * \brief Copy intensities to an array of specified type.
+     */
+    template <typename T = ULONG>
+    std::vector<T> to_vector() const
+    {
+        return std::visit(
+            [](const auto& values)
+            {
+                return std::vector<T>(values.begin(), values.end());
+            },
+            this->values
+        );
+    }
+    /**
+     * \brief Call `visitor` with a pointer to the first intensity
+     * of the actual type.
+     */
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor) const
+    {
+        return std::visit(
+            [&visitor](const auto& values) -> decltype(auto)
+            {
+                return visitor(values.data());
+            },
+            this->values
+        );
+    }
+    /**
+     * \brief Call `visitor` with a pointer to the first intensity
+     * of the actual type to write intensities without widening.
+     */
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor)
+    {
+        return std::visit(
+            [&visitor](auto& values) -> decltype(auto)
+            {
+                return visitor(values.data());
+            },
+            this->values
+        );
+    }
+    /**
+     * \brief Compare intensities regardless of their storage.
+     */
+    friend bool operator==(const Pixels& lhs, const Pixels& rhs);
+    /**
+     * \brief Compare intensities regardless of their storage.
+     */
+    friend bool operator!=(const Pixels& lhs, const Pixels& rhs);
+private:
+    /**
+     * \brief Intensities in one of supported types.
+     */
+    std::variant<
+        std::vector<std::uint8_t>,
+        std::vector<std::uint16_t>,
+        std::vector<ULONG>
+    > values;
+    /**
+     * \brief Change type of the storage to hold `max_value`.
+     */
+    void widen(ULONG max_value);
+};
+#endif
+
+#if defined(__OPENCL_C_VERSION__)
+#define PIXEL ushort
+#define PIXEL_ARRAY PIXEL*
+#elif defined(__CUDA_ARCH__)
+using PIXEL = unsigned short;
+using PIXEL_ARRAY = PIXEL*;
+#else
+/**
+ * \brief Type of intensities uploaded to GPU.
+ */
+using PIXEL = std::uint16_t;
+/**
+ * \brief Array of intensities
+ * to use the same name on CPU and GPU.
+ */
+using PIXEL_ARRAY = Pixels;
 #endif
 
 /**
@@ -79,8 +265,11 @@ struct Image
      *      a_{1 0} & a_{1 1}
      *  \end{bmatrix}
      * \f]
+     *
+     * On CPU intensities are stored in sp::image::Pixels,
+     * on GPU they are sp::image::PIXEL.
      */
-    __global ULONG_ARRAY data;
+    __global PIXEL_ARRAY data;
 };
 
 /**
@@ -32,6 +32,15 @@
 /**
  * \brief Functions for getting access to arrays
  * by abstract indices like sp::types::Pixels, sp::types::Nodes, etc.
+ *
+ * All arrays share the same row-major layout of pixels
+ * described by sp::indexing::nodes_pixel_index,
+ * and everything that belongs to a pixel
+ * (nodes, neighborhoods, reparametrization)
+ * is stored contiguously after it.
+ * Loops over pixels should go row by row (`y` outside, `x` inside)
+ * to walk memory sequentially,
+ * and GPU kernels should map consecutive threads to consecutive columns.
  */
 namespace sp
 {
@@ -55,7 +64,7 @@ using sp::types::ULONG;
  * That's why the function for coordinates' conversion is needed.
  *
  * Result of accessing non-existent value
- * depends on sp::types::ULONG_ARRAY.
+ * depends on sp::image::PIXEL_ARRAY.
  */
 __device__ ULONG pixel_index(const struct Image* image, struct Pixel pixel);
 
@@ -71,6 +80,10 @@ __device__ ULONG pixel_value(const struct Image* image, struct Pixel pixel);
  * \brief Get an index of sp::graph::disparity::DisparityGraph::reparametrization element
  * using a Node and an index of its neighbor.
  *
+ * Index is \f$d + \left| D \right| \cdot \left( k + 4 p \right)\f$,
+ * where \f$k\f$ is the index of the neighbor
+ * and \f$p\f$ is a result of sp::indexing::nodes_pixel_index.
+ *
  * The function doesn't check existence of neighbor.
  * You should perform it by yourself
  * using sp::indexing::checks::neighborhood_exists.
@@ -170,6 +183,46 @@ __device__ ULONG neighbor_index(
     struct Pixel neighbor
 );
 
+/**
+ * \brief Get an index of a pixel in arrays that store
+ * all nodes of a pixel together, like
+ * sp::graph::constraint::ConstraintGraph::nodes_availability.
+ *
+ * Pixels are stored in row-major order
+ * like in sp::image::Image::data, i.e. \f$x + w \cdot y\f$.
+ *
+ * Index of a Node is
+ * \f$d + \left| D \right| \cdot k\f$,
+ * where \f$k\f$ is a result of this function.
+ */
+__device__ ULONG nodes_pixel_index(
+    const struct DisparityGraph* graph,
+    struct Pixel pixel
+);
+
+/**
+ * \brief Minimal disparity of the pixel.
+ *
+ * Taken from sp::graph::disparity::DisparityGraph::minimal_disparities
+ * if they are set (only on CPU), zero otherwise.
+ */
+__device__ ULONG minimal_disparity(
+    const struct DisparityGraph* graph,
+    struct Pixel pixel
+);
+
+/**
+ * \brief Actual disparity of the Node,
+ * i.e. Node::disparity shifted by the minimal disparity of its pixel.
+ *
+ * Should be used to calculate penalties and check existence,
+ * while Node::disparity is used to index arrays.
+ */
+__device__ ULONG node_disparity(
+    const struct DisparityGraph* graph,
+    struct Node node
+);
+
 /**
  * \brief Get an index of sp::graph::constraint::ConstraintGraph::nodes_availability element
  * using a Node.
@@ -184,6 +237,10 @@ __device__ ULONG node_index(const struct DisparityGraph* graph, struct Node node
  * \brief Get index of a neighborhood in
  * sp::graph::lowest_penalties::LowestPenalties::neighborhoods.
  *
+ * Index is \f$k + 4 p\f$,
+ * where \f$k\f$ is the index of the neighbor
+ * and \f$p\f$ is a result of sp::indexing::nodes_pixel_index.
+ *
  * Note that the function doesn't check existence of provided neighborhood.
  * Use sp::indexing::checks::neighborhood_exists_fast to make sure that you use it right.
  */
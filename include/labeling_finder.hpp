@@ -31,6 +31,13 @@
 #include <types.hpp>
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+#ifdef USE_OPENCL
+namespace gpu
+{
+struct Problem;
+}
+#endif
+
 /**
  * \brief Functions to find a consistent labeling.
  */
@@ -41,14 +48,93 @@ namespace labeling
 namespace finder
 {
 
+using sp::graph::availability::NodesAvailability;
 using sp::graph::constraint::ConstraintGraph;
 using sp::graph::disparity::DisparityGraph;
 using sp::graph::lowest_penalties::LowestPenalties;
 using sp::image::Image;
+using sp::types::BOOL;
 using sp::types::Edge;
 using sp::types::FLOAT;
 using sp::types::FLOAT_ARRAY;
 using sp::types::Pixel;
+using sp::types::ULONG;
+
+/**
+ * \brief Number of collected penalties
+ * after which a thread squeezes its buffer
+ * in sp::labeling::finder::fetch_available_penalties.
+ */
+const ULONG PENALTIES_CHUNK_SIZE = 1 << 16;
+/**
+ * \brief Number of bins of the histogram of penalties
+ * used by the first stage of
+ * sp::labeling::finder::calculate_approximate_consistent_threshold.
+ */
+const ULONG APPROXIMATE_THRESHOLD_BINS = 64;
+
+/**
+ * \brief State shared between probes of a threshold search.
+ *
+ * Availability of nodes is monotone in the threshold:
+ * the set of nodes left by CSP solution for a threshold \f$t'\f$
+ * is a subset of the set left for any \f$t \ge t'\f$.
+ * So a probe below the last consistent threshold
+ * may start from the nodes left by that probe,
+ * filtered by the slack of each node
+ * (difference between its penalty and the lowest penalty of its pixel),
+ * and get the same result as from scratch
+ * doing less work.
+ * Slacks are calculated once,
+ * so sp::graph::disparity::node_penalty isn't called by probes.
+ */
+struct ThresholdSearch
+{
+    /**
+     * \brief Graph being searched.
+     */
+    const struct DisparityGraph* disparity_graph;
+    /**
+     * \brief Lowest penalties of the graph.
+     */
+    const struct LowestPenalties* lowest_penalties;
+    /**
+     * \brief Slack of each node indexed by sp::indexing::node_index.
+     *
+     * Nonexistent nodes have infinite slack.
+     */
+    FLOAT_ARRAY nodes_slacks;
+    /**
+     * \brief Nodes left by the last consistent probe.
+     *
+     * Empty if no probe was consistent yet.
+     */
+    NodesAvailability consistent_nodes;
+    /**
+     * \brief Number of thresholds probed.
+     */
+    ULONG probes;
+    /**
+     * \brief Calculate slacks of all nodes.
+     */
+    ThresholdSearch(
+        const struct DisparityGraph* disparity_graph,
+        const struct LowestPenalties* lowest_penalties
+    );
+};
+/**
+ * \brief Check whether CSP is solvable for the threshold.
+ *
+ * Initial nodes are taken from
+ * sp::labeling::finder::ThresholdSearch::consistent_nodes
+ * if any probe was consistent,
+ * and CSP is solved with sp::graph::arc_consistency::solve_csp_worklist.
+ * If the problem is solvable,
+ * left nodes replace sp::labeling::finder::ThresholdSearch::consistent_nodes.
+ *
+ * The threshold shouldn't exceed thresholds of previous consistent probes.
+ */
+BOOL probe_threshold(struct ThresholdSearch* search, FLOAT threshold);
 #endif
 
 /**
@@ -73,15 +159,41 @@ __device__ FLOAT_ARRAY fetch_edge_available_penalties(
     struct Edge edge,
     FLOAT minimal_penalty
 );
+/**
+ * \brief Sort the array in ascending order and remove duplicates.
+ */
+__device__ void squeeze_available_penalties(FLOAT_ARRAY* penalties);
 /**
  * \brief Construct an array of available differences
  * gathered from all pixels via sp::labeling::finder::fetch_pixel_available_penalties
  * and from all neighbors via sp::labeling::finder::fetch_edge_available_penalties.
  * The output is sorted in ascending order.
+ *
+ * Each thread appends penalties of its rows to its own buffer
+ * and squeezes it with sp::labeling::finder::squeeze_available_penalties
+ * only when the buffer has grown twice
+ * (by at least sp::labeling::finder::PENALTIES_CHUNK_SIZE elements).
+ * Sorted buffers are merged pairwise in parallel at the end.
  */
 __device__ FLOAT_ARRAY fetch_available_penalties(
     const struct LowestPenalties* lowest_penalties
 );
+/**
+ * \brief Reduce sorted available penalties to a histogram.
+ *
+ * Range of penalties is split into `bins` bins of equal width,
+ * and only the largest penalty of each nonempty bin is kept.
+ * Kept values are still available penalties,
+ * and the threshold found among them
+ * exceeds the minimal one not more than by the width of a bin.
+ *
+ * If `bins` is zero or not less than the number of penalties,
+ * the array is returned as is.
+ */
+__device__ FLOAT_ARRAY quantize_available_penalties(
+    FLOAT_ARRAY available_penalties,
+    ULONG bins
+);
 /**
  * \brief Calculate the minimal threshold
  * for sp::graph::constraint::ConstraintGraph to have a solution.
@@ -126,12 +238,67 @@ __device__ FLOAT_ARRAY fetch_available_penalties(
  *
  * This allows us to execute sp::graph::constraint::solve_csp
  * not more than \f$ \left[ \log_2 \ell + 1 \right] \f$ times.
+ *
+ * Probes are made with sp::labeling::finder::probe_threshold,
+ * so each probe starts from nodes left by the last consistent one.
  */
 __device__ FLOAT calculate_minimal_consistent_threshold(
     const struct LowestPenalties* lowest_penalties,
     const struct DisparityGraph* disparity_graph,
     FLOAT_ARRAY available_penalties
 );
+#if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+/**
+ * \brief Search the minimal consistent threshold
+ * with a given sp::labeling::finder::ThresholdSearch,
+ * so its state (e.g., number of probes) can be inspected afterwards.
+ */
+FLOAT calculate_minimal_consistent_threshold(
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties
+);
+#endif
+/**
+ * \brief Calculate a threshold that exceeds the minimal one
+ * for sp::graph::constraint::ConstraintGraph to have a solution
+ * not more than by `tolerance`.
+ *
+ * sp::labeling::finder::calculate_minimal_consistent_threshold
+ * needs a CSP solution for each halving of the whole array of penalties,
+ * which may contain millions of values.
+ * Here the search goes in two stages:
+ *
+ *   -# Search over the histogram of penalties
+ *   built by sp::labeling::finder::quantize_available_penalties
+ *   with sp::labeling::finder::APPROXIMATE_THRESHOLD_BINS bins.
+ *   This gives a bracket between the largest penalty of an inconsistent bin
+ *   and the largest penalty of the first consistent one.
+ *   -# Binary search over penalties inside the bracket,
+ *   that stops as soon as the difference
+ *   between the known consistent threshold
+ *   and the largest known inconsistent one
+ *   doesn't exceed `tolerance`.
+ *
+ * Zero `tolerance` gives the same result as
+ * sp::labeling::finder::calculate_minimal_consistent_threshold.
+ */
+__device__ FLOAT calculate_approximate_consistent_threshold(
+    const struct LowestPenalties* lowest_penalties,
+    const struct DisparityGraph* disparity_graph,
+    FLOAT_ARRAY available_penalties,
+    FLOAT tolerance
+);
+#if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+/**
+ * \brief Search an approximate consistent threshold
+ * with a given sp::labeling::finder::ThresholdSearch.
+ */
+FLOAT calculate_approximate_consistent_threshold(
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties,
+    FLOAT tolerance
+);
+#endif
 /**
  * \brief Leave only the best available node in the pixel.
  * Remove all other nodes
@@ -153,6 +320,19 @@ __device__ struct ConstraintGraph* choose_best_node(
 struct ConstraintGraph* find_labeling_cl(
     struct ConstraintGraph* graph
 );
+#ifdef USE_OPENCL
+/**
+ * \brief Find a labeling using OpenCL
+ * with the program and buffers kept in `problem`.
+ *
+ * The program is built by the first call only,
+ * so it's reused when many graphs are processed one by one.
+ */
+struct ConstraintGraph* find_labeling_cl(
+    struct ConstraintGraph* graph,
+    struct gpu::Problem* problem
+);
+#endif
 struct ConstraintGraph* find_labeling_cuda(
     struct ConstraintGraph* graph
 );
@@ -165,9 +345,13 @@ struct ConstraintGraph* find_labeling_cuda(
  * For each pixel
  *
  *   - execute sp::labeling::finder::choose_best_node to use the best node;
- *   - run sp::graph::constraint::solve_csp for the graph
+ *   - run sp::graph::arc_consistency::propagate_from for the pixel
  *   to remove inconsistent nodes and edges.
  *
+ * Support counters are built once,
+ * so each step costs only as much as its removals cascade,
+ * instead of a full sp::graph::constraint::solve_csp over the image.
+ *
  * As the result,
  * we will have a graph,
  * where the maximal deviation
@@ -175,6 +359,29 @@ struct ConstraintGraph* find_labeling_cuda(
  * will be minimal.
  */
 __device__ struct ConstraintGraph* find_labeling(struct ConstraintGraph* graph);
+#if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+/**
+ * \brief Find a labeling like sp::labeling::finder::find_labeling,
+ * raising the threshold if the search fails.
+ *
+ * Without reparametrization,
+ * arc consistency of the CSP guarantees that a labeling is found.
+ * Penalties changed by sp::graph::diffusion::diffusion
+ * may break this guarantee,
+ * so the threshold is taken from `available_penalties`
+ * with exponentially growing steps
+ * until a labeling is found.
+ * The maximal available penalty makes all nodes and edges available,
+ * so the search fails only if `available_penalties` are incomplete.
+ *
+ * On success `graph` is replaced by the labeled one
+ * together with the used threshold.
+ */
+struct ConstraintGraph* find_labeling_relaxed(
+    struct ConstraintGraph* graph,
+    const FLOAT_ARRAY& available_penalties
+);
+#endif
 /**
  * \brief Build a disparity map by the constraint graph.
  *
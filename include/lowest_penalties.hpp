@@ -87,10 +87,10 @@ struct LowestPenalties
     /**
      * \brief Minimal penalties of nodes per pixels.
      *
-     * Column-major order is used, so the index is calculated by the formula
+     * Row-major order is used, so the index is calculated by the formula
      *
      * \f[
-     *  k\left( \left\langle x, y \right\rangle \right) = y + h \cdot x.
+     *  k\left( \left\langle x, y \right\rangle \right) = x + w \cdot y.
      * \f]
      */
     __global FLOAT_ARRAY pixels;
@@ -102,7 +102,7 @@ struct LowestPenalties
      * \f[
      *  k\left( \left\langle x, y \right\rangle, i \right)
      *  = i + \max\limits_j{\left| \mathcal{N}_j \right|}
-     *      \cdot \left( y + h \cdot x \right),
+     *      \cdot \left( x + w \cdot y \right),
      * \f]
      *
      * where \f$i\f$ is an index of the neighbor,
@@ -148,6 +148,14 @@ __device__ FLOAT calculate_lowest_neighborhood_penalty(
 /**
  * \brief Calculate minimal penalty among edges of a neighborhood.
  *
+ * On CPU takes linear time in the number of disparities:
+ * for each disparity of the neighbor the best disparity of the node
+ * is taken from the lower envelope of parabolas
+ * \f$s \left( \delta - \delta' \right)^2 - \varphi\left( \delta \right)\f$,
+ * and the penalty of the best edge is calculated by
+ * sp::graph::disparity::edge_penalty.
+ * On GPU all pairs of disparities are checked.
+ *
  * Note that the function doesn't check existence of provided neighborhood.
  * Use sp::indexing::checks::neighborhood_exists_fast to make sure that you use it right.
  */
@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Read-only access to contents of files.
+ */
+namespace sp::image
+{
+
+/**
+ * \brief Read-only file mapped to memory.
+ *
+ * On POSIX systems the file is mapped with `mmap`,
+ * so pages are loaded on demand and nothing is copied.
+ * On other systems the file is read into a buffer.
+ *
+ * Throws `std::invalid_argument` if the file cannot be opened.
+ */
+class MappedFile
+{
+private:
+    /**
+     * \brief Start of the file contents.
+     */
+    const char* contents;
+    /**
+     * \brief Size of the file in bytes.
+     */
+    std::size_t length;
+    /**
+     * \brief Whether sp::image::MappedFile::contents
+     * should be unmapped on destruction.
+     */
+    bool mapped;
+    /**
+     * \brief File contents if mapping is not available.
+     */
+    std::vector<char> buffer;
+public:
+    /**
+     * \brief Map the file at `path`.
+     */
+    explicit MappedFile(const std::string& path);
+    /**
+     * \brief Mapping cannot be shared.
+     */
+    MappedFile(const MappedFile&) = delete;
+    /**
+     * \brief Mapping cannot be shared.
+     */
+    MappedFile& operator=(const MappedFile&) = delete;
+    /**
+     * \brief Unmap the file.
+     */
+    ~MappedFile();
+    /**
+     * \brief Start of the file contents.
+     */
+    const char* data() const;
+    /**
+     * \brief Size of the file in bytes.
+     */
+    std::size_t size() const;
+};
+
+}
+
+#endif
@@ -28,15 +28,19 @@
 #include <string>
 
 #include <image.hpp>
+#include <types.hpp>
 
 namespace sp::image
 {
 
 using sp::image::Image;
+using sp::types::ULONG;
 using std::istream;
 using std::ostream;
 using std::shared_ptr;
 
+struct PGMView;
+
 /**
  * \brief Input and output operations for PGM image format.
  *
@@ -60,6 +64,15 @@ using std::shared_ptr;
  *   width (number of columns) and height (number of rows);
  * - Maximum gray value;
  * - List of intensities in row-major order.
+ *
+ * <a href="http://netpbm.sourceforge.net/doc/pgm.html">Binary PGM</a>
+ * starts with `P5` and has the same header,
+ * but the maximum gray value is followed by a single whitespace
+ * and raw intensities:
+ * one byte per pixel if the maximum gray value is less than 256,
+ * and two bytes (the most significant first) otherwise.
+ * The format is detected by the magic characters on reading,
+ * and chosen by sp::image::PGM_IO::set_binary on writing.
  */
 class PGM_IO
 {
@@ -68,6 +81,10 @@ private:
      * \brief Pointer to an sp::image::Image the sp::image::PGM_IO had read or needs to write.
      */
     std::shared_ptr<struct Image> image;
+    /**
+     * \brief Whether to write the image in binary format.
+     */
+    bool binary = false;
     /**
      * \brief Read the next chunk ignoring comments.
      *
@@ -76,13 +93,57 @@ private:
      */
     static std::string read_pgm_instruction(std::istream& in);
     /**
-     * \brief Check whether PGM file ends correctly.
+     * \brief Parse plain intensities contained in `[begin, end)`
+     * after the header was read.
+     *
+     * Intensities are parsed with `std::from_chars`.
+     * Large images without comments among intensities
+     * are split into chunks at whitespace and parsed in parallel.
      *
      * End of the file should contain only whitespace and comments.
-     * The function checks exactly this fact,
-     * returns `true` if it holds and returns `false` otherwise.
      */
-    static bool check_file_end(std::istream& in);
+    static bool read_plain_data(
+        const char* begin,
+        const char* end,
+        struct Image* image
+    );
+    /**
+     * \brief Write plain intensities
+     * after the header was written.
+     *
+     * Each row is formatted with `std::to_chars` into a buffer
+     * and written at once.
+     */
+    static void write_plain_data(
+        std::ostream& out,
+        const struct Image* image
+    );
+    /**
+     * \brief Read magic characters, size and maximum gray value.
+     *
+     * For binary format also consume the single whitespace
+     * that separates the header from raw intensities.
+     * Headers with number of pixels (or of bytes of binary intensities)
+     * that doesn't fit into sp::types::ULONG are rejected.
+     */
+    static bool read_header(
+        std::istream& in,
+        struct Image* image,
+        bool* binary
+    );
+    /**
+     * \brief Read raw intensities of binary PGM
+     * after the header was read.
+     */
+    static bool read_binary_data(std::istream& in, struct Image* image);
+    /**
+     * \brief Write raw intensities of binary PGM
+     * after the header was written.
+     */
+    static void write_binary_data(
+        std::ostream& out,
+        const struct Image* image
+    );
 public:
     /**
      * \brief Maximum value of maximum gray value.
@@ -122,6 +183,19 @@ public:
      * \brief Magic string that identifies the plain PGM format.
      */
     static constexpr const char* FORMAT_CODE = "P2";
+    /**
+     * \brief Magic string that identifies the binary PGM format.
+     */
+    static constexpr const char* BINARY_FORMAT_CODE = "P5";
+    /**
+     * \brief Maximum value of maximum gray value in binary format.
+     */
+    static const unsigned MAX_BINARY_VALUE = (1u << 16u) - 1;
+    /**
+     * \brief Minimal size in bytes of plain intensities
+     * to parse them in parallel.
+     */
+    static const unsigned PARALLEL_PARSING_SIZE = 1u << 20u;
     /**
      * \brief Default constructor.
      */
@@ -150,6 +224,10 @@ public:
      * with sp::image::Image specified immediately.
      */
     explicit PGM_IO(std::shared_ptr<struct Image> image);
+    /**
+     * \brief Constructor with specific image and output format.
+     */
+    PGM_IO(std::shared_ptr<struct Image> image, bool binary);
     /**
      * \brief Default destructor.
      */
@@ -162,6 +240,16 @@ public:
      * \brief Image getter.
      */
     std::shared_ptr<struct Image> get_image() const;
+    /**
+     * \brief Choose binary (`P5`) or plain (`P2`) format for writing.
+     */
+    void set_binary(bool binary);
+    /**
+     * \brief Check whether the image will be written in binary format.
+     *
+     * After reading, tells the format of the read image.
+     */
+    bool is_binary() const;
     /**
      * \brief Overload of `>>` operator to read an image from input stream.
      *
@@ -175,8 +263,100 @@ public:
      * \brief Overload of `<<` operator to write an image to output stream.
      */
     friend std::ostream& operator<<(std::ostream& out, const PGM_IO& ppm_io);
+    /**
+     * \brief Binary PGM header is parsed the same way as by `>>` operator.
+     */
+    friend bool view_binary_pgm(
+        const char* begin,
+        const char* end,
+        struct PGMView* view
+    );
+    /**
+     * \brief Plain PGM is parsed right from the mapped file.
+     */
+    friend std::shared_ptr<struct Image> read_pgm(const std::string& path);
+    /**
+     * \brief Header is parsed the same way as by `>>` operator.
+     */
+    friend std::shared_ptr<struct Image> read_pgm_header(
+        const std::string& path
+    );
 };
 
+/**
+ * \brief Binary PGM image contained in memory (e.g., a mapped file).
+ *
+ * Intensities are accessed in place, without copying.
+ */
+struct PGMView
+{
+    /**
+     * \brief Width of the image in pixels.
+     */
+    ULONG width;
+    /**
+     * \brief Height of the image in pixels.
+     */
+    ULONG height;
+    /**
+     * \brief Maximal intensity.
+     */
+    ULONG max_value;
+    /**
+     * \brief Raw intensities in row-major order.
+     */
+    const unsigned char* pixels;
+};
+
+/**
+ * \brief Multiply sizes checking for overflow.
+ *
+ * @return
+ *  `false` if the product doesn't fit into sp::types::ULONG.
+ */
+bool checked_multiply(ULONG lhs, ULONG rhs, ULONG* product);
+/**
+ * \brief Calculate number of pixels of the image checking for overflow.
+ *
+ * @return
+ *  `false` if the number doesn't fit into sp::types::ULONG.
+ */
+bool pixels_count(const struct Image* image, ULONG* count);
+/**
+ * \brief Parse header of binary PGM contained in `[begin, end)`.
+ *
+ * @return
+ *  `false` if the contents is not a binary PGM
+ *  or is too short to contain all intensities.
+ */
+bool view_binary_pgm(const char* begin, const char* end, struct PGMView* view);
+/**
+ * \brief Get intensity of the pixel by its index in row-major order.
+ */
+ULONG pgm_view_value(const struct PGMView* view, ULONG index);
+/**
+ * \brief Read plain or binary PGM file detecting format by its contents.
+ *
+ * The file is mapped to memory with sp::image::MappedFile.
+ * Binary intensities are decoded right from the mapping.
+ *
+ * Throws `std::invalid_argument` if the file cannot be opened.
+ *
+ * @return
+ *  Null pointer if the file is not a correct PGM image.
+ */
+std::shared_ptr<struct Image> read_pgm(const std::string& path);
+/**
+ * \brief Read size and maximal intensity of plain or binary PGM file
+ * without reading intensities.
+ *
+ * @return
+ *  sp::image::Image with empty sp::image::Image::data,
+ *  or null pointer if the file cannot be opened
+ *  or doesn't start with a correct PGM header.
+ */
+std::shared_ptr<struct Image> read_pgm_header(const std::string& path);
+
 }
 
 #endif
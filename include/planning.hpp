@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef PLANNING_HPP
+#define PLANNING_HPP
+
+#include <types.hpp>
+
+#include <string>
+
+/**
+ * \brief Estimation of memory needed to solve a stereo pair
+ * and choice of a layout that fits into a budget.
+ */
+namespace sp::planning
+{
+
+using sp::types::BOOL;
+using sp::types::ULONG;
+
+/**
+ * \brief How a stereo pair is represented and solved.
+ */
+struct Layout
+{
+    /**
+     * \brief Whether to cache penalties of nodes (cost volume)
+     * in sp::graph::disparity::DisparityGraph::node_penalties.
+     */
+    BOOL cache_node_penalties = true;
+    /**
+     * \brief Number of times images are halved
+     * to be solved coarse-to-fine by sp::pyramid.
+     *
+     * Zero solves images directly.
+     */
+    ULONG pyramid_levels = 0;
+    /**
+     * \brief Number of disparities of a pixel at finer levels
+     * of the pyramid.
+     */
+    ULONG window = 8;
+    /**
+     * \brief Width of tiles solved one after another by sp::tiling.
+     *
+     * Zero solves the whole pair at once.
+     */
+    ULONG tile_width = 0;
+    /**
+     * \brief Height of tiles.
+     */
+    ULONG tile_height = 0;
+    /**
+     * \brief Number of pixels around a tile solved with it.
+     */
+    ULONG halo = 16;
+};
+
+/**
+ * \brief Bytes allocated by structures alive at the same time.
+ */
+struct Footprint
+{
+    /**
+     * \brief Left and right images of all levels and tiles.
+     */
+    ULONG images = 0;
+    /**
+     * \brief sp::graph::disparity::DisparityGraph:
+     * reparametrization, the cost volume and windows of disparities.
+     */
+    ULONG disparity_graph = 0;
+    /**
+     * \brief sp::graph::lowest_penalties::LowestPenalties.
+     */
+    ULONG lowest_penalties = 0;
+    /**
+     * \brief sp::labeling::finder::ThresholdSearch:
+     * slacks of nodes and consistent nodes.
+     */
+    ULONG threshold_search = 0;
+    /**
+     * \brief Candidates of the threshold collected by
+     * sp::labeling::finder::fetch_available_penalties:
+     * buffers of all threads, their merged copy
+     * and the penalties of a pixel or an edge fetched by each thread.
+     */
+    ULONG threshold_candidates = 0;
+    /**
+     * \brief Markers of nodes of sp::graph::constraint::ConstraintGraph
+     * and of its copies made by the labeling.
+     */
+    ULONG constraint_graph = 0;
+    /**
+     * \brief sp::graph::arc_consistency::ArcConsistency
+     * with counters of supports of all nodes (the worst case).
+     */
+    ULONG arc_consistency = 0;
+    /**
+     * \brief Disparity maps.
+     */
+    ULONG disparity_maps = 0;
+};
+
+/**
+ * \brief Sum of all parts of the footprint.
+ */
+ULONG total(const struct Footprint* footprint);
+/**
+ * \brief Footprint of solving one pair of images directly.
+ *
+ * `bytes_per_pixel` is the size of an intensity of images
+ * (see sp::image::Pixels::bytes_per_pixel).
+ * `windows` tells whether pixels have windows of disparities
+ * (see sp::graph::disparity::set_minimal_disparities).
+ */
+struct Footprint estimate_level(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    BOOL windows,
+    BOOL cache_node_penalties
+);
+/**
+ * \brief Peak footprint of solving the pair with the layout.
+ *
+ * Images of all levels of the pyramid are kept until the pair is solved,
+ * while structures of a level or a tile are freed before the next one.
+ * Counters of supports are estimated for all nodes
+ * and candidates of the threshold are assumed to be distinct,
+ * so the estimation is an upper bound.
+ */
+struct Footprint estimate_footprint(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    const struct Layout* layout
+);
+/**
+ * \brief Choose a layout with footprint not exceeding the budget.
+ *
+ * Layouts are tried from the fastest to the most frugal:
+ *
+ *   1. `preferred` layout;
+ *   2. the same without the cache of the cost volume;
+ *   3. the pyramid with windows of `preferred.window` disparities
+ *   and as few levels as possible (if `allow_pyramid` is set);
+ *   4. tiles of the largest square size that fits.
+ *
+ * Throws `std::invalid_argument` if even the smallest tiles don't fit.
+ */
+struct Layout plan_layout(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    ULONG budget,
+    const struct Layout& preferred,
+    BOOL allow_pyramid
+);
+/**
+ * \brief Parse size of memory like `4096`, `512K`, `256M` or `2G`.
+ *
+ * Throws `std::invalid_argument` if the size cannot be parsed.
+ */
+ULONG parse_memory_size(const std::string& size);
+
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef PROFILING_HPP
+#define PROFILING_HPP
+
+#include <types.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Measurement of time and memory consumed by stages of the solution.
+ */
+namespace sp::profiling
+{
+
+using sp::types::ULONG;
+
+/**
+ * \brief Resources consumed by one stage.
+ */
+struct Stage
+{
+    /**
+     * \brief Name of the stage.
+     */
+    std::string name;
+    /**
+     * \brief Elapsed (wall clock) time in seconds.
+     */
+    double wall_time;
+    /**
+     * \brief Processor time of all threads of the process in seconds.
+     *
+     * It's measured by `std::clock`,
+     * so it includes work of other threads running at the same time.
+     */
+    double cpu_time;
+    /**
+     * \brief Peak resident set size of the process
+     * at the end of the stage in bytes.
+     *
+     * Zero if the platform doesn't provide it.
+     */
+    ULONG peak_rss;
+    /**
+     * \brief Named amounts of items processed by the stage.
+     */
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+/**
+ * \brief Sequence of measured stages.
+ */
+struct Profile
+{
+    /**
+     * \brief Finished stages and the running one (the last).
+     */
+    std::vector<struct Stage> stages;
+    /**
+     * \brief Wall clock time when the running stage was started.
+     */
+    std::chrono::steady_clock::time_point wall_start;
+    /**
+     * \brief Processor time when the running stage was started.
+     */
+    std::clock_t cpu_start;
+};
+
+/**
+ * \brief Get peak resident set size of the process in bytes.
+ *
+ * @return
+ *  Zero if the platform doesn't provide it.
+ */
+ULONG peak_rss();
+/**
+ * \brief Start measurement of a new stage.
+ */
+void start_stage(struct Profile* profile, const std::string& name);
+/**
+ * \brief Finish measurement of the last started stage.
+ */
+void finish_stage(struct Profile* profile);
+/**
+ * \brief Add a counter to the last started stage.
+ */
+void count(struct Profile* profile, const std::string& name, double value);
+/**
+ * \brief Add nonzero sp::counters to the last started stage
+ * and reset them.
+ *
+ * Counters of all threads are summed and reset,
+ * so it shouldn't be called while other threads solve another problem.
+ */
+void count_engine_counters(struct Profile* profile);
+/**
+ * \brief Add stages of `part` to stages of `profile` with the same names
+ * and append stages `profile` doesn't have.
+ *
+ * Times and counters of the same names are summed,
+ * except `maximal_counters` (like thresholds) that take the maximum.
+ * Peak resident set size is the maximal one.
+ * Used to sum stages of parts of a problem solved one after another.
+ */
+void merge_stages(
+    struct Profile* profile,
+    const struct Profile* part,
+    const std::vector<std::string>& maximal_counters = {}
+);
+/**
+ * \brief Write human readable table of stages.
+ */
+void write_text_report(std::ostream& stream, const struct Profile* profile);
+/**
+ * \brief Write stages as a JSON object.
+ *
+ * \code{.json}
+ * {"stages": [{"name": "...", "wall_time": 0.1, "cpu_time": 0.4,
+ *   "peak_rss": 1048576, "counters": {"...": 1}}]}
+ * \endcode
+ */
+void write_json_report(std::ostream& stream, const struct Profile* profile);
+
+}
+
+#endif
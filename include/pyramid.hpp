@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef PYRAMID_HPP
+#define PYRAMID_HPP
+
+#include <image.hpp>
+#include <types.hpp>
+
+/**
+ * \brief Coarse-to-fine solving of stereo pairs.
+ *
+ * A pair is downsampled several times and solved at the coarsest level
+ * with all disparities.
+ * Each finer level is solved only with a narrow window of disparities
+ * around the upsampled disparity of the coarser level,
+ * which is set by sp::graph::disparity::set_minimal_disparities.
+ */
+namespace sp::pyramid
+{
+
+using sp::image::Image;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+/**
+ * \brief Halve width and height of the image.
+ *
+ * Each pixel of the result is the rounded average
+ * of the corresponding square of two by two pixels.
+ * Odd sizes are rounded up,
+ * so the last row or column averages only existing pixels.
+ */
+struct Image downsample(const struct Image& image);
+/**
+ * \brief Number of disparity levels of the downsampled pair.
+ */
+ULONG coarse_disparity_levels(ULONG disparity_levels);
+/**
+ * \brief Minimal disparities of windows of the finer level
+ * centered at the upsampled disparities of the coarser level.
+ *
+ * Disparity \f$c\f$ of the coarse pixel becomes \f$2c\f$
+ * for pixels it covers.
+ * The window of `window` disparities starts `window / 2` below it
+ * and is shifted to fit to the `disparity_levels`
+ * and to the right border of the image.
+ * Both \f$2c\f$ and \f$2c - 1\f$ fit to the window,
+ * so the finer level always has a consistent labeling.
+ *
+ * Throws `std::invalid_argument` if the window is narrower than two
+ * or the disparity map isn't downsampled `width` by `height` image.
+ */
+ULONG_ARRAY upsample_minimal_disparities(
+    const struct Image& coarse_disparity_map,
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG window
+);
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <labeling_finder.hpp>
+#include <types.hpp>
+
+/**
+ * \brief Processing of consecutive frames of a stereo video,
+ * where each frame is seeded by the previous one.
+ */
+namespace sp::stream
+{
+
+using sp::graph::disparity::DisparityGraph;
+using sp::image::Image;
+using sp::labeling::finder::ThresholdSearch;
+using sp::types::BOOL;
+using sp::types::FLOAT;
+using sp::types::FLOAT_ARRAY;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+/**
+ * \brief Results of the previous frame used to seed the next one.
+ *
+ * Neighboring frames of a video are similar,
+ * so the solution of one frame is a good guess for the next:
+ *
+ *   - its reparametrization is a starting point
+ *   for sp::graph::diffusion::diffusion;
+ *   - its threshold is the center of the threshold search;
+ *   - its disparity map is a labeling of the next frame,
+ *   which bounds the threshold from above.
+ *
+ * All of them are equivalent transformations or exact bounds,
+ * so a seeded frame gets the same disparity map as a cold one
+ * whenever diffusion is not used.
+ */
+struct WarmStart
+{
+    /**
+     * \brief Number of frames remembered so far.
+     *
+     * A state without frames seeds nothing.
+     */
+    ULONG frames = 0;
+    /**
+     * \brief Width of the previous frame.
+     */
+    ULONG width = 0;
+    /**
+     * \brief Height of the previous frame.
+     */
+    ULONG height = 0;
+    /**
+     * \brief Number of disparity levels of the previous frame.
+     */
+    ULONG disparity_levels = 0;
+    /**
+     * \brief Threshold found by the search for the previous frame.
+     */
+    FLOAT threshold = 0;
+    /**
+     * \brief Windows of disparities of the previous frame
+     * (see sp::graph::disparity::DisparityGraph::minimal_disparities).
+     */
+    ULONG_ARRAY minimal_disparities;
+    /**
+     * \brief Reparametrization of the previous frame.
+     */
+    FLOAT_ARRAY reparametrization;
+    /**
+     * \brief Disparity map of the previous frame.
+     */
+    struct Image disparity_map;
+};
+
+/**
+ * \brief Check whether the previous frame has the same geometry
+ * as the graph, so it can seed the graph.
+ */
+BOOL is_compatible(
+    const struct WarmStart* warm_start,
+    const struct DisparityGraph* graph
+);
+/**
+ * \brief Start from the reparametrization of the previous frame.
+ *
+ * Any reparametrization is an equivalent transformation,
+ * so this changes only the starting point of
+ * sp::graph::diffusion::diffusion.
+ * Does nothing if the previous frame isn't compatible
+ * or had other windows of disparities,
+ * because then the same offsets belong to other nodes.
+ *
+ * @return
+ *  `true` if the reparametrization was copied.
+ */
+BOOL seed_reparametrization(
+    const struct WarmStart* warm_start,
+    struct DisparityGraph* graph
+);
+/**
+ * \brief Calculate the maximal slack of nodes and edges of a labeling.
+ *
+ * Slack of a node is taken from
+ * sp::labeling::finder::ThresholdSearch::nodes_slacks,
+ * slack of an edge is the difference between its penalty
+ * and the lowest penalty of its neighborhood.
+ * All nodes and edges of the labeling are available for this threshold,
+ * so the CSP has a solution for any threshold not less than it.
+ *
+ * @return
+ *  \f$\infty\f$ if the labeling has another size
+ *  or contains nonexistent nodes or edges.
+ */
+FLOAT calculate_labeling_slack(
+    const struct ThresholdSearch* search,
+    const struct Image* disparity_map
+);
+/**
+ * \brief Search the minimal consistent threshold
+ * around a guess and below a known consistent bound.
+ *
+ * The search starts with a probe of the first penalty
+ * not less than `guess`.
+ * Then it goes down (if the probe is consistent) or up (otherwise)
+ * with exponentially growing steps until the probe flips,
+ * and finishes with a binary search in the found bracket.
+ * Penalties not less than `upper_bound` are known to be consistent
+ * and aren't probed.
+ *
+ * When the guess is close to the answer,
+ * this takes a few probes instead of a logarithm
+ * of the number of penalties.
+ * The result is the same as of
+ * sp::labeling::finder::calculate_minimal_consistent_threshold,
+ * or exceeds it not more than by `tolerance`
+ * like sp::labeling::finder::calculate_approximate_consistent_threshold.
+ */
+FLOAT calculate_warm_threshold(
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties,
+    FLOAT guess,
+    FLOAT upper_bound,
+    FLOAT tolerance
+);
+/**
+ * \brief Search the threshold of the graph of `search`
+ * seeded by the previous frame.
+ *
+ * Uses sp::stream::calculate_warm_threshold
+ * with the previous threshold as the guess
+ * and the slack of the previous disparity map as the upper bound.
+ * Falls back to the cold search if the previous frame isn't compatible.
+ */
+FLOAT calculate_stream_threshold(
+    const struct WarmStart* warm_start,
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties,
+    FLOAT tolerance
+);
+/**
+ * \brief Remember the solved frame to seed the next one.
+ */
+void remember_frame(
+    struct WarmStart* warm_start,
+    const struct DisparityGraph* graph,
+    FLOAT threshold,
+    const struct Image& disparity_map
+);
+
+}
+
+#endif
@@ -0,0 +1,254 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef TILE_SCHEDULER_HPP
+#define TILE_SCHEDULER_HPP
+
+#include <types.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * \brief Scheduling of work over parts of an image.
+ */
+namespace sp::scheduling
+{
+
+using sp::types::BOOL;
+using sp::types::ULONG;
+
+/**
+ * \brief Rectangular part of an image processed as one task.
+ */
+struct Tile
+{
+    /**
+     * \brief Column of the top left pixel of the tile.
+     */
+    ULONG x;
+    /**
+     * \brief Row of the top left pixel of the tile.
+     */
+    ULONG y;
+    /**
+     * \brief Number of columns in the tile.
+     */
+    ULONG width;
+    /**
+     * \brief Number of rows in the tile.
+     */
+    ULONG height;
+};
+
+/**
+ * \brief Work-stealing scheduler of sweeps over tiles of an image.
+ *
+ * The image is split into tiles of equal size
+ * (tiles at the right and bottom borders may be smaller).
+ * Each sweep processes dirty tiles only.
+ * Dirty tiles are split into contiguous runs, one per thread;
+ * a thread takes tiles from the front of its own run
+ * and, when the run is over, steals tiles from the back of runs of others,
+ * so threads that got cheap tiles help those that got expensive ones.
+ *
+ * If processing of a tile changed something,
+ * the tile and its four neighbors become dirty for the next sweep.
+ * Sweeps stop when no tile is dirty
+ * or sp::scheduling::TileScheduler::stop is called.
+ *
+ * Threads are taken from a single (not nested) OpenMP parallel region
+ * that lives during all sweeps.
+ * Without OpenMP all tiles are processed by the calling thread.
+ */
+class TileScheduler
+{
+public:
+    /**
+     * \brief Function that processes a tile.
+     *
+     * Should return `true` if it changed something
+     * that neighboring tiles depend on.
+     * Is called from several threads simultaneously
+     * for different tiles.
+     */
+    using Task = std::function<BOOL(const struct Tile& tile)>;
+    /**
+     * \brief Split the image into tiles and mark all of them dirty.
+     *
+     * `threads` equal to zero means the number of threads
+     * chosen by OpenMP (`OMP_NUM_THREADS`).
+     * Throws `std::invalid_argument` if the image or tiles are empty.
+     */
+    TileScheduler(
+        ULONG width,
+        ULONG height,
+        ULONG tile_width,
+        ULONG tile_height,
+        ULONG threads
+    );
+    /**
+     * \brief Number of tiles.
+     */
+    ULONG get_tiles() const;
+    /**
+     * \brief Number of threads to process tiles.
+     */
+    ULONG get_threads() const;
+    /**
+     * \brief Number of sweeps made by the last
+     * sp::scheduling::TileScheduler::run.
+     */
+    ULONG get_sweeps() const;
+    /**
+     * \brief Position and size of the tile with specified index.
+     *
+     * Tiles are enumerated in row-major order.
+     */
+    struct Tile tile(ULONG index) const;
+    /**
+     * \brief Mark the tile to be processed in the next sweep.
+     */
+    void mark_dirty(ULONG index);
+    /**
+     * \brief Mark all tiles to be processed in the next sweep.
+     */
+    void mark_all_dirty();
+    /**
+     * \brief Check whether at least one tile should be processed.
+     */
+    BOOL any_dirty() const;
+    /**
+     * \brief Process dirty tiles by sweeps
+     * until nothing changes or the scheduler is stopped.
+     */
+    void run(const Task& task);
+    /**
+     * \brief Skip remaining tiles and finish
+     * sp::scheduling::TileScheduler::run.
+     *
+     * Can be called from the task.
+     * Dirty tiles left unprocessed stay dirty.
+     */
+    void stop();
+    /**
+     * \brief Check whether the last
+     * sp::scheduling::TileScheduler::run was stopped.
+     */
+    BOOL is_stopped() const;
+private:
+    /**
+     * \brief Run of tiles assigned to a thread in the current sweep.
+     */
+    struct Queue
+    {
+        /**
+         * \brief Guards the boundaries of the run.
+         */
+        std::mutex mutex;
+        /**
+         * \brief Position of the next tile for the owner
+         * in sp::scheduling::TileScheduler::order.
+         */
+        ULONG begin = 0;
+        /**
+         * \brief Position after the last tile, moved by thieves.
+         */
+        ULONG end = 0;
+    };
+
+    /**
+     * \brief Take a tile from the own run or steal one.
+     *
+     * @return
+     *  `false` if all runs are over.
+     */
+    BOOL take(ULONG thread, ULONG team, ULONG* tile);
+    /**
+     * \brief Mark the tile and its neighbors dirty for the next sweep.
+     */
+    void mark_changed(ULONG index);
+    /**
+     * \brief Collect dirty tiles and split them among threads.
+     *
+     * @return
+     *  `false` if there is nothing to do.
+     */
+    BOOL prepare_sweep(ULONG team);
+
+    /**
+     * \brief Width of the image.
+     */
+    ULONG width;
+    /**
+     * \brief Height of the image.
+     */
+    ULONG height;
+    /**
+     * \brief Width of a tile.
+     */
+    ULONG tile_width;
+    /**
+     * \brief Height of a tile.
+     */
+    ULONG tile_height;
+    /**
+     * \brief Number of tiles in a row.
+     */
+    ULONG columns;
+    /**
+     * \brief Number of rows of tiles.
+     */
+    ULONG rows;
+    /**
+     * \brief Number of threads to process tiles.
+     */
+    ULONG threads;
+    /**
+     * \brief Number of sweeps made by the last run.
+     */
+    ULONG sweeps = 0;
+    /**
+     * \brief Tiles to process in the current sweep.
+     */
+    std::vector<ULONG> order;
+    /**
+     * \brief Markers of tiles to process in the next sweep.
+     */
+    std::unique_ptr<std::atomic<BOOL>[]> dirty;
+    /**
+     * \brief Runs of tiles of threads.
+     */
+    std::unique_ptr<Queue[]> queues;
+    /**
+     * \brief Whether the run was stopped.
+     */
+    std::atomic<BOOL> stopped{false};
+};
+
+}
+
+#endif
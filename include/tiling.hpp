@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef TILING_HPP
+#define TILING_HPP
+
+#include <image.hpp>
+#include <tile_scheduler.hpp>
+#include <types.hpp>
+
+#include <vector>
+
+/**
+ * \brief Solving of large stereo pairs tile by tile.
+ *
+ * Memory of sp::graph::disparity::DisparityGraph,
+ * sp::graph::lowest_penalties::LowestPenalties
+ * and sp::graph::constraint::ConstraintGraph
+ * is proportional to the number of pixels,
+ * so a pair that doesn't fit into memory
+ * is split into tiles solved one after another.
+ * Only the images and the disparity map are kept for the whole pair.
+ */
+namespace sp::tiling
+{
+
+using sp::image::Image;
+using sp::scheduling::Tile;
+using sp::types::ULONG;
+
+/**
+ * \brief Part of the pair solved independently of others.
+ */
+struct HaloTile
+{
+    /**
+     * \brief Pixels of the disparity map taken from this tile.
+     *
+     * Cores of all tiles cover the image without overlaps.
+     */
+    struct Tile core;
+    /**
+     * \brief Pixels of images the tile is solved on.
+     *
+     * The core extended by the halo in all directions
+     * and by `disparity_levels - 1` columns to the right,
+     * so pixels of the core have the same nodes as in the whole image.
+     * Halo gives pixels near the border of the core the same context
+     * from smoothness of neighbors,
+     * so the stitched map has no seams if the halo is wide enough.
+     */
+    struct Tile extended;
+};
+
+/**
+ * \brief Split the image into tiles with cores of the specified size
+ * (tiles at the right and bottom borders may be smaller).
+ *
+ * Throws `std::invalid_argument` if the image or tiles are empty.
+ */
+std::vector<struct HaloTile> plan_tiles(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG tile_width,
+    ULONG tile_height,
+    ULONG halo
+);
+/**
+ * \brief Copy a rectangular part of the image.
+ *
+ * Throws `std::invalid_argument` if the tile exceeds the image.
+ */
+struct Image crop(const struct Image& image, const struct Tile& tile);
+/**
+ * \brief Copy the core of the tile from its disparity map
+ * into the disparity map of the whole image.
+ *
+ * `tile_map` covers sp::tiling::HaloTile::extended.
+ */
+void stitch(
+    struct Image* disparity_map,
+    const struct Image& tile_map,
+    const struct HaloTile& tile
+);
+
+}
+
+#endif
@@ -0,0 +1,488 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <arc_consistency.hpp>
+#include <counters.hpp>
+#include <indexing.hpp>
+#include <indexing_checks.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace sp::graph::arc_consistency
+{
+
+using sp::graph::constraint::check_nodes_left;
+using sp::graph::constraint::check_pixel_nodes_left;
+using sp::graph::constraint::is_node_available;
+using sp::graph::constraint::make_all_nodes_unavailable;
+using sp::graph::constraint::make_node_unavailable;
+using sp::graph::constraint::next_available_disparity;
+using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::graph::disparity::pixel_disparities;
+using sp::indexing::checks::edge_exists;
+using sp::indexing::checks::neighborhood_exists_fast;
+using sp::indexing::neighbor_by_index;
+using sp::indexing::nodes_pixel_index;
+using sp::types::FALSE;
+using sp::types::Pixel;
+using sp::types::TRUE;
+using std::numeric_limits;
+using std::uint16_t;
+using std::uint32_t;
+
+namespace
+{
+
+/**
+ * \brief Set the counter of supports with the index.
+ */
+void set_supports(struct ArcConsistency* state, ULONG index, ULONG value)
+{
+    if (state->wide_supports.empty())
+    {
+        state->supports[index] = static_cast<uint16_t>(value);
+    }
+    else
+    {
+        state->wide_supports[index] = static_cast<uint32_t>(value);
+    }
+}
+
+/**
+ * \brief Read the counter of supports with the index.
+ */
+ULONG get_supports(const struct ArcConsistency* state, ULONG index)
+{
+    return state->wide_supports.empty()
+        ? state->supports[index]
+        : state->wide_supports[index];
+}
+
+/**
+ * \brief Decrement the counter of supports with the index.
+ *
+ * @return
+ *  `true` if no supports left.
+ */
+BOOL release_support(struct ArcConsistency* state, ULONG index)
+{
+    return state->wide_supports.empty()
+        ? --state->supports[index] == 0
+        : --state->wide_supports[index] == 0;
+}
+
+}
+
+ArcConsistency::ArcConsistency(
+    struct ConstraintGraph* graph,
+    ULONG counter_bytes
+)
+    : graph{graph}
+    , known{graph->nodes_availability}
+    , propagation{TRUE, 0, {0, 0}, {0, 0}}
+{
+    const struct DisparityGraph* disparity_graph = graph->disparity_graph;
+    const ULONG pixels
+        = disparity_graph->right.width * disparity_graph->right.height;
+    const ULONG disparity_levels = disparity_graph->disparity_levels;
+    this->domain_first.assign(pixels, 0);
+    this->domain_offsets.assign(pixels + 1, 0);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long pixel = 0; pixel < static_cast<long>(pixels); ++pixel)
+    {
+        const ULONG first = this->known.next(pixel, 0);
+        ULONG last = first;
+        for (
+            ULONG disparity = first;
+            disparity < disparity_levels;
+            disparity = this->known.next(pixel, disparity + 1)
+        )
+        {
+            last = disparity;
+        }
+        if (first < disparity_levels)
+        {
+            this->domain_first[pixel] = first;
+            this->domain_offsets[pixel + 1] = last - first + 1;
+        }
+    }
+    std::partial_sum(
+        this->domain_offsets.begin(),
+        this->domain_offsets.end(),
+        this->domain_offsets.begin()
+    );
+    if (counter_bytes == 0)
+    {
+        counter_bytes = support_counter_bytes(disparity_levels);
+    }
+    if (counter_bytes == sizeof(uint16_t))
+    {
+        this->supports.assign(
+            this->domain_offsets.back() * NEIGHBORS_COUNT,
+            0
+        );
+    }
+    else
+    {
+        this->wide_supports.assign(
+            this->domain_offsets.back() * NEIGHBORS_COUNT,
+            0
+        );
+    }
+
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long y = 0; y < static_cast<long>(disparity_graph->right.height); ++y)
+    {
+        struct Node node{{0, static_cast<ULONG>(y)}, 0};
+        for (
+            node.pixel.x = 0;
+            node.pixel.x < disparity_graph->right.width;
+            ++node.pixel.x
+        )
+        {
+            const ULONG disparities
+                = pixel_disparities(disparity_graph, node.pixel);
+            for (
+                node.disparity = next_available_disparity(
+                    graph,
+                    node.pixel,
+                    0
+                );
+                node.disparity < disparities;
+                node.disparity = next_available_disparity(
+                    graph,
+                    node.pixel,
+                    node.disparity + 1
+                )
+            )
+            {
+                for (
+                    ULONG neighbor_index = 0;
+                    neighbor_index < NEIGHBORS_COUNT;
+                    ++neighbor_index
+                )
+                {
+                    if (
+                        neighborhood_exists_fast(
+                            disparity_graph,
+                            node.pixel,
+                            neighbor_index
+                        )
+                    )
+                    {
+                        set_supports(
+                            this,
+                            support_index(this, node, neighbor_index),
+                            count_supports(graph, node, neighbor_index)
+                        );
+                    }
+                }
+            }
+        }
+    }
+
+    struct Node node{{0, 0}, 0};
+    for (
+        node.pixel.y = 0;
+        node.pixel.y < disparity_graph->right.height;
+        ++node.pixel.y
+    )
+    {
+        for (
+            node.pixel.x = 0;
+            node.pixel.x < disparity_graph->right.width;
+            ++node.pixel.x
+        )
+        {
+            if (!check_pixel_nodes_left(graph, node.pixel))
+            {
+                COUNT(COLLAPSED_PIXELS, 1);
+                make_all_nodes_unavailable(graph);
+                this->known.reset_all();
+                this->worklist.clear();
+                this->propagation.solvable = FALSE;
+                return;
+            }
+            const ULONG disparities
+                = pixel_disparities(disparity_graph, node.pixel);
+            for (
+                node.disparity = next_available_disparity(
+                    graph,
+                    node.pixel,
+                    0
+                );
+                node.disparity < disparities;
+                node.disparity = next_available_disparity(
+                    graph,
+                    node.pixel,
+                    node.disparity + 1
+                )
+            )
+            {
+                COUNT(NODES_EXAMINED, 1);
+                for (
+                    ULONG neighbor_index = 0;
+                    neighbor_index < NEIGHBORS_COUNT;
+                    ++neighbor_index
+                )
+                {
+                    if (
+                        neighborhood_exists_fast(
+                            disparity_graph,
+                            node.pixel,
+                            neighbor_index
+                        )
+                        && get_supports(
+                            this,
+                            support_index(this, node, neighbor_index)
+                        ) == 0
+                    )
+                    {
+                        remove_node(this, node);
+                        COUNT(EARLY_BREAKS, 1);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+ULONG support_counter_bytes(ULONG disparity_levels)
+{
+    return disparity_levels > numeric_limits<uint16_t>::max()
+        ? sizeof(uint32_t)
+        : sizeof(uint16_t);
+}
+
+ULONG support_index(
+    const struct ArcConsistency* state,
+    struct Node node,
+    ULONG neighbor_index
+)
+{
+    const ULONG pixel
+        = nodes_pixel_index(state->graph->disparity_graph, node.pixel);
+    return neighbor_index
+        + NEIGHBORS_COUNT * (
+            state->domain_offsets[pixel]
+            + node.disparity
+            - state->domain_first[pixel]
+        );
+}
+
+BOOL edge_allowed(const struct ConstraintGraph* graph, struct Edge edge)
+{
+    COUNT(EDGE_CHECKS, 1);
+    return edge_exists(graph->disparity_graph, edge)
+        && edge_penalty(graph->disparity_graph, edge)
+            - lowest_neighborhood_penalty(graph->lowest_penalties, edge)
+            <= graph->threshold;
+}
+
+ULONG count_supports(
+    const struct ConstraintGraph* graph,
+    struct Node node,
+    ULONG neighbor_index
+)
+{
+    struct Edge edge{node, {neighbor_by_index(node.pixel, neighbor_index), 0}};
+    ULONG result = 0;
+    const ULONG disparities
+        = pixel_disparities(graph->disparity_graph, edge.neighbor.pixel);
+    for (
+        edge.neighbor.disparity = next_available_disparity(
+            graph,
+            edge.neighbor.pixel,
+            0
+        );
+        edge.neighbor.disparity < disparities;
+        edge.neighbor.disparity = next_available_disparity(
+            graph,
+            edge.neighbor.pixel,
+            edge.neighbor.disparity + 1
+        )
+    )
+    {
+        if (edge_allowed(graph, edge))
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+void remove_node(struct ArcConsistency* state, struct Node node)
+{
+    if (
+        !state->known.reset(
+            nodes_pixel_index(state->graph->disparity_graph, node.pixel),
+            node.disparity
+        )
+    )
+    {
+        return;
+    }
+    make_node_unavailable(state->graph, node);
+    state->worklist.push_back(node);
+    COUNT(NODES_REMOVED, 1);
+
+    struct Propagation* propagation = &(state->propagation);
+    if (propagation->removed_nodes == 0)
+    {
+        propagation->first = node.pixel;
+        propagation->last = node.pixel;
+    }
+    else
+    {
+        propagation->first.x = std::min(propagation->first.x, node.pixel.x);
+        propagation->first.y = std::min(propagation->first.y, node.pixel.y);
+        propagation->last.x = std::max(propagation->last.x, node.pixel.x);
+        propagation->last.y = std::max(propagation->last.y, node.pixel.y);
+    }
+    ++propagation->removed_nodes;
+}
+
+BOOL propagate(struct ArcConsistency* state)
+{
+    const struct DisparityGraph* disparity_graph
+        = state->graph->disparity_graph;
+    struct Edge edge;
+    while (!state->worklist.empty())
+    {
+        edge.neighbor = state->worklist.back();
+        state->worklist.pop_back();
+
+        if (
+            !state->known.any(
+                nodes_pixel_index(disparity_graph, edge.neighbor.pixel)
+            )
+        )
+        {
+            COUNT(COLLAPSED_PIXELS, 1);
+            make_all_nodes_unavailable(state->graph);
+            state->known.reset_all();
+            state->worklist.clear();
+            state->propagation.solvable = FALSE;
+            return FALSE;
+        }
+
+        for (
+            ULONG neighbor_index = 0;
+            neighbor_index < NEIGHBORS_COUNT;
+            ++neighbor_index
+        )
+        {
+            if (
+                !neighborhood_exists_fast(
+                    disparity_graph,
+                    edge.neighbor.pixel,
+                    neighbor_index
+                )
+            )
+            {
+                continue;
+            }
+            edge.node.pixel = neighbor_by_index(
+                edge.neighbor.pixel,
+                neighbor_index
+            );
+            const ULONG reverse_index = neighbor_index ^ 1;
+            const ULONG pixel
+                = nodes_pixel_index(disparity_graph, edge.node.pixel);
+            const ULONG disparities
+                = pixel_disparities(disparity_graph, edge.node.pixel);
+            for (
+                edge.node.disparity = state->known.next(pixel, 0);
+                edge.node.disparity < disparities;
+                edge.node.disparity
+                    = state->known.next(pixel, edge.node.disparity + 1)
+            )
+            {
+                if (!edge_allowed(state->graph, edge))
+                {
+                    continue;
+                }
+                COUNT(NODES_EXAMINED, 1);
+                if (
+                    release_support(
+                        state,
+                        support_index(state, edge.node, reverse_index)
+                    )
+                )
+                {
+                    remove_node(state, edge.node);
+                }
+            }
+        }
+    }
+    state->propagation.solvable = check_nodes_left(state->graph);
+    return state->propagation.solvable;
+}
+
+struct Propagation propagate_from(
+    struct ArcConsistency* state,
+    struct Pixel pixel
+)
+{
+    state->propagation.removed_nodes = 0;
+    if (!state->propagation.solvable)
+    {
+        return state->propagation;
+    }
+
+    struct Node node{pixel, 0};
+    const ULONG disparities
+        = pixel_disparities(state->graph->disparity_graph, pixel);
+    for (
+        node.disparity = 0;
+        node.disparity < disparities;
+        ++node.disparity
+    )
+    {
+        if (!is_node_available(state->graph, node))
+        {
+            remove_node(state, node);
+        }
+    }
+    propagate(state);
+    return state->propagation;
+}
+
+BOOL solve_csp_worklist(struct ConstraintGraph* graph)
+{
+    struct ArcConsistency state{graph};
+    return propagate(&state);
+}
+
+}
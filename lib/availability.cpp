@@ -0,0 +1,191 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <availability.hpp>
+
+#include <bitset>
+
+namespace sp::graph::availability
+{
+
+using std::atomic;
+using std::bitset;
+using std::memory_order_relaxed;
+
+namespace
+{
+
+/**
+ * \brief Position of the lowest set bit of a nonzero word.
+ */
+ULONG lowest_bit(NodesAvailability::WORD word)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+    return static_cast<ULONG>(__builtin_ctzll(word));
+    #else
+    ULONG result = 0;
+    while ((word & 1u) == 0)
+    {
+        word >>= 1u;
+        ++result;
+    }
+    return result;
+    #endif
+}
+
+}
+
+NodesAvailability::NodesAvailability(ULONG pixels, ULONG disparity_levels)
+    : pixels{pixels}
+    , disparity_levels{disparity_levels}
+    , words_per_pixel{(disparity_levels + WORD_BITS - 1) / WORD_BITS}
+    , words{new atomic<WORD>[pixels * words_per_pixel]}
+{
+    this->reset_all();
+}
+
+NodesAvailability::NodesAvailability(const NodesAvailability& other)
+    : pixels{other.pixels}
+    , disparity_levels{other.disparity_levels}
+    , words_per_pixel{other.words_per_pixel}
+    , words{new atomic<WORD>[other.pixels * other.words_per_pixel]}
+{
+    for (ULONG index = 0; index < this->pixels * this->words_per_pixel; ++index)
+    {
+        this->words[index].store(
+            other.words[index].load(memory_order_relaxed),
+            memory_order_relaxed
+        );
+    }
+}
+
+NodesAvailability& NodesAvailability::operator=(const NodesAvailability& other)
+{
+    if (this != &other)
+    {
+        *this = NodesAvailability{other};
+    }
+    return *this;
+}
+
+void NodesAvailability::reset_all()
+{
+    for (ULONG index = 0; index < this->pixels * this->words_per_pixel; ++index)
+    {
+        this->words[index].store(0, memory_order_relaxed);
+    }
+}
+
+BOOL NodesAvailability::any() const
+{
+    for (ULONG index = 0; index < this->pixels * this->words_per_pixel; ++index)
+    {
+        if (this->words[index].load(memory_order_relaxed) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+BOOL NodesAvailability::any(ULONG pixel) const
+{
+    for (ULONG index = 0; index < this->words_per_pixel; ++index)
+    {
+        if (
+            this->words[pixel * this->words_per_pixel + index].load(
+                memory_order_relaxed
+            ) != 0
+        )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+ULONG NodesAvailability::next(ULONG pixel, ULONG disparity) const
+{
+    ULONG index = disparity / WORD_BITS;
+    if (index >= this->words_per_pixel)
+    {
+        return this->disparity_levels;
+    }
+    WORD word = this->words[pixel * this->words_per_pixel + index].load(
+        memory_order_relaxed
+    ) & (~WORD{0} << (disparity % WORD_BITS));
+    while (word == 0)
+    {
+        if (++index == this->words_per_pixel)
+        {
+            return this->disparity_levels;
+        }
+        word = this->words[pixel * this->words_per_pixel + index].load(
+            memory_order_relaxed
+        );
+    }
+    return index * WORD_BITS + lowest_bit(word);
+}
+
+ULONG NodesAvailability::count() const
+{
+    ULONG result = 0;
+    for (ULONG index = 0; index < this->pixels * this->words_per_pixel; ++index)
+    {
+        result += bitset<WORD_BITS>(
+            this->words[index].load(memory_order_relaxed)
+        ).count();
+    }
+    return result;
+}
+
+ULONG NodesAvailability::count(ULONG pixel) const
+{
+    ULONG result = 0;
+    for (ULONG index = 0; index < this->words_per_pixel; ++index)
+    {
+        result += bitset<WORD_BITS>(
+            this->words[pixel * this->words_per_pixel + index].load(
+                memory_order_relaxed
+            )
+        ).count();
+    }
+    return result;
+}
+
+ULONG NodesAvailability::get_pixels() const
+{
+    return this->pixels;
+}
+
+ULONG NodesAvailability::get_disparity_levels() const
+{
+    return this->disparity_levels;
+}
+
+ULONG NodesAvailability::size() const
+{
+    return this->pixels * this->disparity_levels;
+}
+
+}
@@ -0,0 +1,262 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <batch.hpp>
+#include <pgm_io.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace sp::batch
+{
+
+namespace filesystem = std::filesystem;
+
+using sp::image::Image;
+using sp::image::pixels_count;
+using sp::image::read_pgm_header;
+using std::string;
+using std::vector;
+
+namespace
+{
+
+/**
+ * \brief Resolve relative path against the directory.
+ */
+string resolve(const string& path, const string& directory)
+{
+    filesystem::path result{path};
+    if (result.is_relative() && !directory.empty())
+    {
+        result = filesystem::path{directory} / result;
+    }
+    return result.string();
+}
+
+/**
+ * \brief Path of the disparity map for the left image
+ * in the output directory.
+ */
+string output_path(const string& left, const string& output_directory)
+{
+    if (output_directory.empty())
+    {
+        throw std::invalid_argument(
+            "Output directory is needed for the disparity map of `"
+            + left + "`."
+        );
+    }
+    return (
+        filesystem::path{output_directory} / filesystem::path{left}.filename()
+    ).string();
+}
+
+/**
+ * \brief Number of pixels of the image according to its header.
+ */
+ULONG image_pixels(const string& path)
+{
+    std::shared_ptr<struct Image> header = read_pgm_header(path);
+    ULONG count = 0;
+    return header && pixels_count(header.get(), &count) ? count : 0;
+}
+
+}
+
+vector<struct StereoPair> read_manifest(
+    std::istream& in,
+    const string& base_directory,
+    const string& output_directory
+)
+{
+    vector<struct StereoPair> result;
+    std::set<string> outputs;
+    string line;
+    for (ULONG line_number = 1; std::getline(in, line); ++line_number)
+    {
+        std::istringstream fields{line};
+        vector<string> paths;
+        string path;
+        while (fields >> path)
+        {
+            paths.push_back(path);
+        }
+        if (paths.empty() || paths.front().front() == '#')
+        {
+            continue;
+        }
+        if (paths.size() < 2 || paths.size() > 3)
+        {
+            throw std::invalid_argument(
+                "Line " + std::to_string(line_number)
+                + " of the manifest should contain left and right images"
+                " and, optionally, the disparity map."
+            );
+        }
+        struct StereoPair pair;
+        pair.left = resolve(paths[0], base_directory);
+        pair.right = resolve(paths[1], base_directory);
+        pair.output = paths.size() == 3
+            ? resolve(paths[2], base_directory)
+            : output_path(pair.left, output_directory);
+        if (
+            !outputs.insert(
+                filesystem::path{pair.output}.lexically_normal().string()
+            ).second
+        )
+        {
+            throw std::invalid_argument(
+                "Line " + std::to_string(line_number)
+                + " of the manifest writes the disparity map to `"
+                + pair.output + "` like a previous line."
+            );
+        }
+        result.push_back(pair);
+    }
+    return result;
+}
+
+vector<struct StereoPair> read_batch(
+    const string& path,
+    const string& output_directory
+)
+{
+    std::error_code error;
+    if (!filesystem::is_directory(path, error))
+    {
+        std::ifstream manifest{path};
+        if (!manifest)
+        {
+            throw std::invalid_argument(
+                "Cannot read the manifest `" + path + "`."
+            );
+        }
+        return read_manifest(
+            manifest,
+            filesystem::path{path}.parent_path().string(),
+            output_directory
+        );
+    }
+
+    const filesystem::path left_directory = filesystem::path{path} / "left";
+    const filesystem::path right_directory = filesystem::path{path} / "right";
+    if (
+        !filesystem::is_directory(left_directory, error)
+        || !filesystem::is_directory(right_directory, error)
+    )
+    {
+        throw std::invalid_argument(
+            "Directory `" + path
+            + "` should contain `left` and `right` subdirectories."
+        );
+    }
+
+    vector<struct StereoPair> result;
+    for (const auto& entry : filesystem::directory_iterator{left_directory})
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+        const filesystem::path name = entry.path().filename();
+        if (!filesystem::is_regular_file(right_directory / name, error))
+        {
+            throw std::invalid_argument(
+                "Right image for `" + entry.path().string() + "` is missing."
+            );
+        }
+        struct StereoPair pair;
+        pair.left = entry.path().string();
+        pair.right = (right_directory / name).string();
+        pair.output = output_path(pair.left, output_directory);
+        result.push_back(pair);
+    }
+    std::sort(
+        result.begin(),
+        result.end(),
+        [](const struct StereoPair& lhs, const struct StereoPair& rhs)
+        {
+            return lhs.left < rhs.left;
+        }
+    );
+    return result;
+}
+
+ULONG run_batch(
+    const vector<struct StereoPair>& pairs,
+    ULONG small_pixels,
+    const std::function<BOOL(ULONG index)>& solve
+)
+{
+    vector<ULONG> small;
+    vector<ULONG> large;
+    for (ULONG index = 0; index < pairs.size(); ++index)
+    {
+        if (image_pixels(pairs[index].left) < small_pixels)
+        {
+            small.push_back(index);
+        }
+        else
+        {
+            large.push_back(index);
+        }
+    }
+
+    ULONG failed = 0;
+    for (ULONG index : large)
+    {
+        if (!solve(index))
+        {
+            ++failed;
+        }
+    }
+
+    #ifdef _OPENMP
+    const int max_active_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:failed)
+    #endif
+    for (long position = 0; position < static_cast<long>(small.size()); ++position)
+    {
+        if (!solve(small[position]))
+        {
+            ++failed;
+        }
+    }
+    #ifdef _OPENMP
+    omp_set_max_active_levels(max_active_levels);
+    #endif
+    return failed;
+}
+
+}
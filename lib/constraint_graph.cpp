@@ -22,22 +22,14 @@
  * SOFTWARE.
  */
 #include <constraint_graph.hpp>
+#include <counters.hpp>
 #include <indexing.hpp>
 #include <indexing_checks.hpp>
 #include <types.hpp>
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
 #include <iostream>
-#endif
-
-#ifdef _OPENMP
-#define THREADS_NUMBER (omp_get_num_threads())
-#else
-#define THREADS_NUMBER (1)
+#include <tile_scheduler.hpp>
 #endif
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
@@ -49,11 +41,18 @@ namespace constraint
 {
 
 using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::graph::disparity::pixel_disparities;
 using sp::indexing::checks::edge_exists;
 using sp::indexing::checks::neighborhood_exists_fast;
+using sp::indexing::minimal_disparity;
 using sp::indexing::neighbor_by_index;
+using sp::indexing::node_disparity;
 using sp::indexing::node_index;
+using sp::indexing::nodes_pixel_index;
+using sp::scheduling::Tile;
+using sp::scheduling::TileScheduler;
 using sp::types::FALSE;
+using sp::types::FLOAT_ARRAY;
 using sp::types::TRUE;
 using sp::types::ULONG;
 
@@ -66,43 +65,48 @@ ConstraintGraph::ConstraintGraph(
     , lowest_penalties{lowest_penalties}
     , threshold{threshold}
 {
-    this->nodes_availability = BOOL_ARRAY(
-        disparity_graph->right.width
-        * disparity_graph->right.height
-        * disparity_graph->disparity_levels
-    );
-    fill(
-        this->nodes_availability.begin(),
-        this->nodes_availability.end(),
-        FALSE
+    this->nodes_availability = NodesAvailability(
+        disparity_graph->right.width * disparity_graph->right.height,
+        disparity_graph->disparity_levels
     );
 
-    struct Node node{{0, 0}, 0};
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
     for (
-        node.pixel.x = 0;
-        node.pixel.x < this->disparity_graph->right.width;
-        ++node.pixel.x
+        long y = 0;
+        y < static_cast<long>(this->disparity_graph->right.height);
+        ++y
     )
     {
+        FLOAT_ARRAY buffer;
+        struct Node node{{0, static_cast<ULONG>(y)}, 0};
         for (
-            node.pixel.y = 0;
-            node.pixel.y < this->disparity_graph->right.height;
-            ++node.pixel.y
+            node.pixel.x = 0;
+            node.pixel.x < this->disparity_graph->right.width;
+            ++node.pixel.x
         )
         {
+            const FLOAT* penalties = pixel_node_penalties(
+                this->disparity_graph,
+                node.pixel,
+                &buffer
+            );
+            const FLOAT lowest_penalty = lowest_pixel_penalty(
+                this->lowest_penalties,
+                node.pixel
+            );
+            const ULONG disparities = pixel_disparities(
+                this->disparity_graph,
+                node.pixel
+            );
             for (
                 node.disparity = 0;
-                node.pixel.x + node.disparity
-                    < this->disparity_graph->left.width
-                && node.disparity < this->disparity_graph->disparity_levels;
+                node.disparity < disparities;
                 ++node.disparity
             )
             {
-                if (
-                    node_penalty(this->disparity_graph, node)
-                    - lowest_pixel_penalty(this->lowest_penalties, node.pixel)
-                    <= threshold
-                )
+                if (penalties[node.disparity] - lowest_penalty <= threshold)
                 {
                     make_node_available(this, node);
                 }
@@ -117,8 +121,15 @@ __device__ void make_node_available(
     struct Node node
 )
 {
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    graph->nodes_availability.set(
+        nodes_pixel_index(graph->disparity_graph, node.pixel),
+        node.disparity
+    );
+    #else
     graph->nodes_availability[node_index(graph->disparity_graph, node)]
         = TRUE;
+    #endif
 }
 
 __device__ void make_node_unavailable(
@@ -126,12 +137,22 @@ __device__ void make_node_unavailable(
     struct Node node
 )
 {
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    graph->nodes_availability.reset(
+        nodes_pixel_index(graph->disparity_graph, node.pixel),
+        node.disparity
+    );
+    #else
     graph->nodes_availability[node_index(graph->disparity_graph, node)]
         = FALSE;
+    #endif
 }
 
 __device__ void make_all_nodes_unavailable(struct ConstraintGraph* graph)
 {
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    graph->nodes_availability.reset_all();
+    #else
     for (
         ULONG index = 0;
         index <
@@ -143,6 +164,7 @@ __device__ void make_all_nodes_unavailable(struct ConstraintGraph* graph)
     {
         graph->nodes_availability[index] = FALSE;
     }
+    #endif
 }
 
 __device__ BOOL is_node_available(
@@ -150,9 +172,32 @@ __device__ BOOL is_node_available(
     struct Node node
 )
 {
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    return graph->nodes_availability.test(
+        nodes_pixel_index(graph->disparity_graph, node.pixel),
+        node.disparity
+    );
+    #else
     return graph->nodes_availability[
         node_index(graph->disparity_graph, node)
     ];
+    #endif
+}
+
+__device__ ULONG next_available_disparity(
+    const struct ConstraintGraph* graph,
+    struct Pixel pixel,
+    ULONG disparity
+)
+{
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    return graph->nodes_availability.next(
+        nodes_pixel_index(graph->disparity_graph, pixel),
+        disparity
+    );
+    #else
+    return disparity;
+    #endif
 }
 
 __device__ BOOL is_edge_available(
@@ -160,6 +205,7 @@ __device__ BOOL is_edge_available(
     struct Edge edge
 )
 {
+    COUNT(EDGE_CHECKS, 1);
     return
         (edge_penalty(graph->disparity_graph, edge)
          - lowest_neighborhood_penalty(graph->lowest_penalties, edge)
@@ -178,11 +224,14 @@ __device__ BOOL should_remove_node(
     {
         return FALSE;
     }
+    COUNT(NODES_EXAMINED, 1);
 
     struct Edge edge;
     edge.node = node;
     edge.neighbor = node;
     ULONG initial_disparity = 0;
+    const ULONG node_value = node_disparity(graph->disparity_graph, node);
+    ULONG neighbor_minimum = 0;
     BOOL edge_found = FALSE;
 
     for (
@@ -203,12 +252,16 @@ __device__ BOOL should_remove_node(
         }
 
         edge.neighbor.pixel = neighbor_by_index(node.pixel, neighbor_index);
+        neighbor_minimum = minimal_disparity(
+            graph->disparity_graph,
+            edge.neighbor.pixel
+        );
         if (
             edge.node.pixel.x + 1 == edge.neighbor.pixel.x
-            && edge.node.disparity > 1
+            && node_value > neighbor_minimum + 1
         )
         {
-            initial_disparity = edge.node.disparity - 1;
+            initial_disparity = node_value - 1 - neighbor_minimum;
         }
         else
         {
@@ -217,16 +270,25 @@ __device__ BOOL should_remove_node(
 
         edge_found = FALSE;
         for (
-            edge.neighbor.disparity = initial_disparity;
-            edge.neighbor.pixel.x + edge.neighbor.disparity
+            edge.neighbor.disparity = next_available_disparity(
+                graph,
+                edge.neighbor.pixel,
+                initial_disparity
+            );
+            edge.neighbor.pixel.x + neighbor_minimum + edge.neighbor.disparity
                 < graph->disparity_graph->left.width
             && edge.neighbor.disparity
                 < graph->disparity_graph->disparity_levels;
-            ++edge.neighbor.disparity
+            edge.neighbor.disparity = next_available_disparity(
+                graph,
+                edge.neighbor.pixel,
+                edge.neighbor.disparity + 1
+            )
         )
         {
             if (is_edge_available(graph, edge))
             {
+                COUNT(EARLY_BREAKS, 1);
                 edge_found = TRUE;
                 break;
             }
@@ -241,6 +303,9 @@ __device__ BOOL should_remove_node(
 
 __device__ BOOL check_nodes_left(const struct ConstraintGraph* graph)
 {
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    return graph->nodes_availability.any();
+    #else
     for (
         ULONG index = 0;
         index <
@@ -256,6 +321,36 @@ __device__ BOOL check_nodes_left(const struct ConstraintGraph* graph)
         }
     }
     return FALSE;
+    #endif
+}
+
+__device__ BOOL check_pixel_nodes_left(
+    const struct ConstraintGraph* graph,
+    struct Pixel pixel
+)
+{
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    return graph->nodes_availability.any(
+        nodes_pixel_index(graph->disparity_graph, pixel)
+    );
+    #else
+    struct Node node;
+    node.pixel = pixel;
+    for (
+        node.disparity = 0;
+        node.pixel.x + node.disparity
+            < graph->disparity_graph->right.width
+        && node.disparity < graph->disparity_graph->disparity_levels;
+        ++node.disparity
+    )
+    {
+        if (is_node_available(graph, node))
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+    #endif
 }
 
 __device__ BOOL csp_process_pixel(
@@ -263,21 +358,31 @@ __device__ BOOL csp_process_pixel(
     struct Pixel pixel
 )
 {
+    if (!check_pixel_nodes_left(graph, pixel))
+    {
+        return FALSE;
+    }
+
     struct Node node;
     node.pixel = pixel;
 
     BOOL changed = FALSE;
     for (
-        node.disparity = 0;
+        node.disparity = next_available_disparity(graph, pixel, 0);
         node.pixel.x + node.disparity
             < graph->disparity_graph->right.width
         && node.disparity < graph->disparity_graph->disparity_levels;
-        ++node.disparity
+        node.disparity = next_available_disparity(
+            graph,
+            pixel,
+            node.disparity + 1
+        )
     )
     {
         if (should_remove_node(graph, node))
         {
             make_node_unavailable(graph, node);
+            COUNT(NODES_REMOVED, 1);
             changed = TRUE;
         }
     }
@@ -315,23 +420,15 @@ __device__ BOOL csp_solution_iteration(
             ++node.pixel.x
         )
         {
-            csp_process_pixel(graph, node.pixel);
-            pixel_available = FALSE;
-            for (
-                node.disparity = 0;
-                node.pixel.x + node.disparity
-                    < graph->disparity_graph->right.width
-                && node.disparity < graph->disparity_graph->disparity_levels;
-                ++node.disparity
-            )
+            if (csp_process_pixel(graph, node.pixel))
             {
-                if (is_node_available(graph, node))
-                {
-                    pixel_available = TRUE;
-                }
+                changed = TRUE;
             }
+            pixel_available = check_pixel_nodes_left(graph, node.pixel);
             if (!pixel_available)
             {
+                COUNT(COLLAPSED_PIXELS, 1);
+                COUNT(EARLY_BREAKS, 1);
                 break;
             }
         }
@@ -355,20 +452,50 @@ __device__ BOOL csp_solution_iteration(
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
 BOOL solve_csp(struct ConstraintGraph* graph)
 {
-    BOOL changed = TRUE;
-    #ifdef _OPENMP
-    #pragma omp parallel num_threads(1)
-    #endif
-    while (changed)
-    {
-        changed = FALSE;
-        #ifdef _OPENMP
-        #pragma omp parallel for reduction(||:changed)
-        #endif
-        for (int i = 0; i < THREADS_NUMBER; ++i)
+    const struct CspSchedule schedule{0, CSP_TILE_WIDTH, CSP_TILE_HEIGHT};
+    return solve_csp(graph, &schedule);
+}
+
+BOOL solve_csp(
+    struct ConstraintGraph* graph,
+    const struct CspSchedule* schedule
+)
+{
+    TileScheduler scheduler{
+        graph->disparity_graph->right.width,
+        graph->disparity_graph->right.height,
+        schedule->tile_width,
+        schedule->tile_height,
+        schedule->threads
+    };
+    scheduler.run(
+        [graph, &scheduler](const struct Tile& tile)
         {
-            changed |= csp_solution_iteration(graph, THREADS_NUMBER, i);
+            BOOL changed = FALSE;
+            struct Pixel pixel;
+            for (pixel.y = tile.y; pixel.y < tile.y + tile.height; ++pixel.y)
+            {
+                for (pixel.x = tile.x; pixel.x < tile.x + tile.width; ++pixel.x)
+                {
+                    if (csp_process_pixel(graph, pixel))
+                    {
+                        changed = TRUE;
+                    }
+                    if (!check_pixel_nodes_left(graph, pixel))
+                    {
+                        COUNT(COLLAPSED_PIXELS, 1);
+                        scheduler.stop();
+                        return changed;
+                    }
+                }
+            }
+            return changed;
         }
+    );
+    COUNT(CSP_SWEEPS, scheduler.get_sweeps());
+    if (scheduler.is_stopped())
+    {
+        make_all_nodes_unavailable(graph);
     }
     return check_nodes_left(graph);
 }
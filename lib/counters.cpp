@@ -0,0 +1,74 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <counters.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sp::counters
+{
+
+namespace
+{
+
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<struct ThreadCounters>> registry;
+
+}
+
+struct ThreadCounters* register_thread_counters()
+{
+    auto counters = std::make_unique<struct ThreadCounters>();
+    std::fill_n(counters->values, COUNTERS_COUNT, 0);
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    registry.push_back(std::move(counters));
+    return registry.back().get();
+}
+
+ULONG_ARRAY collect_counters()
+{
+    ULONG_ARRAY result(COUNTERS_COUNT, 0);
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    for (const auto& counters : registry)
+    {
+        for (ULONG counter = 0; counter < COUNTERS_COUNT; ++counter)
+        {
+            result[counter] += counters->values[counter];
+        }
+    }
+    return result;
+}
+
+void reset_counters()
+{
+    std::lock_guard<std::mutex> lock{registry_mutex};
+    for (const auto& counters : registry)
+    {
+        std::fill_n(counters->values, COUNTERS_COUNT, 0);
+    }
+}
+
+}
@@ -27,6 +27,8 @@
 
 #include <cassert>
 #include <cstdio>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 #define cdpErrchk(ans) { cdpAssert((ans), __FILE__, __LINE__); }
@@ -54,10 +56,17 @@ using std::vector;
 
 void prepare_problem(struct ConstraintGraph* graph, struct CUDAProblem* problem)
 {
-    vector<unsigned> left_image(
-        graph->disparity_graph->left.data.begin(),
-        graph->disparity_graph->left.data.end()
-    );
+    if (
+        graph->disparity_graph->left.max_value
+        > std::numeric_limits<unsigned short>::max()
+    )
+    {
+        throw std::invalid_argument(
+            "Intensities greater than 65535 are not supported by CUDA."
+        );
+    }
+    vector<unsigned short> left_image
+        = graph->disparity_graph->left.data.to_vector<unsigned short>();
     vector<float> min_penalties_edges(
         graph->lowest_penalties->neighborhoods.begin(),
         graph->lowest_penalties->neighborhoods.end()
@@ -66,18 +75,14 @@ void prepare_problem(struct ConstraintGraph* graph, struct CUDAProblem* problem)
         graph->lowest_penalties->pixels.begin(),
         graph->lowest_penalties->pixels.end()
     );
-    vector<int> nodes_availability(
-        graph->nodes_availability.begin(),
-        graph->nodes_availability.end()
-    );
+    vector<int> nodes_availability
+        = graph->nodes_availability.flatten<int>();
     vector<float> reparametrization(
         graph->disparity_graph->reparametrization.begin(),
         graph->disparity_graph->reparametrization.end()
     );
-    vector<unsigned> right_image(
-        graph->disparity_graph->right.data.begin(),
-        graph->disparity_graph->right.data.end()
-    );
+    vector<unsigned short> right_image
+        = graph->disparity_graph->right.data.to_vector<unsigned short>();
 
     cdpErrchk(cudaMalloc(
         (void**)&(problem->changed),
@@ -179,9 +184,9 @@ void csp_solution_cuda(
     struct CUDAProblem* problem
 )
 {
-    for (ULONG x = 0; x < graph->disparity_graph->right.width; ++x)
+    for (ULONG y = 0; y < graph->disparity_graph->right.height; ++y)
     {
-        for (ULONG y = 0; y < graph->disparity_graph->right.height; ++y)
+        for (ULONG x = 0; x < graph->disparity_graph->right.width; ++x)
         {
             cudaCheckError();
 
@@ -208,8 +213,8 @@ void csp_solution_cuda(
             );
 
             csp_iteration_cuda<<<
-                graph->disparity_graph->right.width,
-                graph->disparity_graph->right.height
+                graph->disparity_graph->right.height,
+                graph->disparity_graph->right.width
             >>>(
 
                 problem->nodes_availability,
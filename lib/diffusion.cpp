@@ -0,0 +1,241 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <diffusion.hpp>
+#include <indexing.hpp>
+#include <indexing_checks.hpp>
+#include <lowest_penalties.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sp::graph::diffusion
+{
+
+using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::graph::disparity::node_penalty;
+using sp::graph::disparity::pixel_disparities;
+using sp::graph::disparity::update_cached_node_penalties;
+using sp::graph::lowest_penalties::calculate_lowest_neighborhood_penalty_slow;
+using sp::graph::lowest_penalties::calculate_lowest_pixel_penalty;
+using sp::indexing::checks::neighborhood_exists_fast;
+using sp::indexing::minimal_disparity;
+using sp::indexing::neighbor_by_index;
+using sp::indexing::node_disparity;
+using sp::indexing::reparametrization_index_fast;
+using std::numeric_limits;
+
+FLOAT calculate_lowest_edge_penalty(
+    const struct DisparityGraph* graph,
+    struct Node node,
+    ULONG neighbor_index
+)
+{
+    const struct Node neighbor{neighbor_by_index(node.pixel, neighbor_index), 0};
+    const ULONG node_value = node_disparity(graph, node);
+    const ULONG neighbor_minimum = minimal_disparity(graph, neighbor.pixel);
+    ULONG first_disparity = 0;
+    ULONG last_disparity = pixel_disparities(graph, neighbor.pixel);
+    if (neighbor_index == 0 && node_value > neighbor_minimum + 1)
+    {
+        first_disparity = node_value - 1 - neighbor_minimum;
+    }
+    if (neighbor_index == 1)
+    {
+        last_disparity = node_value + 2 > neighbor_minimum
+            ? std::min(last_disparity, node_value + 2 - neighbor_minimum)
+            : 0;
+    }
+
+    const FLOAT node_reparametrization = graph->reparametrization[
+        reparametrization_index_fast(graph, node, neighbor_index)
+    ];
+    const FLOAT* neighbor_reparametrization = &graph->reparametrization[
+        reparametrization_index_fast(graph, neighbor, neighbor_index ^ 1)
+    ];
+    FLOAT lowest_penalty = numeric_limits<FLOAT>::infinity();
+    for (
+        ULONG disparity = first_disparity;
+        disparity < last_disparity;
+        ++disparity
+    )
+    {
+        const FLOAT difference
+            = static_cast<FLOAT>(node_value)
+            - static_cast<FLOAT>(neighbor_minimum + disparity);
+        lowest_penalty = std::min(
+            lowest_penalty,
+            graph->smoothness * difference * difference
+                - neighbor_reparametrization[disparity]
+        );
+    }
+    return lowest_penalty - node_reparametrization;
+}
+
+FLOAT diffusion_process_pixel(
+    struct DisparityGraph* graph,
+    struct Pixel pixel
+)
+{
+    FLOAT lowest_penalties[NEIGHBORS_COUNT];
+    FLOAT max_change = 0;
+    struct Node node{pixel, 0};
+    const ULONG disparities = pixel_disparities(graph, pixel);
+    for (
+        node.disparity = 0;
+        node.disparity < disparities;
+        ++node.disparity
+    )
+    {
+        FLOAT sum = node_penalty(graph, node);
+        ULONG count = 1;
+        for (
+            ULONG neighbor_index = 0;
+            neighbor_index < NEIGHBORS_COUNT;
+            ++neighbor_index
+        )
+        {
+            lowest_penalties[neighbor_index]
+                = numeric_limits<FLOAT>::infinity();
+            if (!neighborhood_exists_fast(graph, pixel, neighbor_index))
+            {
+                continue;
+            }
+            lowest_penalties[neighbor_index] = calculate_lowest_edge_penalty(
+                graph,
+                node,
+                neighbor_index
+            );
+            if (std::isfinite(lowest_penalties[neighbor_index]))
+            {
+                sum += lowest_penalties[neighbor_index];
+                ++count;
+            }
+        }
+        const FLOAT mean = sum / count;
+        for (
+            ULONG neighbor_index = 0;
+            neighbor_index < NEIGHBORS_COUNT;
+            ++neighbor_index
+        )
+        {
+            if (!std::isfinite(lowest_penalties[neighbor_index]))
+            {
+                continue;
+            }
+            const FLOAT change = lowest_penalties[neighbor_index] - mean;
+            graph->reparametrization[
+                reparametrization_index_fast(graph, node, neighbor_index)
+            ] += change;
+            max_change = std::max(max_change, std::abs(change));
+        }
+    }
+    update_cached_node_penalties(graph, pixel);
+    return max_change;
+}
+
+FLOAT diffusion_process_color(struct DisparityGraph* graph, ULONG color)
+{
+    FLOAT max_change = 0;
+    const auto height = static_cast<long>(graph->right.height);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(max:max_change)
+    #endif
+    for (long y = 0; y < height; ++y)
+    {
+        struct Pixel pixel{
+            (static_cast<ULONG>(y) + color) % 2,
+            static_cast<ULONG>(y)
+        };
+        for (; pixel.x < graph->right.width; pixel.x += 2)
+        {
+            max_change = std::max(
+                max_change,
+                diffusion_process_pixel(graph, pixel)
+            );
+        }
+    }
+    return max_change;
+}
+
+FLOAT diffusion_iteration(struct DisparityGraph* graph)
+{
+    return std::max(
+        diffusion_process_color(graph, 0),
+        diffusion_process_color(graph, 1)
+    );
+}
+
+ULONG diffusion(
+    struct DisparityGraph* graph,
+    ULONG max_iterations,
+    FLOAT tolerance
+)
+{
+    ULONG iterations = 0;
+    while (iterations < max_iterations)
+    {
+        ++iterations;
+        if (diffusion_iteration(graph) <= tolerance)
+        {
+            break;
+        }
+    }
+    return iterations;
+}
+
+FLOAT calculate_lower_bound(const struct DisparityGraph* graph)
+{
+    FLOAT lower_bound = 0;
+    const auto height = static_cast<long>(graph->right.height);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(+:lower_bound)
+    #endif
+    for (long y = 0; y < height; ++y)
+    {
+        struct Pixel pixel{0, static_cast<ULONG>(y)};
+        for (pixel.x = 0; pixel.x < graph->right.width; ++pixel.x)
+        {
+            lower_bound += calculate_lowest_pixel_penalty(graph, pixel);
+            for (ULONG neighbor_index : {0UL, 2UL})
+            {
+                if (neighborhood_exists_fast(graph, pixel, neighbor_index))
+                {
+                    lower_bound += calculate_lowest_neighborhood_penalty_slow(
+                        graph,
+                        pixel,
+                        neighbor_index
+                    );
+                }
+            }
+        }
+    }
+    return lower_bound;
+}
+
+}
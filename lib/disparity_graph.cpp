@@ -29,8 +29,19 @@
 #include <stdexcept>
 #include <string>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #define TO_FLOAT(x) (static_cast<FLOAT>(x))
 
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define SIMD_TARGET_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SIMD_TARGET_CLONES
+#endif
+
 #elif defined(__OPENCL_C_VERSION__)
 
 #define TO_FLOAT(x) (convert_float(x))
@@ -51,6 +62,10 @@ namespace graph
 namespace disparity
 {
 
+using sp::indexing::minimal_disparity;
+using sp::indexing::node_disparity;
+using sp::indexing::node_index;
+using sp::indexing::pixel_index;
 using sp::indexing::pixel_value;
 using sp::indexing::reparametrization_value;
 using sp::indexing::reparametrization_value_fast;
@@ -66,11 +81,13 @@ DisparityGraph::DisparityGraph(
     struct Image right,
     ULONG disparity_levels,
     FLOAT cleanness,
-    FLOAT smoothness
+    FLOAT smoothness,
+    FLOAT_ARRAY storage
 )
     : left{std::move(left)}
     , right{std::move(right)}
     , disparity_levels{disparity_levels}
+    , reparametrization{std::move(storage)}
     , cleanness{cleanness}
     , smoothness{smoothness}
 {
@@ -167,15 +184,11 @@ DisparityGraph::DisparityGraph(
         );
     }
 
-    this->reparametrization.resize(
+    this->reparametrization.assign(
         this->left.width
         * this->left.height
         * NEIGHBORS_COUNT
-        * this->disparity_levels
-    );
-    fill(
-        this->reparametrization.begin(),
-        this->reparametrization.end(),
+        * this->disparity_levels,
         static_cast<FLOAT>(0)
     );
 }
@@ -185,15 +198,32 @@ __device__ FLOAT edge_penalty(const struct DisparityGraph* graph, struct Edge ed
 {
     return
         graph->smoothness
-        * SQR(TO_FLOAT(edge.node.disparity) - TO_FLOAT(edge.neighbor.disparity))
+        * SQR(
+            TO_FLOAT(node_disparity(graph, edge.node))
+            - TO_FLOAT(node_disparity(graph, edge.neighbor))
+        )
         - reparametrization_value_slow(graph, edge)
         - reparametrization_value(graph, edge.neighbor, edge.node.pixel);
 }
 
 __device__ FLOAT node_penalty(const struct DisparityGraph* graph, struct Node node)
+{
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    if (!graph->node_penalties.empty())
+    {
+        return graph->node_penalties[node_index(graph, node)];
+    }
+    #endif
+    return calculate_node_penalty(graph, node);
+}
+
+__device__ FLOAT calculate_node_penalty(
+    const struct DisparityGraph* graph,
+    struct Node node
+)
 {
     struct Pixel left_pixel;
-    left_pixel.x = node.pixel.x + node.disparity;
+    left_pixel.x = node.pixel.x + node_disparity(graph, node);
     left_pixel.y = node.pixel.y;
     return
         graph->cleanness
@@ -206,6 +236,220 @@ __device__ FLOAT node_penalty(const struct DisparityGraph* graph, struct Node no
 }
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+namespace
+{
+
+/**
+ * \brief Calculate `count` penalties of nodes of one pixel.
+ *
+ * `left` points to the intensity of the left image
+ * that corresponds to zero disparity,
+ * `reparametrization` points to the first value of the pixel.
+ * Operations are the same as in sp::graph::disparity::calculate_node_penalty,
+ * so results are equal bit by bit.
+ */
+template <typename LeftPixel>
+SIMD_TARGET_CLONES
+void calculate_penalties_row(
+    FLOAT cleanness,
+    FLOAT right_value,
+    const LeftPixel* left,
+    const FLOAT* reparametrization,
+    ULONG disparity_levels,
+    ULONG count,
+    FLOAT* penalties
+)
+{
+    const FLOAT* right_reparametrization = reparametrization;
+    const FLOAT* left_reparametrization = right_reparametrization
+        + disparity_levels;
+    const FLOAT* down_reparametrization = left_reparametrization
+        + disparity_levels;
+    const FLOAT* up_reparametrization = down_reparametrization
+        + disparity_levels;
+    #ifdef _OPENMP
+    #pragma omp simd
+    #endif
+    for (ULONG disparity = 0; disparity < count; ++disparity)
+    {
+        penalties[disparity]
+            = cleanness * SQR(right_value - TO_FLOAT(left[disparity]))
+            + right_reparametrization[disparity]
+            + left_reparametrization[disparity]
+            + down_reparametrization[disparity]
+            + up_reparametrization[disparity];
+    }
+}
+
+/**
+ * \brief Calculate penalties of all nodes of the pixel
+ * reading intensities of the actual types directly.
+ */
+template <typename LeftPixel, typename RightPixel>
+void calculate_pixel_node_penalties(
+    const struct DisparityGraph* graph,
+    struct Pixel pixel,
+    const LeftPixel* left,
+    const RightPixel* right,
+    FLOAT* penalties
+)
+{
+    const ULONG index = pixel_index(&(graph->right), pixel);
+    calculate_penalties_row(
+        graph->cleanness,
+        TO_FLOAT(right[index]),
+        left + index + minimal_disparity(graph, pixel),
+        graph->reparametrization.data()
+            + index * NEIGHBORS_COUNT * graph->disparity_levels,
+        graph->disparity_levels,
+        pixel_disparities(graph, pixel),
+        penalties
+    );
+}
+
+}
+
+void cache_node_penalties(struct DisparityGraph* graph)
+{
+    graph->node_penalties.assign(
+        graph->right.width * graph->right.height * graph->disparity_levels,
+        numeric_limits<FLOAT>::infinity()
+    );
+    const auto height = static_cast<long>(graph->right.height);
+    graph->left.data.visit([graph, height](const auto* left)
+    {
+        graph->right.data.visit([graph, height, left](const auto* right)
+        {
+            #ifdef _OPENMP
+            #pragma omp parallel for schedule(static)
+            #endif
+            for (long y = 0; y < height; ++y)
+            {
+                struct Pixel pixel{0, static_cast<ULONG>(y)};
+                for (pixel.x = 0; pixel.x < graph->right.width; ++pixel.x)
+                {
+                    calculate_pixel_node_penalties(
+                        graph,
+                        pixel,
+                        left,
+                        right,
+                        graph->node_penalties.data()
+                            + node_index(graph, {pixel, 0})
+                    );
+                }
+            }
+        });
+    });
+}
+
+void update_cached_node_penalties(
+    struct DisparityGraph* graph,
+    struct Pixel pixel
+)
+{
+    if (graph->node_penalties.empty())
+    {
+        return;
+    }
+    graph->left.data.visit([graph, pixel](const auto* left)
+    {
+        graph->right.data.visit([graph, pixel, left](const auto* right)
+        {
+            calculate_pixel_node_penalties(
+                graph,
+                pixel,
+                left,
+                right,
+                graph->node_penalties.data() + node_index(graph, {pixel, 0})
+            );
+        });
+    });
+}
+
+void drop_cached_node_penalties(struct DisparityGraph* graph)
+{
+    graph->node_penalties.clear();
+    graph->node_penalties.shrink_to_fit();
+}
+
+void set_minimal_disparities(
+    struct DisparityGraph* graph,
+    ULONG_ARRAY minimal_disparities
+)
+{
+    if (
+        !minimal_disparities.empty()
+        && minimal_disparities.size()
+            != graph->right.width * graph->right.height
+    )
+    {
+        throw invalid_argument(
+            "Number of minimal disparities should be equal "
+            "to the number of pixels. Provided "
+            + to_string(minimal_disparities.size())
+            + " minimal disparities for "
+            + to_string(graph->right.width * graph->right.height)
+            + " pixels."
+        );
+    }
+    for (ULONG index = 0; index < minimal_disparities.size(); ++index)
+    {
+        if (
+            index % graph->right.width + minimal_disparities[index]
+            >= graph->left.width
+        )
+        {
+            throw invalid_argument(
+                "Minimal disparity "
+                + to_string(minimal_disparities[index])
+                + " of the pixel "
+                + to_string(index)
+                + " exceeds the left image."
+            );
+        }
+    }
+    graph->minimal_disparities = move(minimal_disparities);
+    if (!graph->node_penalties.empty())
+    {
+        cache_node_penalties(graph);
+    }
+}
+
+ULONG pixel_disparities(const struct DisparityGraph* graph, struct Pixel pixel)
+{
+    const ULONG start = pixel.x + minimal_disparity(graph, pixel);
+    return start + graph->disparity_levels < graph->left.width + 1
+        ? graph->disparity_levels
+        : graph->left.width - start;
+}
+
+const FLOAT* pixel_node_penalties(
+    const struct DisparityGraph* graph,
+    struct Pixel pixel,
+    FLOAT_ARRAY* buffer
+)
+{
+    if (!graph->node_penalties.empty())
+    {
+        return graph->node_penalties.data() + node_index(graph, {pixel, 0});
+    }
+    buffer->resize(graph->disparity_levels);
+    graph->left.data.visit([graph, pixel, buffer](const auto* left)
+    {
+        graph->right.data.visit([graph, pixel, buffer, left](const auto* right)
+        {
+            calculate_pixel_node_penalties(
+                graph,
+                pixel,
+                left,
+                right,
+                buffer->data()
+            );
+        });
+    });
+    return buffer->data();
+}
+
 }
 }
 }
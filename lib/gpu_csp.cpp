@@ -2,6 +2,8 @@
 #include <gpu_csp.hpp>
 
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -29,24 +31,31 @@ void build_csp_program(struct Problem* problem)
 
 void prepare_problem(struct ConstraintGraph* graph, struct Problem* problem)
 {
+    if (
+        graph->disparity_graph->left.max_value
+        > std::numeric_limits<cl_ushort>::max()
+    )
+    {
+        throw std::invalid_argument(
+            "Intensities greater than 65535 are not supported by OpenCL."
+        );
+    }
+    vector<cl_ushort> left_image
+        = graph->disparity_graph->left.data.to_vector<cl_ushort>();
     problem->left_image.clear();
-    problem->left_image.reserve(
-        graph->disparity_graph->left.data.size(),
-        problem->queue
-    );
+    problem->left_image.reserve(left_image.size(), problem->queue);
     std::copy(
-        graph->disparity_graph->left.data.begin(),
-        graph->disparity_graph->left.data.end(),
+        left_image.begin(),
+        left_image.end(),
         std::back_inserter(problem->left_image)
     );
+    vector<cl_ushort> right_image
+        = graph->disparity_graph->right.data.to_vector<cl_ushort>();
     problem->right_image.clear();
-    problem->right_image.reserve(
-        graph->disparity_graph->right.data.size(),
-        problem->queue
-    );
+    problem->right_image.reserve(right_image.size(), problem->queue);
     std::copy(
-        graph->disparity_graph->right.data.begin(),
-        graph->disparity_graph->right.data.end(),
+        right_image.begin(),
+        right_image.end(),
         std::back_inserter(problem->right_image)
     );
     problem->min_penalties_pixels.clear();
@@ -88,14 +97,16 @@ BOOL csp_solution_cl(
 {
     command_queue queue = system::default_queue();
 
+    std::vector<cl_int> nodes_availability_flags
+        = graph->nodes_availability.flatten<cl_int>();
     compute::vector<cl_int> nodes_availability;
     nodes_availability.reserve(
-        graph->nodes_availability.size(),
+        nodes_availability_flags.size(),
         problem->queue
     );
     std::copy(
-        graph->nodes_availability.begin(),
-        graph->nodes_availability.end(),
+        nodes_availability_flags.begin(),
+        nodes_availability_flags.end(),
         std::back_inserter(nodes_availability)
     );
 
@@ -143,9 +154,9 @@ BOOL csp_solution_cl(
     auto x_index = static_cast<cl_ulong>(choose_best_node_gpu.arity() - 2);
     auto y_index = static_cast<cl_ulong>(choose_best_node_gpu.arity() - 1);
 
-    for (ULONG x = 0; x < graph->disparity_graph->right.width; ++x)
+    for (ULONG y = 0; y < graph->disparity_graph->right.height; ++y)
     {
-        for (ULONG y = 0; y < graph->disparity_graph->right.height; ++y)
+        for (ULONG x = 0; x < graph->disparity_graph->right.width; ++x)
         {
             choose_best_node_gpu.set_arg(x_index, x);
             choose_best_node_gpu.set_arg(y_index, y);
@@ -166,11 +177,14 @@ BOOL csp_solution_cl(
         }
     }
 
-    graph->nodes_availability.clear();
     std::copy(
         nodes_availability.begin(),
         nodes_availability.end(),
-        std::back_inserter(graph->nodes_availability)
+        nodes_availability_flags.begin()
+    );
+    graph->nodes_availability.assign(
+        nodes_availability_flags.begin(),
+        nodes_availability_flags.end()
     );
     return changed[1] != 0;
 }
@@ -24,10 +24,182 @@
 #include <image.hpp>
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
 namespace sp
 {
 namespace image
 {
+
+using std::numeric_limits;
+using std::uint16_t;
+using std::uint8_t;
+using std::vector;
+
+namespace
+{
+
+/**
+ * \brief Narrowest storage of `size` zero intensities
+ * that can hold `max_value`.
+ */
+template <typename Variant>
+Variant make_values(ULONG size, ULONG max_value)
+{
+    if (max_value <= numeric_limits<uint8_t>::max())
+    {
+        return vector<uint8_t>(size, 0);
+    }
+    if (max_value <= numeric_limits<uint16_t>::max())
+    {
+        return vector<uint16_t>(size, 0);
+    }
+    return vector<ULONG>(size, 0);
+}
+
+/**
+ * \brief Maximal value of the array.
+ */
+template <typename Iterator>
+ULONG max_element_value(Iterator begin, Iterator end)
+{
+    return begin == end ? 0 : *std::max_element(begin, end);
+}
+
+}
+
+Pixels::Reference::Reference(Pixels* pixels, ULONG index)
+    : pixels{pixels}
+    , index{index}
+{
+}
+
+Pixels::Reference::operator ULONG() const
+{
+    return static_cast<const Pixels&>(*this->pixels)[this->index];
+}
+
+Pixels::Reference& Pixels::Reference::operator=(ULONG value)
+{
+    this->pixels->set(this->index, value);
+    return *this;
+}
+
+Pixels::Reference& Pixels::Reference::operator=(const Reference& other)
+{
+    return *this = static_cast<ULONG>(other);
+}
+
+Pixels::Pixels(std::initializer_list<ULONG> values)
+    : values{make_values<decltype(this->values)>(
+        values.size(),
+        max_element_value(values.begin(), values.end())
+    )}
+{
+    ULONG index = 0;
+    for (ULONG value : values)
+    {
+        this->set(index++, value);
+    }
+}
+
+Pixels::Pixels(const ULONG_ARRAY& values)
+    : values{make_values<decltype(this->values)>(
+        values.size(),
+        max_element_value(values.begin(), values.end())
+    )}
+{
+    this->visit(
+        [&values](auto* data)
+        {
+            std::copy(values.begin(), values.end(), data);
+        }
+    );
+}
+
+Pixels::Pixels(ULONG size, ULONG max_value)
+    : values{make_values<decltype(this->values)>(size, max_value)}
+{
+}
+
+ULONG Pixels::size() const
+{
+    return std::visit(
+        [](const auto& values) -> ULONG { return values.size(); },
+        this->values
+    );
+}
+
+ULONG Pixels::bytes_per_pixel() const
+{
+    return std::visit(
+        [](const auto& values) -> ULONG { return sizeof(values[0]); },
+        this->values
+    );
+}
+
+Pixels::Reference Pixels::operator[](ULONG index)
+{
+    return Reference{this, index};
+}
+
+void Pixels::set(ULONG index, ULONG value)
+{
+    if (
+        (this->values.index() == 0
+            && value > numeric_limits<uint8_t>::max())
+        || (this->values.index() == 1
+            && value > numeric_limits<uint16_t>::max())
+    )
+    {
+        this->widen(value);
+    }
+    this->visit(
+        [index, value](auto* data)
+        {
+            using Value = std::remove_reference_t<decltype(*data)>;
+            data[index] = static_cast<Value>(value);
+        }
+    );
+}
+
+void Pixels::widen(ULONG max_value)
+{
+    vector<ULONG> current = this->to_vector();
+    this->values = make_values<decltype(this->values)>(
+        current.size(),
+        std::max(max_value, max_element_value(current.begin(), current.end()))
+    );
+    this->visit(
+        [&current](auto* data)
+        {
+            std::copy(current.begin(), current.end(), data);
+        }
+    );
+}
+
+bool operator==(const Pixels& lhs, const Pixels& rhs)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    for (ULONG index = 0; index < lhs.size(); ++index)
+    {
+        if (lhs[index] != rhs[index])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool operator!=(const Pixels& lhs, const Pixels& rhs)
+{
+    return !(lhs == rhs);
+}
 #endif
 
 BOOL image_valid(const struct Image* image)
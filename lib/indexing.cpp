@@ -77,15 +77,11 @@ __device__ ULONG reparametrization_index_fast(
     ULONG neighbor_index
 )
 {
-    ULONG index = 0;
-    index *= graph->right.width;
-    index += node.pixel.x;
+    ULONG index = nodes_pixel_index(graph, node.pixel);
     index *= NEIGHBORS_COUNT;
     index += neighbor_index;
     index *= graph->disparity_levels;
     index += node.disparity;
-    index *= graph->left.height;
-    index += node.pixel.y;
 
     return index;
 }
@@ -143,10 +139,40 @@ __device__ FLOAT reparametrization_value_fast(
     ];
 }
 
+__device__ ULONG nodes_pixel_index(
+    const struct DisparityGraph* graph,
+    struct Pixel pixel
+)
+{
+    return pixel_index(&(graph->right), pixel);
+}
+
+__device__ ULONG minimal_disparity(
+    const struct DisparityGraph* graph,
+    struct Pixel pixel
+)
+{
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    if (!graph->minimal_disparities.empty())
+    {
+        return graph->minimal_disparities[nodes_pixel_index(graph, pixel)];
+    }
+    #endif
+    return 0;
+}
+
+__device__ ULONG node_disparity(
+    const struct DisparityGraph* graph,
+    struct Node node
+)
+{
+    return minimal_disparity(graph, node.pixel) + node.disparity;
+}
+
 __device__ ULONG node_index(const struct DisparityGraph* graph, struct Node node)
 {
     return node.disparity + graph->disparity_levels
-        * (node.pixel.y + graph->right.height * node.pixel.x);
+        * nodes_pixel_index(graph, node.pixel);
 }
 
 __device__ ULONG neighborhood_index_fast(
@@ -156,7 +182,7 @@ __device__ ULONG neighborhood_index_fast(
 )
 {
     return neighbor_index
-        + NEIGHBORS_COUNT * (pixel.y + graph->right.height * pixel.x);
+        + NEIGHBORS_COUNT * nodes_pixel_index(graph, pixel);
 }
 
 __device__ ULONG neighborhood_index(
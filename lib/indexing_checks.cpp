@@ -73,7 +73,7 @@ __device__ BOOL node_exists(
         node.disparity >= graph->disparity_levels
         || node.pixel.y >= graph->right.height
         || node.pixel.x >= graph->right.width
-        || node.pixel.x + node.disparity >= graph->left.width
+        || node.pixel.x + node_disparity(graph, node) >= graph->left.width
     );
 }
 
@@ -100,13 +100,15 @@ __device__ BOOL edge_exists(
         return true;
     }
 
+    const ULONG node_value = node_disparity(graph, edge.node);
+    const ULONG neighbor_value = node_disparity(graph, edge.neighbor);
     if (edge.node.pixel.x + 1 == edge.neighbor.pixel.x
-        && edge.node.disparity > edge.neighbor.disparity + 1)
+        && node_value > neighbor_value + 1)
     {
         return false;
     }
     if (edge.node.pixel.x == edge.neighbor.pixel.x + 1
-        && edge.node.disparity + 1 < edge.neighbor.disparity)
+        && node_value + 1 < neighbor_value)
     {
         return false;
     }
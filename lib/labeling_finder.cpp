@@ -21,11 +21,14 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <counters.hpp>
 #include <indexing.hpp>
 #include <indexing_checks.hpp>
 #include <labeling_finder.hpp>
 
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+#include <arc_consistency.hpp>
+
 #ifdef USE_OPENCL
 #include <gpu_csp.hpp>
 #endif
@@ -33,10 +36,24 @@
 #include <cuda_csp.hpp>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <stdexcept>
+#include <vector>
+
+#ifdef _OPENMP
+#define MAX_THREADS_NUMBER (omp_get_max_threads())
+#define THREAD_ID (omp_get_thread_num())
+#else
+#define MAX_THREADS_NUMBER (1)
+#define THREAD_ID (0)
+#endif
 
 namespace sp
 {
@@ -45,12 +62,24 @@ namespace labeling
 namespace finder
 {
 
+using sp::graph::arc_consistency::ArcConsistency;
+using sp::graph::arc_consistency::propagate;
+using sp::graph::arc_consistency::propagate_from;
+using sp::graph::arc_consistency::solve_csp_worklist;
 using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::graph::disparity::pixel_disparities;
+using sp::image::Pixels;
 using sp::indexing::checks::neighborhood_exists_fast;
+using sp::indexing::minimal_disparity;
 using sp::indexing::neighbor_by_index;
+using sp::indexing::node_disparity;
+using sp::indexing::node_index;
+using sp::indexing::nodes_pixel_index;
 using sp::indexing::pixel_index;
 using sp::types::BOOL;
+using sp::types::FALSE;
 using sp::types::Node;
+using sp::types::TRUE;
 using sp::types::ULONG;
 using sp::types::ULONG_ARRAY;
 #ifdef USE_OPENCL
@@ -66,6 +95,7 @@ using std::sort;
 using std::swap;
 using std::to_string;
 using std::unique;
+using std::upper_bound;
 
 __device__ FLOAT_ARRAY fetch_pixel_available_penalties(
     const DisparityGraph* graph,
@@ -73,27 +103,15 @@ __device__ FLOAT_ARRAY fetch_pixel_available_penalties(
     FLOAT minimal_penalty
 )
 {
-    FLOAT_ARRAY result(
-        pixel.x + graph->disparity_levels < graph->left.width + 1
-        ? graph->disparity_levels
-        : graph->left.width - pixel.x
-    );
-    struct Node node{pixel, 0};
-    for (
-        node.disparity = 0;
-        node.disparity < result.size();
-        ++node.disparity
-    )
+    FLOAT_ARRAY buffer;
+    const FLOAT* penalties = pixel_node_penalties(graph, pixel, &buffer);
+    FLOAT_ARRAY result(penalties, penalties + pixel_disparities(graph, pixel));
+    for (FLOAT& penalty : result)
     {
-        result[node.disparity] = (
-            node_penalty(graph, node)
-            - minimal_penalty
-        );
+        penalty -= minimal_penalty;
     }
 
-    std::sort(result.begin(), result.end());
-    auto last = std::unique(result.begin(), result.end());
-    result.erase(last, result.end());
+    squeeze_available_penalties(&result);
 
     return result;
 }
@@ -107,15 +125,19 @@ __device__ FLOAT_ARRAY fetch_edge_available_penalties(
     FLOAT_ARRAY result;
 
     ULONG initial_disparity = 0;
+    ULONG node_value = 0;
+    const ULONG neighbor_minimum
+        = minimal_disparity(graph, edge.neighbor.pixel);
     for (
         edge.node.disparity = 0;
-        edge.node.pixel.x + edge.node.disparity < graph->left.width
+        edge.node.pixel.x + node_disparity(graph, edge.node) < graph->left.width
             && edge.node.disparity < graph->disparity_levels;
         ++edge.node.disparity
     )
     {
+        node_value = node_disparity(graph, edge.node);
         if (
-            edge.node.disparity <= 1
+            node_value <= neighbor_minimum + 1
             || edge.neighbor.pixel.x == edge.node.pixel.x
         )
         {
@@ -123,11 +145,12 @@ __device__ FLOAT_ARRAY fetch_edge_available_penalties(
         }
         else
         {
-            initial_disparity = edge.node.disparity - 1;
+            initial_disparity = node_value - 1 - neighbor_minimum;
         }
         for (
             edge.neighbor.disparity = initial_disparity;
-            edge.neighbor.pixel.x + edge.neighbor.disparity < graph->left.width
+            edge.neighbor.pixel.x + neighbor_minimum + edge.neighbor.disparity
+                < graph->left.width
                 && edge.neighbor.disparity < graph->disparity_levels;
             ++edge.neighbor.disparity
         )
@@ -136,92 +159,251 @@ __device__ FLOAT_ARRAY fetch_edge_available_penalties(
         }
     }
 
-    std::sort(result.begin(), result.end());
-    auto last = std::unique(result.begin(), result.end());
-    result.erase(last, result.end());
+    squeeze_available_penalties(&result);
 
     return result;
 }
 
+__device__ void squeeze_available_penalties(FLOAT_ARRAY* penalties)
+{
+    std::sort(penalties->begin(), penalties->end());
+    auto last = std::unique(penalties->begin(), penalties->end());
+    penalties->erase(last, penalties->end());
+}
+
 __device__ FLOAT_ARRAY fetch_available_penalties(
     const struct LowestPenalties* lowest_penalties
 )
 {
-    FLOAT_ARRAY result;
-    FLOAT_ARRAY result_;
-    FLOAT_ARRAY available_penalties;
-    struct Pixel pixel{0, 0};
-    for (pixel.x = 0; pixel.x < lowest_penalties->graph->right.width; ++pixel.x)
+    const struct DisparityGraph* graph = lowest_penalties->graph;
+    std::vector<FLOAT_ARRAY> buffers(MAX_THREADS_NUMBER);
+
+    #ifdef _OPENMP
+    #pragma omp parallel
+    #endif
+    {
+        FLOAT_ARRAY& buffer = buffers[THREAD_ID];
+        FLOAT_ARRAY available_penalties;
+        ULONG squeezed_size = 0;
+
+        #ifdef _OPENMP
+        #pragma omp for schedule(static)
+        #endif
+        for (long y = 0; y < static_cast<long>(graph->right.height); ++y)
+        {
+            struct Pixel pixel{0, static_cast<ULONG>(y)};
+            for (pixel.x = 0; pixel.x < graph->right.width; ++pixel.x)
+            {
+                available_penalties = fetch_pixel_available_penalties(
+                    graph,
+                    pixel,
+                    lowest_pixel_penalty(lowest_penalties, pixel)
+                );
+                buffer.insert(
+                    buffer.end(),
+                    available_penalties.begin(),
+                    available_penalties.end()
+                );
+
+                for (
+                    ULONG neighbor_index = 0;
+                    neighbor_index < NEIGHBORS_COUNT;
+                    ++neighbor_index
+                )
+                {
+                    if (!neighborhood_exists_fast(graph, pixel, neighbor_index))
+                    {
+                        continue;
+                    }
+                    Edge edge{
+                        {pixel, 0},
+                        {neighbor_by_index(pixel, neighbor_index), 0}
+                    };
+                    available_penalties = fetch_edge_available_penalties(
+                        graph,
+                        edge,
+                        lowest_neighborhood_penalty(lowest_penalties, edge)
+                    );
+                    buffer.insert(
+                        buffer.end(),
+                        available_penalties.begin(),
+                        available_penalties.end()
+                    );
+                }
+
+                if (buffer.size() > 2 * squeezed_size + PENALTIES_CHUNK_SIZE)
+                {
+                    squeeze_available_penalties(&buffer);
+                    squeezed_size = buffer.size();
+                }
+            }
+        }
+        squeeze_available_penalties(&buffer);
+    }
+
+    for (ULONG step = 1; step < buffers.size(); step *= 2)
     {
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+        #endif
         for (
-            pixel.y = 0;
-            pixel.y < lowest_penalties->graph->right.height;
-            ++pixel.y)
+            long first = 0;
+            first < static_cast<long>(buffers.size());
+            first += static_cast<long>(2 * step)
+        )
         {
-            available_penalties = fetch_pixel_available_penalties(
-                lowest_penalties->graph,
-                pixel,
-                lowest_pixel_penalty(lowest_penalties, pixel)
-            );
+            if (static_cast<ULONG>(first) + step >= buffers.size())
+            {
+                continue;
+            }
+            FLOAT_ARRAY& result = buffers[first];
+            FLOAT_ARRAY& other = buffers[first + step];
+            FLOAT_ARRAY merged;
+            merged.reserve(result.size() + other.size());
             std::merge(
                 result.begin(),
                 result.end(),
-                available_penalties.begin(),
-                available_penalties.end(),
-                std::back_inserter(result_)
+                other.begin(),
+                other.end(),
+                std::back_inserter(merged)
             );
-            std::swap(result, result_);
-            result_.clear();
-            available_penalties.clear();
+            auto last = std::unique(merged.begin(), merged.end());
+            merged.erase(last, merged.end());
+            std::swap(result, merged);
+            FLOAT_ARRAY{}.swap(other);
+        }
+    }
+    return buffers[0];
+}
 
-            std::sort(result.begin(), result.end());
-            auto last = std::unique(result.begin(), result.end());
-            result.erase(last, result.end());
+__device__ FLOAT_ARRAY quantize_available_penalties(
+    FLOAT_ARRAY available_penalties,
+    ULONG bins
+)
+{
+    if (bins == 0 || available_penalties.size() <= bins)
+    {
+        return available_penalties;
+    }
+
+    const FLOAT minimum = available_penalties.front();
+    const FLOAT bin_width
+        = (available_penalties.back() - minimum) / static_cast<FLOAT>(bins);
+
+    FLOAT_ARRAY result;
+    result.reserve(bins);
+    ULONG current_bin = 0;
+    for (FLOAT penalty : available_penalties)
+    {
+        ULONG bin = bin_width > 0
+            ? static_cast<ULONG>((penalty - minimum) / bin_width)
+            : 0;
+        bin = MIN(bin, bins - 1);
+        if (!result.empty() && bin == current_bin)
+        {
+            result.back() = penalty;
+        }
+        else
+        {
+            result.push_back(penalty);
+            current_bin = bin;
+        }
+    }
+    return result;
+}
 
+ThresholdSearch::ThresholdSearch(
+    const struct DisparityGraph* disparity_graph,
+    const struct LowestPenalties* lowest_penalties
+)
+    : disparity_graph{disparity_graph}
+    , lowest_penalties{lowest_penalties}
+    , probes{0}
+{
+    const struct DisparityGraph* graph = disparity_graph;
+    this->nodes_slacks.assign(
+        graph->right.width * graph->right.height * graph->disparity_levels,
+        std::numeric_limits<FLOAT>::infinity()
+    );
+
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long y = 0; y < static_cast<long>(graph->right.height); ++y)
+    {
+        FLOAT_ARRAY buffer;
+        struct Node node{{0, static_cast<ULONG>(y)}, 0};
+        for (node.pixel.x = 0; node.pixel.x < graph->right.width; ++node.pixel.x)
+        {
+            FLOAT lowest_penalty = lowest_pixel_penalty(
+                lowest_penalties,
+                node.pixel
+            );
+            const FLOAT* penalties
+                = pixel_node_penalties(graph, node.pixel, &buffer);
+            const ULONG disparities = pixel_disparities(graph, node.pixel);
             for (
-                ULONG neighbor_index = 0;
-                neighbor_index < NEIGHBORS_COUNT;
-                ++neighbor_index
+                node.disparity = 0;
+                node.disparity < disparities;
+                ++node.disparity
             )
             {
-                if (
-                    !neighborhood_exists_fast(
-                        lowest_penalties->graph, pixel, neighbor_index
-                    )
-                )
+                this->nodes_slacks[node_index(graph, node)]
+                    = penalties[node.disparity] - lowest_penalty;
+            }
+        }
+    }
+}
+
+BOOL probe_threshold(struct ThresholdSearch* search, FLOAT threshold)
+{
+    const struct DisparityGraph* graph = search->disparity_graph;
+    const BOOL warm = search->consistent_nodes.get_pixels() != 0;
+    ++search->probes;
+
+    struct ConstraintGraph constraint_graph;
+    constraint_graph.disparity_graph = graph;
+    constraint_graph.lowest_penalties = search->lowest_penalties;
+    constraint_graph.threshold = threshold;
+    constraint_graph.nodes_availability = NodesAvailability(
+        graph->right.width * graph->right.height,
+        graph->disparity_levels
+    );
+
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long y = 0; y < static_cast<long>(graph->right.height); ++y)
+    {
+        struct Node node{{0, static_cast<ULONG>(y)}, 0};
+        for (node.pixel.x = 0; node.pixel.x < graph->right.width; ++node.pixel.x)
+        {
+            ULONG pixel = nodes_pixel_index(graph, node.pixel);
+            const ULONG disparities = pixel_disparities(graph, node.pixel);
+            for (
+                node.disparity = warm
+                    ? search->consistent_nodes.next(pixel, 0)
+                    : 0;
+                node.disparity < disparities;
+                node.disparity = warm
+                    ? search->consistent_nodes.next(pixel, node.disparity + 1)
+                    : node.disparity + 1
+            )
+            {
+                if (search->nodes_slacks[node_index(graph, node)] <= threshold)
                 {
-                    continue;
+                    make_node_available(&constraint_graph, node);
                 }
-                Edge edge{
-                    {pixel, 0},
-                    {neighbor_by_index(pixel, neighbor_index), 0}
-                };
-                available_penalties = fetch_edge_available_penalties(
-                    lowest_penalties->graph,
-                    edge,
-                    lowest_neighborhood_penalty(
-                        lowest_penalties,
-                        edge
-                    )
-                );
-                std::merge(
-                    result.begin(),
-                    result.end(),
-                    available_penalties.begin(),
-                    available_penalties.end(),
-                    std::back_inserter(result_)
-                );
-                std::swap(result, result_);
-                result_.clear();
-                available_penalties.clear();
-
-                std::sort(result.begin(), result.end());
-                auto last = std::unique(result.begin(), result.end());
-                result.erase(last, result.end());
             }
         }
     }
-    return result;
+
+    if (!solve_csp_worklist(&constraint_graph))
+    {
+        return false;
+    }
+    search->consistent_nodes = std::move(constraint_graph.nodes_availability);
+    return true;
 }
 
 __device__ FLOAT calculate_minimal_consistent_threshold(
@@ -229,6 +411,15 @@ __device__ FLOAT calculate_minimal_consistent_threshold(
     const struct DisparityGraph* disparity_graph,
     FLOAT_ARRAY available_penalties
 )
+{
+    struct ThresholdSearch search{disparity_graph, lowest_penalties};
+    return calculate_minimal_consistent_threshold(&search, available_penalties);
+}
+
+FLOAT calculate_minimal_consistent_threshold(
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties
+)
 {
     ULONG start = 0;
     ULONG end = available_penalties.size() - 1;
@@ -239,12 +430,7 @@ __device__ FLOAT calculate_minimal_consistent_threshold(
         current_index = (start + end) / 2
     )
     {
-        struct ConstraintGraph constraint_graph{
-            disparity_graph,
-            lowest_penalties,
-            available_penalties[current_index]
-        };
-        if (solve_csp(&constraint_graph))
+        if (probe_threshold(search, available_penalties[current_index]))
         {
             end = current_index;
         }
@@ -255,6 +441,93 @@ __device__ FLOAT calculate_minimal_consistent_threshold(
     }
     return available_penalties[current_index];
 }
+
+__device__ FLOAT calculate_approximate_consistent_threshold(
+    const struct LowestPenalties* lowest_penalties,
+    const struct DisparityGraph* disparity_graph,
+    FLOAT_ARRAY available_penalties,
+    FLOAT tolerance
+)
+{
+    struct ThresholdSearch search{disparity_graph, lowest_penalties};
+    return calculate_approximate_consistent_threshold(
+        &search,
+        available_penalties,
+        tolerance
+    );
+}
+
+FLOAT calculate_approximate_consistent_threshold(
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties,
+    FLOAT tolerance
+)
+{
+    FLOAT_ARRAY coarse_penalties = quantize_available_penalties(
+        available_penalties,
+        APPROXIMATE_THRESHOLD_BINS
+    );
+    ULONG coarse_start = 0;
+    ULONG coarse_end = coarse_penalties.size() - 1;
+    while (coarse_start < coarse_end)
+    {
+        ULONG current_index = (coarse_start + coarse_end) / 2;
+        if (probe_threshold(search, coarse_penalties[current_index]))
+        {
+            coarse_end = current_index;
+        }
+        else
+        {
+            coarse_start = current_index + 1;
+        }
+    }
+    FLOAT upper = coarse_penalties[coarse_end];
+
+    auto coarse_position = std::lower_bound(
+        coarse_penalties.begin(),
+        coarse_penalties.end(),
+        upper
+    );
+    ULONG start = 0;
+    if (coarse_position != coarse_penalties.begin())
+    {
+        start = static_cast<ULONG>(
+            std::upper_bound(
+                available_penalties.begin(),
+                available_penalties.end(),
+                *(coarse_position - 1)
+            ) - available_penalties.begin()
+        );
+    }
+    ULONG end = static_cast<ULONG>(
+        std::lower_bound(
+            available_penalties.begin(),
+            available_penalties.end(),
+            upper
+        ) - available_penalties.begin()
+    );
+
+    while (
+        start < end
+        && (
+            start == 0
+            || available_penalties[end] - available_penalties[start - 1]
+                > tolerance
+        )
+    )
+    {
+        ULONG current_index = (start + end) / 2;
+        if (probe_threshold(search, available_penalties[current_index]))
+        {
+            end = current_index;
+        }
+        else
+        {
+            start = current_index + 1;
+        }
+    }
+    return available_penalties[end];
+}
 #endif
 
 __device__ struct ConstraintGraph* choose_best_node(
@@ -265,12 +538,24 @@ __device__ struct ConstraintGraph* choose_best_node(
     struct Node node;
     node.pixel = pixel;
     node.disparity = 0;
-    FLOAT minimal_penalty = -1;
+    FLOAT minimal_penalty = 0;
+    FLOAT penalty = 0;
+    BOOL node_found = FALSE;
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    thread_local FLOAT_ARRAY buffer;
+    const FLOAT* penalties
+        = pixel_node_penalties(graph->disparity_graph, pixel, &buffer);
+    #endif
     for (
-        node.disparity = 0;
-        node.pixel.x + node.disparity < graph->disparity_graph->left.width
+        node.disparity = next_available_disparity(graph, pixel, 0);
+        node.pixel.x + node_disparity(graph->disparity_graph, node)
+                < graph->disparity_graph->left.width
             && node.disparity < graph->disparity_graph->disparity_levels;
-        ++node.disparity
+        node.disparity = next_available_disparity(
+            graph,
+            pixel,
+            node.disparity + 1
+        )
     )
     {
         if (!is_node_available(graph, node))
@@ -278,24 +563,32 @@ __device__ struct ConstraintGraph* choose_best_node(
             continue;
         }
 
-        if (minimal_penalty < 0)
+        #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+        penalty = penalties[node.disparity];
+        #else
+        penalty = node_penalty(graph->disparity_graph, node);
+        #endif
+        if (!node_found)
         {
-            minimal_penalty = node_penalty(graph->disparity_graph, node);
+            minimal_penalty = penalty;
+            node_found = TRUE;
         }
         else {
-            minimal_penalty = MIN(
-                node_penalty(graph->disparity_graph, node),
-                minimal_penalty
-            );
+            minimal_penalty = MIN(penalty, minimal_penalty);
         }
     }
 
     bool node_chosen = false;
     for (
-        node.disparity = 0;
-        node.pixel.x + node.disparity < graph->disparity_graph->left.width
+        node.disparity = next_available_disparity(graph, pixel, 0);
+        node.pixel.x + node_disparity(graph->disparity_graph, node)
+                < graph->disparity_graph->left.width
             && node.disparity < graph->disparity_graph->disparity_levels;
-        ++node.disparity
+        node.disparity = next_available_disparity(
+            graph,
+            pixel,
+            node.disparity + 1
+        )
     )
     {
         if (!is_node_available(graph, node))
@@ -303,15 +596,18 @@ __device__ struct ConstraintGraph* choose_best_node(
             continue;
         }
 
-        if (
-            node_chosen
-            || node_penalty(graph->disparity_graph, node) > minimal_penalty
-        )
+        #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+        penalty = penalties[node.disparity];
+        #else
+        penalty = node_penalty(graph->disparity_graph, node);
+        #endif
+        if (node_chosen || penalty > minimal_penalty)
         {
             make_node_unavailable(graph, node);
         }
         else
         {
+            COUNT(CHOSEN_NODES, 1);
             node_chosen = true;
         }
     }
@@ -326,9 +622,20 @@ struct ConstraintGraph* find_labeling_cl(
 )
 {
     struct gpu::Problem problem;
-    build_csp_program(&problem);
-    prepare_problem(graph, &problem);
-    gpu::csp_solution_cl(graph, &problem);
+    return find_labeling_cl(graph, &problem);
+}
+
+struct ConstraintGraph* find_labeling_cl(
+    struct ConstraintGraph* graph,
+    struct gpu::Problem* problem
+)
+{
+    if (problem->program.get() == nullptr)
+    {
+        build_csp_program(problem);
+    }
+    prepare_problem(graph, problem);
+    gpu::csp_solution_cl(graph, problem);
     return graph;
 }
 #endif
@@ -350,15 +657,20 @@ __device__ struct ConstraintGraph* find_labeling(
     struct ConstraintGraph* graph
 )
 {
-    for (ULONG x = 0; x < graph->disparity_graph->left.width; ++x)
+    struct ArcConsistency state{graph};
+    if (!propagate(&state))
     {
-        for (ULONG y = 0; y < graph->disparity_graph->left.height; ++y)
+        return nullptr;
+    }
+    for (ULONG y = 0; y < graph->disparity_graph->left.height; ++y)
+    {
+        for (ULONG x = 0; x < graph->disparity_graph->left.width; ++x)
         {
             if (choose_best_node(graph, {x, y}) == nullptr)
             {
                 return nullptr;
             }
-            if (!solve_csp(graph))
+            if (!propagate_from(&state, {x, y}).solvable)
             {
                 return nullptr;
             }
@@ -367,17 +679,62 @@ __device__ struct ConstraintGraph* find_labeling(
     return graph;
 }
 
+struct ConstraintGraph* find_labeling_relaxed(
+    struct ConstraintGraph* graph,
+    const FLOAT_ARRAY& available_penalties
+)
+{
+    auto next_penalty = upper_bound(
+        available_penalties.begin(),
+        available_penalties.end(),
+        graph->threshold
+    );
+    ULONG step = 1;
+    struct ConstraintGraph candidate{*graph};
+    while (find_labeling(&candidate) == nullptr)
+    {
+        if (next_penalty == available_penalties.end())
+        {
+            return nullptr;
+        }
+        next_penalty += std::min<ULONG>(
+            step,
+            available_penalties.end() - next_penalty
+        ) - 1;
+        candidate = ConstraintGraph{
+            graph->disparity_graph,
+            graph->lowest_penalties,
+            *next_penalty
+        };
+        solve_csp_worklist(&candidate);
+        ++next_penalty;
+        step *= 2;
+    }
+    *graph = std::move(candidate);
+    return graph;
+}
+
 __device__ struct Image build_disparity_map(
     const struct ConstraintGraph* constraint_graph
 )
 {
+    const struct DisparityGraph* disparity_graph
+        = constraint_graph->disparity_graph;
+    ULONG max_value = disparity_graph->disparity_levels;
+    if (!disparity_graph->minimal_disparities.empty())
+    {
+        max_value += *std::max_element(
+            disparity_graph->minimal_disparities.begin(),
+            disparity_graph->minimal_disparities.end()
+        );
+    }
     struct Image result{
-        constraint_graph->disparity_graph->left.width,
-        constraint_graph->disparity_graph->left.height,
-        constraint_graph->disparity_graph->disparity_levels,
-        ULONG_ARRAY(
-            constraint_graph->disparity_graph->left.height
-            * constraint_graph->disparity_graph->left.width
+        disparity_graph->left.width,
+        disparity_graph->left.height,
+        max_value,
+        Pixels(
+            disparity_graph->left.height * disparity_graph->left.width,
+            max_value
         )
     };
     struct Node node;
@@ -387,22 +744,29 @@ __device__ struct Image build_disparity_map(
 
     BOOL found = false;
     for (
-        node.pixel.x = 0;
-        node.pixel.x < constraint_graph->disparity_graph->left.width;
-        ++node.pixel.x)
+        node.pixel.y = 0;
+        node.pixel.y < constraint_graph->disparity_graph->left.height;
+        ++node.pixel.y)
     {
         for (
-            node.pixel.y = 0;
-            node.pixel. y < constraint_graph->disparity_graph->left.height;
-            ++node.pixel.y)
+            node.pixel.x = 0;
+            node.pixel.x < constraint_graph->disparity_graph->left.width;
+            ++node.pixel.x)
         {
+            const ULONG disparities
+                = pixel_disparities(disparity_graph, node.pixel);
             for (
-                node.disparity = 0;
-                node.pixel.x + node.disparity
-                    < constraint_graph->disparity_graph->left.width
-                && node.disparity
-                    < constraint_graph->disparity_graph->disparity_levels;
-                ++node.disparity
+                node.disparity = next_available_disparity(
+                    constraint_graph,
+                    node.pixel,
+                    0
+                );
+                node.disparity < disparities;
+                node.disparity = next_available_disparity(
+                    constraint_graph,
+                    node.pixel,
+                    node.disparity + 1
+                )
             )
             {
                 if (is_node_available(constraint_graph, node))
@@ -420,7 +784,7 @@ __device__ struct Image build_disparity_map(
                     else
                     {
                         result.data[pixel_index(&result, node.pixel)]
-                            = node.disparity;
+                            = node_disparity(disparity_graph, node);
                         found = true;
                     }
                 }
@@ -24,6 +24,12 @@
 #include <indexing_checks.hpp>
 #include <lowest_penalties.hpp>
 
+#if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+#include <algorithm>
+#include <limits>
+#include <vector>
+#endif
+
 #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
 namespace sp
 {
@@ -33,13 +39,135 @@ namespace lowest_penalties
 {
 
 using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::graph::disparity::pixel_disparities;
 using sp::indexing::checks::neighborhood_exists_fast;
+using sp::indexing::minimal_disparity;
 using sp::indexing::neighbor_by_index;
 using sp::indexing::neighborhood_index;
 using sp::indexing::neighborhood_index_fast;
 using sp::indexing::neighborhood_index_slow;
+using sp::indexing::reparametrization_index;
+using sp::indexing::reparametrization_index_slow;
 using sp::types::Node;
 
+namespace
+{
+
+/**
+ * \brief Lower envelope of parabolas
+ * \f$s \left( x - v \right)^2 + h_v\f$
+ * with common smoothness \f$s\f$ and increasing vertices \f$v\f$.
+ *
+ * Parabolas are added in order of their vertices
+ * and the envelope is queried at non-decreasing points,
+ * so both operations take amortized constant time
+ * like in the distance transform of Felzenszwalb and Huttenlocher.
+ */
+class ParabolasEnvelope
+{
+public:
+    /**
+     * \brief Remove all parabolas and set their smoothness.
+     */
+    void reset(double smoothness, ULONG capacity)
+    {
+        this->smoothness = smoothness;
+        this->vertices.resize(capacity);
+        this->heights.resize(capacity);
+        this->bounds.resize(capacity);
+        this->size = 0;
+        this->current = 0;
+    }
+    /**
+     * \brief Add a parabola with the vertex
+     * greater than vertices of all added ones.
+     */
+    void add(ULONG vertex, double height)
+    {
+        double bound = -std::numeric_limits<double>::infinity();
+        while (this->size > 0)
+        {
+            bound = this->intersection(this->size - 1, vertex, height);
+            if (bound > this->bounds[this->size - 1])
+            {
+                break;
+            }
+            --this->size;
+            bound = -std::numeric_limits<double>::infinity();
+        }
+        this->vertices[this->size] = vertex;
+        this->heights[this->size] = height;
+        this->bounds[this->size] = bound;
+        ++this->size;
+        this->current = std::min(this->current, this->size - 1);
+    }
+    /**
+     * \brief Vertex of the lowest parabola at the point
+     * not less than all previously queried ones.
+     */
+    ULONG lowest(ULONG point)
+    {
+        const double x = static_cast<double>(point);
+        while (
+            this->current + 1 < this->size
+            && this->bounds[this->current + 1] <= x
+        )
+        {
+            ++this->current;
+        }
+        return this->vertices[this->current];
+    }
+private:
+    /**
+     * \brief Point from which the new parabola is not higher
+     * than the added one with specified position in the envelope.
+     */
+    double intersection(ULONG position, ULONG vertex, double height) const
+    {
+        const double old_vertex = static_cast<double>(this->vertices[position]);
+        const double new_vertex = static_cast<double>(vertex);
+        const double difference = height - this->heights[position];
+        if (this->smoothness <= 0)
+        {
+            return difference <= 0
+                ? -std::numeric_limits<double>::infinity()
+                : std::numeric_limits<double>::infinity();
+        }
+        return (
+            difference
+            + this->smoothness
+                * (new_vertex * new_vertex - old_vertex * old_vertex)
+        ) / (2 * this->smoothness * (new_vertex - old_vertex));
+    }
+
+    /**
+     * \brief Smoothness of all parabolas.
+     */
+    double smoothness = 0;
+    /**
+     * \brief Vertices of parabolas forming the envelope.
+     */
+    std::vector<ULONG> vertices;
+    /**
+     * \brief Values of parabolas at their vertices.
+     */
+    std::vector<double> heights;
+    /**
+     * \brief Points from which parabolas form the envelope.
+     */
+    std::vector<double> bounds;
+    /**
+     * \brief Number of parabolas forming the envelope.
+     */
+    ULONG size = 0;
+    /**
+     * \brief Position of the parabola found by the last query.
+     */
+    ULONG current = 0;
+};
+
+}
+
 LowestPenalties::LowestPenalties(const struct DisparityGraph* graph)
     : graph{graph}
     , pixels(graph->right.height * graph->right.width)
@@ -51,13 +179,16 @@ LowestPenalties::LowestPenalties(const struct DisparityGraph* graph)
 {
     fill(this->pixels.begin(), this->pixels.end(), static_cast<FLOAT>(0));
     fill(this->neighborhoods.begin(), this->neighborhoods.end(), static_cast<FLOAT>(0));
-    struct Pixel pixel{0, 0};
-    for (pixel.x = 0; pixel.x < this->graph->right.width; ++pixel.x)
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long y = 0; y < static_cast<long>(this->graph->right.height); ++y)
     {
+        struct Pixel pixel{0, static_cast<ULONG>(y)};
         for (
-            pixel.y = 0;
-            pixel.y < this->graph->right.height;
-            ++pixel.y)
+            pixel.x = 0;
+            pixel.x < this->graph->right.width;
+            ++pixel.x)
         {
             this->pixels[
                 pixel_index(&(this->graph->right), pixel)
@@ -99,6 +230,14 @@ __device__ FLOAT calculate_lowest_pixel_penalty(
     struct Pixel pixel
 )
 {
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    thread_local FLOAT_ARRAY buffer;
+    const FLOAT* penalties = pixel_node_penalties(graph, pixel, &buffer);
+    return *std::min_element(
+        penalties,
+        penalties + pixel_disparities(graph, pixel)
+    );
+    #else
     struct Node node;
     node.pixel = pixel;
     node.disparity = 0;
@@ -116,6 +255,7 @@ __device__ FLOAT calculate_lowest_pixel_penalty(
         );
     }
     return minimal_penalty;
+    #endif
 }
 
 __device__ FLOAT calculate_lowest_neighborhood_penalty(
@@ -143,6 +283,73 @@ __device__ FLOAT calculate_lowest_neighborhood_penalty_fast(
     struct Edge edge
 )
 {
+    #if !defined(__OPENCL_C_VERSION__) && !defined(__CUDA_ARCH__)
+    edge.node.disparity = 0;
+    edge.neighbor.disparity = 0;
+    const ULONG node_disparities = pixel_disparities(graph, edge.node.pixel);
+    const ULONG neighbor_disparities
+        = pixel_disparities(graph, edge.neighbor.pixel);
+    const FLOAT* node_potentials = &graph->reparametrization[
+        reparametrization_index_slow(graph, edge)
+    ];
+    const FLOAT* neighbor_potentials = &graph->reparametrization[
+        reparametrization_index(graph, edge.neighbor, edge.node.pixel)
+    ];
+    const bool horizontal = edge.neighbor.pixel.x != edge.node.pixel.x;
+    const double smoothness = graph->smoothness;
+    const ULONG node_minimum = minimal_disparity(graph, edge.node.pixel);
+    const ULONG neighbor_minimum
+        = minimal_disparity(graph, edge.neighbor.pixel);
+
+    thread_local ParabolasEnvelope envelope;
+    envelope.reset(smoothness, node_disparities);
+
+    struct Edge best_edge = edge;
+    double minimal_penalty = std::numeric_limits<double>::infinity();
+    ULONG added = 0;
+    for (
+        edge.neighbor.disparity = 0;
+        edge.neighbor.disparity < neighbor_disparities;
+        ++edge.neighbor.disparity
+    )
+    {
+        const ULONG neighbor_value
+            = neighbor_minimum + edge.neighbor.disparity;
+        const ULONG allowed = horizontal
+            ? (
+                neighbor_value + 2 > node_minimum
+                    ? MIN(neighbor_value + 2 - node_minimum, node_disparities)
+                    : 0
+            )
+            : node_disparities;
+        for (; added < allowed; ++added)
+        {
+            envelope.add(
+                node_minimum + added,
+                -static_cast<double>(node_potentials[added])
+            );
+        }
+        if (added == 0)
+        {
+            continue;
+        }
+        const ULONG node_value = envelope.lowest(neighbor_value);
+        edge.node.disparity = node_value - node_minimum;
+        const double difference
+            = static_cast<double>(node_value)
+            - static_cast<double>(neighbor_value);
+        const double penalty
+            = smoothness * difference * difference
+            - node_potentials[edge.node.disparity]
+            - neighbor_potentials[edge.neighbor.disparity];
+        if (penalty < minimal_penalty)
+        {
+            minimal_penalty = penalty;
+            best_edge = edge;
+        }
+    }
+    return edge_penalty(graph, best_edge);
+    #else
     FLOAT minimal_penalty = edge_penalty(graph, edge);
     ULONG initial_disparity = 0;
     for (
@@ -177,6 +384,7 @@ __device__ FLOAT calculate_lowest_neighborhood_penalty_fast(
         }
     }
     return minimal_penalty;
+    #endif
 }
 
 __device__ FLOAT calculate_lowest_neighborhood_penalty_slow(
@@ -1,6 +1,9 @@
 #include <boost/program_options.hpp>
 
+#include <arc_consistency.hpp>
+#include <batch.hpp>
 #include <constraint_graph.hpp>
+#include <diffusion.hpp>
 #include <disparity_graph.hpp>
 #ifdef USE_OPENCL
 #include <gpu_csp.hpp>
@@ -9,16 +12,46 @@
 #include <labeling_finder.hpp>
 #include <lowest_penalties.hpp>
 #include <pgm_io.hpp>
+#include <planning.hpp>
+#include <profiling.hpp>
+#include <pyramid.hpp>
+#include <tiling.hpp>
+#include <stream.hpp>
 
 #include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct sp::image::Image read_image(const std::string& image_path);
 
+/**
+ * \brief Memory reused between stereo pairs solved by one thread.
+ */
+struct Workspace
+{
+    /**
+     * \brief Storage of sp::graph::disparity::DisparityGraph::reparametrization.
+     */
+    sp::types::FLOAT_ARRAY reparametrization;
+    /**
+     * \brief Storage of sp::graph::disparity::DisparityGraph::node_penalties.
+     */
+    sp::types::FLOAT_ARRAY node_penalties;
+#ifdef USE_OPENCL
+    /**
+     * \brief Built OpenCL program and its buffers.
+     */
+    struct gpu::Problem problem;
+#endif
+};
+
 enum Parallelism
 {
     CPU,
@@ -30,6 +63,107 @@ enum Parallelism
 #endif
 };
 
+/**
+ * \brief Solve one stereo pair and write its disparity map.
+ *
+ * Allocations of `workspace` are reused and returned back.
+ * If `warm_start` isn't null,
+ * the pair is seeded by the previous frame kept there
+ * and replaces it afterwards.
+ */
+struct sp::profiling::Profile solve_pair(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    bool binary_output,
+    const struct sp::batch::StereoPair& pair,
+    struct Workspace* workspace,
+    struct sp::stream::WarmStart* warm_start = nullptr
+);
+/**
+ * \brief Layout requested by `--pyramid`, `--window`,
+ * `--tile-size` and `--halo` options.
+ *
+ * Throws `std::invalid_argument` if tiles are requested for `--stream`.
+ */
+struct sp::planning::Layout read_layout(
+    const boost::program_options::variables_map& vm
+);
+/**
+ * \brief Solve a pair of images
+ * directly or coarse-to-fine if the layout has pyramid levels.
+ *
+ * The disparity map has `disparity_levels` as its maximal value.
+ */
+struct sp::image::Image solve_images(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const struct sp::planning::Layout* layout,
+    struct sp::image::Image left_image,
+    struct sp::image::Image right_image,
+    sp::types::ULONG disparity_levels,
+    struct Workspace* workspace,
+    struct sp::stream::WarmStart* warm_start,
+    struct sp::profiling::Profile* profile
+);
+/**
+ * \brief Solve images of one level of the pyramid
+ * and build their disparity map.
+ *
+ * If `minimal_disparities` aren't empty,
+ * pixels are restricted to windows of `disparity_levels` disparities
+ * starting at them.
+ * Penalties of nodes are cached if the layout asks for it.
+ */
+struct sp::image::Image solve_level(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const struct sp::planning::Layout* layout,
+    const struct sp::image::Image& left_image,
+    const struct sp::image::Image& right_image,
+    sp::types::ULONG disparity_levels,
+    sp::types::ULONG_ARRAY minimal_disparities,
+    struct Workspace* workspace,
+    struct sp::stream::WarmStart* warm_start,
+    struct sp::profiling::Profile* profile
+);
+/**
+ * \brief Solve stereo pairs listed by `--batch` option.
+ *
+ * Small pairs are solved concurrently unless a report is requested:
+ * sp::counters and processor time are shared by all threads,
+ * so reports of concurrent pairs would mix their work.
+ *
+ * @return
+ *  Exit code of the program.
+ */
+int solve_batch(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const std::string& report,
+    bool binary_output
+);
+/**
+ * \brief Solve frames listed by `--stream` option one by one,
+ * seeding each frame by the previous one.
+ *
+ * @return
+ *  Exit code of the program.
+ */
+int solve_stream(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const std::string& report,
+    bool binary_output
+);
+/**
+ * \brief Write the profile in format requested by `--report` option.
+ */
+void write_report(
+    std::ostream& stream,
+    const std::string& report,
+    const struct sp::profiling::Profile* profile
+);
+
 int main(int argc, char* argv[]) try
 {
     boost::program_options::options_description desc("Allowed options");
@@ -44,6 +178,9 @@ int main(int argc, char* argv[]) try
         ("right-image,r",
          boost::program_options::value<std::string>(),
          "Right image")
+        ("output-format,f",
+         boost::program_options::value<std::string>(),
+         "Format of the output image: plain (default), binary")
         ("output-image,o",
          boost::program_options::value<std::string>(),
          "Output image with disparity map")
@@ -56,6 +193,56 @@ int main(int argc, char* argv[]) try
         ("cleanness,c",
          boost::program_options::value<std::string>(),
          "Cleanness weight")
+        ("iterations,i",
+         boost::program_options::value<std::string>(),
+         "Maximal number of diffusion iterations")
+        ("diffusion-tolerance,e",
+         boost::program_options::value<std::string>(),
+         "Change of reparametrization to consider diffusion converged")
+        ("penalty-bins,b",
+         boost::program_options::value<std::string>(),
+         "Number of histogram bins to quantize available penalties to")
+        ("threshold-tolerance,t",
+         boost::program_options::value<std::string>(),
+         "Allowed excess of the threshold over the minimal one")
+        ("profile",
+         "Print time and memory consumed by stages (same as --report=text); "
+         "processor time is of the whole process")
+        ("report",
+         boost::program_options::value<std::string>(),
+         "Print time and memory consumed by stages in format: text, json; "
+         "pairs of a batch are solved one by one to keep reports apart")
+        ("batch,B",
+         boost::program_options::value<std::string>(),
+         "Manifest of stereo pairs or directory with `left` and `right` ones "
+         "to solve instead of a single pair; "
+         "output image is the directory for disparity maps")
+        ("stream,S",
+         boost::program_options::value<std::string>(),
+         "Manifest of frames of a stereo video or directory "
+         "with `left` and `right` ones to solve in order, "
+         "seeding each frame by the previous one; "
+         "output image is the directory for disparity maps")
+        ("pyramid,P",
+         boost::program_options::value<std::string>(),
+         "Number of times to halve images and solve them coarse-to-fine")
+        ("window,W",
+         boost::program_options::value<std::string>(),
+         "Number of disparities around the upsampled coarse disparity "
+         "to consider at finer levels of the pyramid (8 by default)")
+        ("tile-size,T",
+         boost::program_options::value<std::string>(),
+         "Solve the pair tile by tile with tiles of given size "
+         "(`512` or `512x256`) to bound memory")
+        ("halo",
+         boost::program_options::value<std::string>(),
+         "Number of pixels around a tile solved with it "
+         "to avoid seams (16 by default)")
+        ("max-memory,M",
+         boost::program_options::value<std::string>(),
+         "Memory a pair should fit into in bytes (`4096`, `512K`, `2G`); "
+         "the cost volume cache, the pyramid or tiles are used "
+         "when the requested layout needs more")
     ;
 
     boost::program_options::variables_map vm;
@@ -76,10 +263,29 @@ int main(int argc, char* argv[]) try
 
     boost::program_options::notify(vm);
 
-    if (
-        vm.count("output-image") == 1
-        && vm.count("left-image") == 1
-        && vm.count("right-image") == 1
+    const bool sequence = vm.count("batch") == 1 || vm.count("stream") == 1;
+    if (vm.count("batch") == 1 && vm.count("stream") == 1)
+    {
+        std::cerr
+            << "You should specify either a batch or a stream."
+            << std::endl;
+    }
+    else if (
+        sequence
+        && (vm.count("left-image") == 1 || vm.count("right-image") == 1)
+    )
+    {
+        std::cerr
+            << "You should specify either a batch or left and right image."
+            << std::endl;
+    }
+    else if (
+        sequence
+        || (
+            vm.count("output-image") == 1
+            && vm.count("left-image") == 1
+            && vm.count("right-image") == 1
+        )
     )
     {
         Parallelism parallelism;
@@ -128,118 +334,59 @@ int main(int argc, char* argv[]) try
                 );
             }
         }
-        try
+        std::string report;
+        if (vm.count("report") == 1)
         {
-            struct sp::image::Image left_image{
-                read_image(vm["left-image"].as<std::string>())
-            };
-            struct sp::image::Image right_image{
-                read_image(vm["right-image"].as<std::string>())
-            };
-            sp::types::ULONG disparity_levels = 0;
-            if (vm.count("disparity-levels") == 0)
+            report = vm["report"].as<std::string>();
+            if (report != "text" && report != "json")
             {
-                disparity_levels = left_image.width;
-            }
-            else
-            {
-                disparity_levels = std::stoul(
-                    vm["disparity-levels"].as<std::string>()
-                );
-            }
-            sp::types::FLOAT cleanness = 1;
-            if (vm.count("cleanness") == 1)
-            {
-                cleanness = std::stof(
-                    vm["cleanness"].as<std::string>()
+                throw std::invalid_argument(
+                    "`report` cannot be " + report + "."
                 );
             }
-            sp::types::FLOAT smoothness = 1;
-            if (vm.count("smoothness") == 1)
+        }
+        else if (vm.count("profile") == 1)
+        {
+            report = "text";
+        }
+        bool binary_output = false;
+        if (vm.count("output-format") == 1)
+        {
+            std::string output_format = vm["output-format"].as<std::string>();
+            if (output_format == "binary")
             {
-                smoothness = std::stof(
-                    vm["smoothness"].as<std::string>()
-                );
+                binary_output = true;
             }
-            struct sp::graph::disparity::DisparityGraph disparity_graph{
-                left_image,
-                right_image,
-                disparity_levels,
-                cleanness,
-                smoothness
-            };
-            struct sp::graph::lowest_penalties::LowestPenalties
-                lowest_penalties{&disparity_graph};
-            auto available_penalties
-                = sp::labeling::finder::fetch_available_penalties(
-                    &lowest_penalties
-                );
-            sp::types::FLOAT threshold
-                = sp::labeling::finder::calculate_minimal_consistent_threshold(
-                    &lowest_penalties,
-                    &disparity_graph,
-                    available_penalties
-                );
-            struct sp::graph::constraint::ConstraintGraph constraint_graph{
-                &disparity_graph,
-                &lowest_penalties,
-                threshold
-            };
-            if (!solve_csp(&constraint_graph))
+            else if (output_format != "plain")
             {
-                throw std::logic_error(
-                    "Cannot solve CSP problem. "
-                    "This should not ever happen. "
-                    "Refer to the developers."
+                throw std::invalid_argument(
+                    "`output-format` cannot be " + output_format + "."
                 );
             }
-
-            struct sp::graph::constraint::ConstraintGraph* labeled_graph = nullptr;
-            switch (parallelism)
+        }
+        try
+        {
+            if (vm.count("batch") == 1)
             {
-                case Parallelism::CPU:
-                    labeled_graph = sp::labeling::finder::find_labeling(
-                        &constraint_graph
-                    );
-                    break;
-#ifdef USE_OPENCL
-                case Parallelism::OpenCL:
-                    labeled_graph = sp::labeling::finder::find_labeling_cl(
-                        &constraint_graph
-                    );
-                    break;
-#endif
-#ifdef USE_CUDA
-                case Parallelism::CUDA:
-                    labeled_graph = sp::labeling::finder::find_labeling_cuda(
-                        &constraint_graph
-                    );
-                    break;
-#endif
-                default:
-                    throw std::logic_error(
-                        "Unknown parallelism schema. "
-                        "This should not ever happen. "
-                        "Refer to the developers."
-                    );
+                return solve_batch(vm, parallelism, report, binary_output);
             }
-            if (labeled_graph == nullptr)
+            if (vm.count("stream") == 1)
             {
-                throw std::logic_error(
-                    "Cannot find labeling. "
-                    "This should not ever happen. "
-                    "Refer to the developers."
-                );
+                return solve_stream(vm, parallelism, report, binary_output);
             }
-
-            std::shared_ptr<struct sp::image::Image> result
-                = std::make_shared<struct sp::image::Image>(
-                    sp::labeling::finder::build_disparity_map(
-                        &constraint_graph
-                    ));
-            std::ofstream image_file(vm["output-image"].as<std::string>());
-            sp::image::PGM_IO pgm_io{result};
-            image_file << pgm_io;
+            struct Workspace workspace;
+            const struct sp::profiling::Profile profile = solve_pair(
+                vm,
+                parallelism,
+                binary_output,
+                {
+                    vm["left-image"].as<std::string>(),
+                    vm["right-image"].as<std::string>(),
+                    vm["output-image"].as<std::string>()
+                },
+                &workspace
+            );
+            write_report(std::cout, report, &profile);
         }
         catch (std::invalid_argument& e)
         {
@@ -280,30 +427,696 @@ catch(...) {
 
 struct sp::image::Image read_image(const std::string& image_path)
 {
-    std::ifstream image_file(image_path);
-    if (!image_file)
+    std::shared_ptr<struct sp::image::Image> image
+        = sp::image::read_pgm(image_path);
+    if (!image)
+    {
+        throw std::invalid_argument(
+            "File `" + image_path +
+            "` is not a correct plain or binary PGM image."
+        );
+    }
+    return *image;
+}
+
+struct sp::profiling::Profile solve_pair(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    bool binary_output,
+    const struct sp::batch::StereoPair& pair,
+    struct Workspace* workspace,
+    struct sp::stream::WarmStart* warm_start
+)
+{
+    struct sp::profiling::Profile profile;
+    sp::profiling::start_stage(&profile, "read_images");
+    struct sp::image::Image left_image{
+        read_image(pair.left)
+    };
+    struct sp::image::Image right_image{
+        read_image(pair.right)
+    };
+    sp::types::ULONG disparity_levels = 0;
+    if (vm.count("disparity-levels") == 0)
+    {
+        disparity_levels = left_image.width;
+    }
+    else
+    {
+        disparity_levels = std::stoul(
+            vm["disparity-levels"].as<std::string>()
+        );
+    }
+    sp::profiling::count(
+        &profile,
+        "pixels",
+        left_image.width * left_image.height
+    );
+    sp::profiling::finish_stage(&profile);
+
+    struct sp::planning::Layout layout = read_layout(vm);
+    if (vm.count("max-memory") == 1)
+    {
+        sp::profiling::start_stage(&profile, "plan_layout");
+        const sp::types::ULONG budget = sp::planning::parse_memory_size(
+            vm["max-memory"].as<std::string>()
+        );
+        const sp::types::ULONG bytes_per_pixel = std::max(
+            left_image.data.bytes_per_pixel(),
+            right_image.data.bytes_per_pixel()
+        );
+        layout = sp::planning::plan_layout(
+            left_image.width,
+            left_image.height,
+            disparity_levels,
+            bytes_per_pixel,
+            budget,
+            layout,
+            parallelism == Parallelism::CPU
+        );
+        struct sp::planning::Footprint footprint
+            = sp::planning::estimate_footprint(
+                left_image.width,
+                left_image.height,
+                disparity_levels,
+                bytes_per_pixel,
+                &layout
+            );
+        sp::profiling::count(&profile, "budget", budget);
+        sp::profiling::count(
+            &profile,
+            "estimated_bytes",
+            sp::planning::total(&footprint)
+        );
+        sp::profiling::count(
+            &profile,
+            "cache_node_penalties",
+            layout.cache_node_penalties
+        );
+        sp::profiling::count(&profile, "pyramid", layout.pyramid_levels);
+        sp::profiling::count(&profile, "tile_width", layout.tile_width);
+        sp::profiling::count(&profile, "tile_height", layout.tile_height);
+        sp::profiling::finish_stage(&profile);
+    }
+
+    struct sp::image::Image disparity_map;
+    const bool tiled = layout.tile_width > 0 && layout.tile_height > 0;
+    if (tiled && warm_start != nullptr)
     {
         throw std::invalid_argument(
-            "Unable to open file `" + image_path + "`."
+            "Frames of `stream` cannot be solved tile by tile, "
+            "increase `max-memory`."
         );
     }
+    if (!tiled)
+    {
+        disparity_map = solve_images(
+            vm,
+            parallelism,
+            &layout,
+            std::move(left_image),
+            std::move(right_image),
+            disparity_levels,
+            workspace,
+            warm_start,
+            &profile
+        );
+    }
+    else
+    {
+        sp::profiling::start_stage(&profile, "tiles");
+        const std::vector<struct sp::tiling::HaloTile> tiles
+            = sp::tiling::plan_tiles(
+                left_image.width,
+                left_image.height,
+                disparity_levels,
+                layout.tile_width,
+                layout.tile_height,
+                layout.halo
+            );
+        disparity_map = {
+            left_image.width,
+            left_image.height,
+            disparity_levels,
+            sp::image::Pixels(
+                left_image.width * left_image.height,
+                disparity_levels
+            )
+        };
+        sp::types::ULONG tile_pixels = 0;
+        struct sp::profiling::Profile tiles_profile;
+        for (const struct sp::tiling::HaloTile& tile : tiles)
+        {
+            struct sp::profiling::Profile tile_profile;
+            sp::tiling::stitch(
+                &disparity_map,
+                solve_images(
+                    vm,
+                    parallelism,
+                    &layout,
+                    sp::tiling::crop(left_image, tile.extended),
+                    sp::tiling::crop(right_image, tile.extended),
+                    std::min(disparity_levels, tile.extended.width),
+                    workspace,
+                    nullptr,
+                    &tile_profile
+                ),
+                tile
+            );
+            tile_pixels = std::max(
+                tile_pixels,
+                tile.extended.width * tile.extended.height
+            );
+            sp::profiling::merge_stages(
+                &tiles_profile,
+                &tile_profile,
+                {"threshold"}
+            );
+        }
+        sp::profiling::count(&profile, "tiles", tiles.size());
+        sp::profiling::count(&profile, "largest_tile_pixels", tile_pixels);
+        sp::profiling::count_engine_counters(&profile);
+        sp::profiling::finish_stage(&profile);
+        sp::profiling::merge_stages(&profile, &tiles_profile);
+    }
+    std::shared_ptr<struct sp::image::Image> result
+        = std::make_shared<struct sp::image::Image>(std::move(disparity_map));
+
+    sp::profiling::start_stage(&profile, "write_image");
+    std::ofstream image_file(
+        pair.output,
+        std::ios::out | std::ios::binary
+    );
+    sp::image::PGM_IO pgm_io{result, binary_output};
+    image_file << pgm_io;
+    image_file.close();
+    sp::profiling::finish_stage(&profile);
+
+    return profile;
+}
+
+struct sp::planning::Layout read_layout(
+    const boost::program_options::variables_map& vm
+)
+{
+    struct sp::planning::Layout layout;
+    if (vm.count("pyramid") == 1)
+    {
+        layout.pyramid_levels = std::stoul(vm["pyramid"].as<std::string>());
+    }
+    if (vm.count("window") == 1)
+    {
+        layout.window = std::stoul(vm["window"].as<std::string>());
+    }
+    if (vm.count("tile-size") == 1)
+    {
+        if (vm.count("stream") == 1)
+        {
+            throw std::invalid_argument(
+                "`tile-size` cannot be used with `stream`: "
+                "tiles aren't seeded by previous frames."
+            );
+        }
+        const std::string tile_size = vm["tile-size"].as<std::string>();
+        const std::size_t separator = tile_size.find('x');
+        layout.tile_width = std::stoul(tile_size);
+        layout.tile_height
+            = separator == std::string::npos
+                ? layout.tile_width
+                : std::stoul(tile_size.substr(separator + 1));
+    }
+    if (vm.count("halo") == 1)
+    {
+        layout.halo = std::stoul(vm["halo"].as<std::string>());
+    }
+    return layout;
+}
 
-    sp::image::PGM_IO pgm_io;
-    image_file >> pgm_io;
-    if (!image_file)
+struct sp::image::Image solve_images(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const struct sp::planning::Layout* layout,
+    struct sp::image::Image left_image,
+    struct sp::image::Image right_image,
+    sp::types::ULONG disparity_levels,
+    struct Workspace* workspace,
+    struct sp::stream::WarmStart* warm_start,
+    struct sp::profiling::Profile* profile
+)
+{
+    const sp::types::ULONG pyramid_levels = layout->pyramid_levels;
+    const sp::types::ULONG window = layout->window;
+    if (pyramid_levels > 0 && parallelism != Parallelism::CPU)
     {
         throw std::invalid_argument(
-            "File `" + image_path +
-            "` is not a correct plain PGM image."
+            "`pyramid` is supported only with CPU parallelism."
+        );
+    }
+    std::vector<std::pair<struct sp::image::Image, struct sp::image::Image>>
+        pyramid;
+    pyramid.emplace_back(std::move(left_image), std::move(right_image));
+    if (pyramid_levels > 0)
+    {
+        sp::profiling::start_stage(profile, "downsample");
+        while (pyramid.size() <= pyramid_levels)
+        {
+            pyramid.emplace_back(
+                sp::pyramid::downsample(pyramid.back().first),
+                sp::pyramid::downsample(pyramid.back().second)
+            );
+        }
+        sp::profiling::count(profile, "levels", pyramid.size());
+        sp::profiling::finish_stage(profile);
+    }
+
+    std::vector<sp::types::ULONG> levels_disparities{disparity_levels};
+    while (levels_disparities.size() < pyramid.size())
+    {
+        levels_disparities.push_back(
+            sp::pyramid::coarse_disparity_levels(levels_disparities.back())
+        );
+    }
+    struct sp::image::Image disparity_map;
+    for (sp::types::ULONG level = pyramid.size(); level-- > 0;)
+    {
+        const struct sp::image::Image& level_left = pyramid[level].first;
+        sp::types::ULONG level_disparities = levels_disparities[level];
+        sp::types::ULONG_ARRAY minimal_disparities;
+        if (level + 1 < pyramid.size() && window < level_disparities)
+        {
+            sp::profiling::start_stage(profile, "upsample");
+            minimal_disparities
+                = sp::pyramid::upsample_minimal_disparities(
+                    disparity_map,
+                    level_left.width,
+                    level_left.height,
+                    level_disparities,
+                    window
+                );
+            level_disparities = window;
+            sp::profiling::finish_stage(profile);
+        }
+        disparity_map = solve_level(
+            vm,
+            parallelism,
+            layout,
+            level_left,
+            pyramid[level].second,
+            level_disparities,
+            std::move(minimal_disparities),
+            workspace,
+            level == 0 ? warm_start : nullptr,
+            profile
+        );
+    }
+    disparity_map.max_value = disparity_levels;
+    return disparity_map;
+}
+
+struct sp::image::Image solve_level(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const struct sp::planning::Layout* layout,
+    const struct sp::image::Image& left_image,
+    const struct sp::image::Image& right_image,
+    sp::types::ULONG disparity_levels,
+    sp::types::ULONG_ARRAY minimal_disparities,
+    struct Workspace* workspace,
+    struct sp::stream::WarmStart* warm_start,
+    struct sp::profiling::Profile* profile
+)
+{
+    sp::types::FLOAT cleanness = 1;
+    if (vm.count("cleanness") == 1)
+    {
+        cleanness = std::stof(
+            vm["cleanness"].as<std::string>()
         );
     }
-    if (!pgm_io.get_image())
+    sp::types::FLOAT smoothness = 1;
+    if (vm.count("smoothness") == 1)
+    {
+        smoothness = std::stof(
+            vm["smoothness"].as<std::string>()
+        );
+    }
+    sp::profiling::start_stage(profile, "disparity_graph");
+    struct sp::graph::disparity::DisparityGraph disparity_graph{
+        left_image,
+        right_image,
+        disparity_levels,
+        cleanness,
+        smoothness,
+        std::move(workspace->reparametrization)
+    };
+    sp::graph::disparity::set_minimal_disparities(
+        &disparity_graph,
+        std::move(minimal_disparities)
+    );
+    if (warm_start != nullptr)
+    {
+        sp::profiling::count(
+            profile,
+            "warm_start",
+            sp::stream::seed_reparametrization(warm_start, &disparity_graph)
+        );
+    }
+    if (layout->cache_node_penalties)
+    {
+        disparity_graph.node_penalties = std::move(workspace->node_penalties);
+        sp::graph::disparity::cache_node_penalties(&disparity_graph);
+    }
+    else
+    {
+        workspace->node_penalties = sp::types::FLOAT_ARRAY{};
+    }
+    sp::profiling::count(
+        profile,
+        "nodes",
+        disparity_graph.reparametrization.size()
+            / sp::graph::disparity::NEIGHBORS_COUNT
+    );
+    sp::profiling::finish_stage(profile);
+
+    if (vm.count("iterations") == 1)
+    {
+        sp::profiling::start_stage(profile, "diffusion");
+        sp::types::FLOAT diffusion_tolerance = 0;
+        if (vm.count("diffusion-tolerance") == 1)
+        {
+            diffusion_tolerance = std::stof(
+                vm["diffusion-tolerance"].as<std::string>()
+            );
+        }
+        sp::profiling::count(
+            profile,
+            "iterations",
+            sp::graph::diffusion::diffusion(
+                &disparity_graph,
+                std::stoul(vm["iterations"].as<std::string>()),
+                diffusion_tolerance
+            )
+        );
+        sp::profiling::finish_stage(profile);
+    }
+
+    sp::profiling::start_stage(profile, "lowest_penalties");
+    struct sp::graph::lowest_penalties::LowestPenalties
+        lowest_penalties{&disparity_graph};
+    sp::profiling::finish_stage(profile);
+
+    sp::profiling::start_stage(profile, "fetch_available_penalties");
+    auto available_penalties
+        = sp::labeling::finder::fetch_available_penalties(
+            &lowest_penalties
+        );
+    if (vm.count("penalty-bins") == 1)
+    {
+        available_penalties
+            = sp::labeling::finder::quantize_available_penalties(
+                available_penalties,
+                std::stoul(vm["penalty-bins"].as<std::string>())
+            );
+    }
+    sp::profiling::count(
+        profile,
+        "candidate_thresholds",
+        available_penalties.size()
+    );
+    sp::profiling::finish_stage(profile);
+
+    sp::profiling::start_stage(profile, "threshold_search");
+    struct sp::labeling::finder::ThresholdSearch threshold_search{
+        &disparity_graph,
+        &lowest_penalties
+    };
+    sp::types::FLOAT threshold = 0;
+    if (warm_start != nullptr)
+    {
+        threshold = sp::stream::calculate_stream_threshold(
+            warm_start,
+            &threshold_search,
+            available_penalties,
+            vm.count("threshold-tolerance") == 1
+                ? std::stof(vm["threshold-tolerance"].as<std::string>())
+                : 0
+        );
+    }
+    else if (vm.count("threshold-tolerance") == 1)
+    {
+        threshold = sp::labeling::finder
+            ::calculate_approximate_consistent_threshold(
+                &threshold_search,
+                available_penalties,
+                std::stof(vm["threshold-tolerance"].as<std::string>())
+            );
+    }
+    else
+    {
+        threshold = sp::labeling::finder
+            ::calculate_minimal_consistent_threshold(
+                &threshold_search,
+                available_penalties
+            );
+    }
+    sp::profiling::count(profile, "probes", threshold_search.probes);
+    sp::profiling::count(profile, "threshold", threshold);
+    sp::profiling::count_engine_counters(profile);
+    sp::profiling::finish_stage(profile);
+
+    sp::profiling::start_stage(profile, "solve_csp");
+    struct sp::graph::constraint::ConstraintGraph constraint_graph{
+        &disparity_graph,
+        &lowest_penalties,
+        threshold
+    };
+    const auto initial_nodes
+        = constraint_graph.nodes_availability.count();
+    if (
+        !sp::graph::arc_consistency::solve_csp_worklist(
+            &constraint_graph
+        )
+    )
+    {
+        throw std::logic_error(
+            "Cannot solve CSP problem. "
+            "This should not ever happen. "
+            "Refer to the developers."
+        );
+    }
+    sp::profiling::count(
+        profile,
+        "removed_nodes",
+        initial_nodes - constraint_graph.nodes_availability.count()
+    );
+    sp::profiling::count_engine_counters(profile);
+    sp::profiling::finish_stage(profile);
+
+    sp::profiling::start_stage(profile, "find_labeling");
+
+    struct sp::graph::constraint::ConstraintGraph* labeled_graph = nullptr;
+    switch (parallelism)
+    {
+        case Parallelism::CPU:
+            labeled_graph
+                = sp::labeling::finder::find_labeling_relaxed(
+                    &constraint_graph,
+                    available_penalties
+                );
+            break;
+#ifdef USE_OPENCL
+        case Parallelism::OpenCL:
+            labeled_graph = sp::labeling::finder::find_labeling_cl(
+                &constraint_graph,
+                &workspace->problem
+            );
+            break;
+#endif
+#ifdef USE_CUDA
+        case Parallelism::CUDA:
+            labeled_graph = sp::labeling::finder::find_labeling_cuda(
+                &constraint_graph
+            );
+            break;
+#endif
+        default:
+            throw std::logic_error(
+                "Unknown parallelism schema. "
+                "This should not ever happen. "
+                "Refer to the developers."
+            );
+    }
+    if (labeled_graph == nullptr)
     {
         throw std::logic_error(
-            "Image `" + image_path + "` is valid, "
-            "but it wasn't read for some reason. "
-            "Please, report the issue to developers."
+            "Cannot find labeling. "
+            "This should not ever happen. "
+            "Refer to the developers."
         );
     }
-    return *pgm_io.get_image();
+    sp::profiling::count(
+        profile,
+        "labeled_pixels",
+        constraint_graph.nodes_availability.count()
+    );
+    sp::profiling::count(profile, "threshold", constraint_graph.threshold);
+    sp::profiling::count_engine_counters(profile);
+    sp::profiling::finish_stage(profile);
+
+    sp::profiling::start_stage(profile, "build_disparity_map");
+    struct sp::image::Image result
+        = sp::labeling::finder::build_disparity_map(&constraint_graph);
+    sp::profiling::finish_stage(profile);
+
+    if (warm_start != nullptr)
+    {
+        sp::stream::remember_frame(
+            warm_start,
+            &disparity_graph,
+            threshold,
+            result
+        );
+    }
+    workspace->reparametrization
+        = std::move(disparity_graph.reparametrization);
+    workspace->reparametrization.clear();
+    workspace->node_penalties = std::move(disparity_graph.node_penalties);
+    workspace->node_penalties.clear();
+    return result;
+}
+
+int solve_batch(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const std::string& report,
+    bool binary_output
+)
+{
+    const std::vector<struct sp::batch::StereoPair> pairs
+        = sp::batch::read_batch(
+            vm["batch"].as<std::string>(),
+            vm.count("output-image") == 1
+                ? vm["output-image"].as<std::string>()
+                : std::string{}
+        );
+    std::mutex output_mutex;
+    const sp::types::ULONG failed = sp::batch::run_batch(
+        pairs,
+        parallelism == Parallelism::CPU && report.empty()
+            ? sp::batch::SMALL_IMAGE_PIXELS
+            : 0,
+        [&](sp::types::ULONG index)
+        {
+            thread_local struct Workspace workspace;
+            const struct sp::batch::StereoPair& pair = pairs[index];
+            std::ostringstream messages;
+            bool solved = true;
+            try
+            {
+                const struct sp::profiling::Profile profile = solve_pair(
+                    vm,
+                    parallelism,
+                    binary_output,
+                    pair,
+                    &workspace
+                );
+                if (!report.empty())
+                {
+                    if (report == "text")
+                    {
+                        messages << pair.output << ":" << std::endl;
+                    }
+                    write_report(messages, report, &profile);
+                }
+            }
+            catch (std::exception& e)
+            {
+                messages
+                    << "Cannot solve `" << pair.left << "` and `" << pair.right
+                    << "`: " << e.what() << std::endl;
+                solved = false;
+            }
+            std::lock_guard<std::mutex> lock{output_mutex};
+            (solved ? std::cout : std::cerr) << messages.str() << std::flush;
+            return solved;
+        }
+    );
+    if (failed > 0)
+    {
+        std::cerr
+            << failed << " of " << pairs.size() << " stereo pairs failed."
+            << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int solve_stream(
+    const boost::program_options::variables_map& vm,
+    Parallelism parallelism,
+    const std::string& report,
+    bool binary_output
+)
+{
+    read_layout(vm);
+    const std::vector<struct sp::batch::StereoPair> frames
+        = sp::batch::read_batch(
+            vm["stream"].as<std::string>(),
+            vm.count("output-image") == 1
+                ? vm["output-image"].as<std::string>()
+                : std::string{}
+        );
+    struct Workspace workspace;
+    struct sp::stream::WarmStart warm_start;
+    sp::types::ULONG failed = 0;
+    for (const struct sp::batch::StereoPair& frame : frames)
+    {
+        try
+        {
+            const struct sp::profiling::Profile profile = solve_pair(
+                vm,
+                parallelism,
+                binary_output,
+                frame,
+                &workspace,
+                &warm_start
+            );
+            if (report == "text")
+            {
+                std::cout << frame.output << ":" << std::endl;
+            }
+            write_report(std::cout, report, &profile);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr
+                << "Cannot solve `" << frame.left << "` and `" << frame.right
+                << "`: " << e.what() << std::endl;
+            ++failed;
+        }
+    }
+    if (failed > 0)
+    {
+        std::cerr
+            << failed << " of " << frames.size() << " frames failed."
+            << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+void write_report(
+    std::ostream& stream,
+    const std::string& report,
+    const struct sp::profiling::Profile* profile
+)
+{
+    if (report == "text")
+    {
+        sp::profiling::write_text_report(stream, profile);
+    }
+    else if (report == "json")
+    {
+        sp::profiling::write_json_report(stream, profile);
+    }
 }
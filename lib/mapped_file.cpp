@@ -0,0 +1,119 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <mapped_file.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace sp::image
+{
+
+using std::invalid_argument;
+using std::size_t;
+using std::string;
+
+MappedFile::MappedFile(const string& path)
+    : contents{nullptr}
+    , length{0}
+    , mapped{false}
+{
+    #if defined(__unix__) || defined(__APPLE__)
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        throw invalid_argument{"Unable to open file `" + path + "`."};
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        throw invalid_argument{"Unable to open file `" + path + "`."};
+    }
+    this->length = static_cast<size_t>(status.st_size);
+    if (this->length > 0)
+    {
+        void* address = mmap(
+            nullptr,
+            this->length,
+            PROT_READ,
+            MAP_PRIVATE,
+            descriptor,
+            0
+        );
+        if (address != MAP_FAILED)
+        {
+            madvise(address, this->length, MADV_SEQUENTIAL);
+            this->contents = static_cast<const char*>(address);
+            this->mapped = true;
+        }
+    }
+    close(descriptor);
+    if (this->mapped || this->length == 0)
+    {
+        return;
+    }
+    #endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw invalid_argument{"Unable to open file `" + path + "`."};
+    }
+    this->buffer.assign(
+        std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>()
+    );
+    this->contents = this->buffer.data();
+    this->length = this->buffer.size();
+}
+
+MappedFile::~MappedFile()
+{
+    #if defined(__unix__) || defined(__APPLE__)
+    if (this->mapped)
+    {
+        munmap(const_cast<char*>(this->contents), this->length);
+    }
+    #endif
+}
+
+const char* MappedFile::data() const
+{
+    return this->contents;
+}
+
+size_t MappedFile::size() const
+{
+    return this->length;
+}
+
+}
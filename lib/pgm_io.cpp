@@ -22,36 +22,212 @@
  * SOFTWARE.
  */
 #include <indexing.hpp>
+#include <mapped_file.hpp>
 #include <pgm_io.hpp>
 
-#include <cctype>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
 #include <ios>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <streambuf>
 #include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
 
 namespace sp::image
 {
 
 using sp::indexing::pixel_index;
 using sp::types::ULONG;
-using std::endl;
-using std::invalid_argument;
-using std::ios;
+using std::errc;
+using std::from_chars;
 using std::ios_base;
-using std::isspace;
 using std::make_shared;
 using std::move;
 using std::numeric_limits;
-using std::stoul;
+using std::size_t;
 using std::streamsize;
+using std::to_chars;
 using std::string;
+using std::vector;
+
+namespace
+{
+
+/**
+ * \brief Read-only stream buffer over contents that is already in memory.
+ */
+class MemoryBuffer : public std::streambuf
+{
+public:
+    MemoryBuffer(const char* begin, const char* end)
+    {
+        this->setg(
+            const_cast<char*>(begin),
+            const_cast<char*>(begin),
+            const_cast<char*>(end)
+        );
+    }
+    /**
+     * \brief Number of characters consumed from the buffer.
+     */
+    size_t position() const
+    {
+        return static_cast<size_t>(this->gptr() - this->eback());
+    }
+};
+
+/**
+ * \brief Number of bytes per intensity in binary PGM.
+ */
+ULONG binary_value_size(ULONG max_value)
+{
+    return max_value <= numeric_limits<unsigned char>::max() ? 1 : 2;
+}
+
+/**
+ * \brief Decode intensity with specified index from raw bytes.
+ */
+ULONG decode_binary_value(
+    const unsigned char* pixels,
+    ULONG max_value,
+    ULONG index
+)
+{
+    if (binary_value_size(max_value) == 1)
+    {
+        return pixels[index];
+    }
+    return (static_cast<ULONG>(pixels[2 * index]) << 8u)
+        | static_cast<ULONG>(pixels[2 * index + 1]);
+}
+
+/**
+ * \brief Check whether the character separates PGM instructions.
+ */
+bool is_whitespace(char character)
+{
+    return character == ' ' || character == '\n' || character == '\r'
+        || character == '\t' || character == '\v' || character == '\f';
+}
+
+/**
+ * \brief Skip whitespace and comments.
+ *
+ * @return Start of the next instruction or `end`.
+ */
+const char* skip_whitespace(const char* position, const char* end)
+{
+    while (position < end)
+    {
+        if (is_whitespace(*position))
+        {
+            ++position;
+        }
+        else if (*position == '#')
+        {
+            const void* line_end = std::memchr(
+                position,
+                '\n',
+                static_cast<size_t>(end - position)
+            );
+            position = line_end == nullptr
+                ? end
+                : static_cast<const char*>(line_end);
+        }
+        else
+        {
+            break;
+        }
+    }
+    return position;
+}
+
+/**
+ * \brief Parse a number that occupies the whole instruction.
+ */
+bool parse_number(const string& instruction, ULONG* number)
+{
+    const char* end = instruction.data() + instruction.size();
+    auto [last, error] = from_chars(instruction.data(), end, *number);
+    return error == errc{} && last == end;
+}
+
+/**
+ * \brief Parse `count` numbers separated by whitespace and comments.
+ *
+ * Numbers should not exceed `max_value`.
+ * Contents after the numbers should contain only whitespace and comments.
+ */
+template <typename T>
+bool parse_numbers(
+    const char* position,
+    const char* end,
+    T* numbers,
+    ULONG count,
+    ULONG max_value
+)
+{
+    ULONG number = 0;
+    for (ULONG index = 0; index < count; ++index)
+    {
+        position = skip_whitespace(position, end);
+        auto [last, error] = from_chars(position, end, number);
+        if (
+            error != errc{}
+            || number > max_value
+            || (last < end && !is_whitespace(*last) && *last != '#')
+        )
+        {
+            return false;
+        }
+        numbers[index] = static_cast<T>(number);
+        position = last;
+    }
+    return skip_whitespace(position, end) == end;
+}
+
+/**
+ * \brief Count instructions in contents without comments.
+ */
+ULONG count_numbers(const char* position, const char* end)
+{
+    ULONG count = 0;
+    bool previous_whitespace = true;
+    for (; position < end; ++position)
+    {
+        bool whitespace = is_whitespace(*position);
+        if (previous_whitespace && !whitespace)
+        {
+            ++count;
+        }
+        previous_whitespace = whitespace;
+    }
+    return count;
+}
+
+}
 
 PGM_IO::PGM_IO(shared_ptr<struct Image> image) : image{move(image)}
 {
 }
 
+PGM_IO::PGM_IO(shared_ptr<struct Image> image, bool binary)
+    : image{move(image)}
+    , binary{binary}
+{
+}
+
 void PGM_IO::set_image(const shared_ptr<struct Image>& image)
 {
     this->image = image;
@@ -62,6 +238,16 @@ shared_ptr<struct Image> PGM_IO::get_image() const
     return this->image;
 }
 
+void PGM_IO::set_binary(bool binary)
+{
+    this->binary = binary;
+}
+
+bool PGM_IO::is_binary() const
+{
+    return this->binary;
+}
+
 string PGM_IO::read_pgm_instruction(istream& in)
 {
     if (in.fail())
@@ -86,116 +272,411 @@ string PGM_IO::read_pgm_instruction(istream& in)
     return current_input;
 }
 
-bool PGM_IO::check_file_end(istream& in)
+bool checked_multiply(ULONG lhs, ULONG rhs, ULONG* product)
+{
+    if (rhs != 0 && lhs > numeric_limits<ULONG>::max() / rhs)
+    {
+        return false;
+    }
+    *product = lhs * rhs;
+    return true;
+}
+
+bool pixels_count(const struct Image* image, ULONG* count)
 {
-    char current_input;
-    while (in.good() && !in.eof())
+    return checked_multiply(image->width, image->height, count);
+}
+
+bool PGM_IO::read_header(istream& in, struct Image* image, bool* binary)
+{
+    string format_code = PGM_IO::read_pgm_instruction(in);
+    *binary = format_code == PGM_IO::BINARY_FORMAT_CODE;
+    if (format_code != PGM_IO::FORMAT_CODE && !*binary)
+    {
+        return false;
+    }
+
+    if (
+        !parse_number(PGM_IO::read_pgm_instruction(in), &image->width)
+        || !parse_number(PGM_IO::read_pgm_instruction(in), &image->height)
+        || !parse_number(PGM_IO::read_pgm_instruction(in), &image->max_value)
+    )
+    {
+        return false;
+    }
+
+    if (image->max_value > PGM_IO::MAX_VALUE_LIMIT)
+    {
+        return false;
+    }
+    ULONG count = 0;
+    if (!pixels_count(image, &count))
+    {
+        return false;
+    }
+    if (!*binary)
+    {
+        return true;
+    }
+    ULONG bytes = 0;
+    if (
+        image->max_value == 0
+        || image->max_value > PGM_IO::MAX_BINARY_VALUE
+        || !checked_multiply(count, binary_value_size(image->max_value), &bytes)
+    )
+    {
+        return false;
+    }
+    char separator = 0;
+    return in.get(separator) && is_whitespace(separator);
+}
+
+bool PGM_IO::read_plain_data(
+    const char* begin,
+    const char* end,
+    struct Image* image
+)
+{
+    ULONG count = 0;
+    const size_t size = static_cast<size_t>(end - begin);
+    if (!pixels_count(image, &count) || count > size)
+    {
+        return false;
+    }
+    image->data = Pixels(count, image->max_value);
+
+    long chunks = 1;
+    #ifdef _OPENMP
+    if (
+        size >= PGM_IO::PARALLEL_PARSING_SIZE
+        && std::memchr(begin, '#', size) == nullptr
+    )
+    {
+        chunks = omp_get_max_threads();
+    }
+    #endif
+    if (chunks == 1)
+    {
+        return image->data.visit(
+            [begin, end, count, image](auto* data)
+            {
+                return parse_numbers(
+                    begin,
+                    end,
+                    data,
+                    count,
+                    image->max_value
+                );
+            }
+        );
+    }
+
+    vector<const char*> bounds(chunks + 1, end);
+    bounds[0] = begin;
+    for (long chunk = 1; chunk < chunks; ++chunk)
     {
-        in.get(current_input);
-        if (current_input == '#')
+        const char* bound = begin + size / chunks * chunk;
+        if (bound < bounds[chunk - 1])
         {
-            in.ignore(numeric_limits<streamsize>::max(), '\n');
+            bound = bounds[chunk - 1];
         }
-        else if (isspace(current_input) == 0)
+        while (bound < end && !is_whitespace(*bound))
         {
-            in.setstate(ios_base::failbit);
-        };
+            ++bound;
+        }
+        bounds[chunk] = bound;
+    }
+
+    vector<ULONG> offsets(chunks + 1, 0);
+    #ifdef _OPENMP
+    #pragma omp parallel for
+    #endif
+    for (long chunk = 0; chunk < chunks; ++chunk)
+    {
+        offsets[chunk + 1] = count_numbers(bounds[chunk], bounds[chunk + 1]);
+    }
+    for (long chunk = 0; chunk < chunks; ++chunk)
+    {
+        offsets[chunk + 1] += offsets[chunk];
     }
-    if (in.eof())
+    if (offsets[chunks] != count)
     {
-        in.clear(ios::goodbit | ios::eofbit);
+        return false;
     }
-    return in.good();
+
+    return image->data.visit(
+        [chunks, &bounds, &offsets, image](auto* data)
+        {
+            bool parsed = true;
+            #ifdef _OPENMP
+            #pragma omp parallel for reduction(&&:parsed)
+            #endif
+            for (long chunk = 0; chunk < chunks; ++chunk)
+            {
+                parsed = parse_numbers(
+                    bounds[chunk],
+                    bounds[chunk + 1],
+                    data + offsets[chunk],
+                    offsets[chunk + 1] - offsets[chunk],
+                    image->max_value
+                ) && parsed;
+            }
+            return parsed;
+        }
+    );
 }
 
-ostream& operator<<(ostream& out, const PGM_IO& ppm_io)
+void PGM_IO::write_plain_data(ostream& out, const struct Image* image)
 {
-    if (!ppm_io.get_image() || !image_valid(ppm_io.get_image().get()))
+    char number[numeric_limits<ULONG>::digits10 + 2];
+    string row;
+    for (ULONG y = 0; y < image->height; ++y)
     {
-        return out;
+        row.clear();
+        for (ULONG x = 0; x < image->width; ++x)
+        {
+            char* last = to_chars(
+                number,
+                number + sizeof(number),
+                image->data[pixel_index(image, {x, y})]
+            ).ptr;
+            row.append(number, last);
+            if (x + 1 < image->width)
+            {
+                row.push_back(
+                    x == 0 || (x + 1) % PGM_IO::MAX_NUMBERS_PER_ROW != 0
+                        ? ' '
+                        : '\n'
+                );
+            }
+        }
+        row.push_back('\n');
+        out.write(row.data(), static_cast<streamsize>(row.size()));
     }
-    shared_ptr<struct Image> image = ppm_io.get_image();
-    out << PGM_IO::FORMAT_CODE << endl;
-    out << image->width << " " << image->height << endl;
-    out << image->max_value << endl;
+}
+
+bool PGM_IO::read_binary_data(istream& in, struct Image* image)
+{
+    const ULONG value_size = binary_value_size(image->max_value);
+    vector<unsigned char> row(image->width * value_size);
     for (ULONG y = 0; y < image->height; ++y)
     {
+        in.read(
+            reinterpret_cast<char*>(row.data()),
+            static_cast<streamsize>(row.size())
+        );
+        if (!in)
+        {
+            return false;
+        }
         for (ULONG x = 0; x < image->width; ++x)
         {
-            out << image->data[pixel_index(image.get(), {x, y})];
-            if (x == 0 || (x + 1) % PGM_IO::MAX_NUMBERS_PER_ROW != 0)
+            ULONG value = decode_binary_value(
+                row.data(),
+                image->max_value,
+                x
+            );
+            if (value > image->max_value)
             {
-                if (x + 1 < image->width)
-                {
-                    out << " ";
-                }
+                return false;
+            }
+            image->data[pixel_index(image, {x, y})] = value;
+        }
+    }
+    return true;
+}
+
+void PGM_IO::write_binary_data(ostream& out, const struct Image* image)
+{
+    const ULONG value_size = binary_value_size(image->max_value);
+    vector<char> row(image->width * value_size);
+    for (ULONG y = 0; y < image->height; ++y)
+    {
+        for (ULONG x = 0; x < image->width; ++x)
+        {
+            ULONG value = image->data[pixel_index(image, {x, y})];
+            if (value_size == 1)
+            {
+                row[x] = static_cast<char>(value);
             }
             else
             {
-                if (x + 1 < image->width)
-                {
-                    out << endl;
-                }
+                row[2 * x] = static_cast<char>(value >> 8u);
+                row[2 * x + 1] = static_cast<char>(value & 0xFFu);
             }
         }
-        out << endl;
+        out.write(row.data(), static_cast<streamsize>(row.size()));
     }
-    return out;
 }
 
-istream& operator>>(istream& in, PGM_IO& ppm_io)
+ostream& operator<<(ostream& out, const PGM_IO& ppm_io)
 {
-    string format_code = PGM_IO::read_pgm_instruction(in);
-    if (format_code != PGM_IO::FORMAT_CODE)
+    if (!ppm_io.get_image() || !image_valid(ppm_io.get_image().get()))
     {
-        in.setstate(ios_base::failbit);
-        return in;
+        return out;
     }
+    shared_ptr<struct Image> image = ppm_io.get_image();
+    if (ppm_io.is_binary())
+    {
+        if (image->max_value > PGM_IO::MAX_BINARY_VALUE)
+        {
+            out.setstate(ios_base::failbit);
+            return out;
+        }
+        out << PGM_IO::BINARY_FORMAT_CODE << '\n';
+        out << image->width << ' ' << image->height << '\n';
+        out << image->max_value << '\n';
+        PGM_IO::write_binary_data(out, image.get());
+        return out;
+    }
+    out << PGM_IO::FORMAT_CODE << '\n';
+    out << image->width << ' ' << image->height << '\n';
+    out << image->max_value << '\n';
+    PGM_IO::write_plain_data(out, image.get());
+    return out;
+}
 
+istream& operator>>(istream& in, PGM_IO& ppm_io)
+{
     shared_ptr<struct Image> image =
         make_shared<struct Image>(Image{0, 0, 0, {}});
 
-    try
+    bool binary = false;
+    if (!PGM_IO::read_header(in, image.get(), &binary))
     {
-        image->width = stoul(PGM_IO::read_pgm_instruction(in));
-        image->height = stoul(PGM_IO::read_pgm_instruction(in));
-        image->max_value = stoul(PGM_IO::read_pgm_instruction(in));
+        in.setstate(ios_base::failbit);
+        return in;
     }
-    catch (invalid_argument&)
+    if (binary)
     {
-        in.setstate(ios_base::failbit);
+        image->data = Pixels(image->width * image->height, image->max_value);
+        if (!PGM_IO::read_binary_data(in, image.get()))
+        {
+            in.setstate(ios_base::failbit);
+            return in;
+        }
+        ppm_io.set_image(image);
+        ppm_io.set_binary(true);
         return in;
     }
 
-    if (image->max_value > PGM_IO::MAX_VALUE_LIMIT)
+    const string contents{
+        std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>()
+    };
+    in.setstate(ios_base::eofbit);
+    if (
+        !PGM_IO::read_plain_data(
+            contents.data(),
+            contents.data() + contents.size(),
+            image.get()
+        )
+    )
     {
         in.setstate(ios_base::failbit);
         return in;
     }
-    image->data.resize(image->width * image->height);
 
-    for (ULONG y = 0; y < image->height; ++y)
+    ppm_io.set_image(image);
+    ppm_io.set_binary(false);
+
+    return in;
+}
+
+bool view_binary_pgm(const char* begin, const char* end, struct PGMView* view)
+{
+    MemoryBuffer buffer{begin, end};
+    istream in{&buffer};
+    struct Image header{0, 0, 0, {}};
+    bool binary = false;
+    if (!PGM_IO::read_header(in, &header, &binary) || !binary)
     {
-        for (ULONG x = 0; x < image->width; ++x)
-        {
-            try
-            {
-                image->data[pixel_index(image.get(), {x, y})] =
-                    stoul(PGM_IO::read_pgm_instruction(in));
-            }
-            catch (invalid_argument&)
+        return false;
+    }
+    const size_t available =
+        static_cast<size_t>(end - begin) - buffer.position();
+    ULONG count = 0;
+    ULONG bytes = 0;
+    if (
+        !pixels_count(&header, &count)
+        || !checked_multiply(count, binary_value_size(header.max_value), &bytes)
+        || bytes > available
+    )
+    {
+        return false;
+    }
+    view->width = header.width;
+    view->height = header.height;
+    view->max_value = header.max_value;
+    view->pixels =
+        reinterpret_cast<const unsigned char*>(begin + buffer.position());
+    return true;
+}
+
+ULONG pgm_view_value(const struct PGMView* view, ULONG index)
+{
+    return decode_binary_value(view->pixels, view->max_value, index);
+}
+
+shared_ptr<struct Image> read_pgm(const string& path)
+{
+    MappedFile file{path};
+    const char* begin = file.data();
+    const char* end = file.data() + file.size();
+
+    struct PGMView view{0, 0, 0, nullptr};
+    if (view_binary_pgm(begin, end, &view))
+    {
+        shared_ptr<struct Image> image = make_shared<struct Image>(
+            Image{view.width, view.height, view.max_value, {}}
+        );
+        image->data = Pixels(view.width * view.height, view.max_value);
+        bool decoded = image->data.visit(
+            [&view](auto* data)
             {
-                in.setstate(ios_base::failbit);
-                return in;
+                using Value = std::remove_reference_t<decltype(*data)>;
+                for (ULONG index = 0; index < view.width * view.height; ++index)
+                {
+                    ULONG value = pgm_view_value(&view, index);
+                    if (value > view.max_value)
+                    {
+                        return false;
+                    }
+                    data[index] = static_cast<Value>(value);
+                }
+                return true;
             }
-        }
+        );
+        return decoded ? image : nullptr;
     }
 
-    PGM_IO::check_file_end(in);
-
-    ppm_io.set_image(image);
+    MemoryBuffer buffer{begin, end};
+    istream in{&buffer};
+    shared_ptr<struct Image> image =
+        make_shared<struct Image>(Image{0, 0, 0, {}});
+    bool binary = false;
+    if (
+        !PGM_IO::read_header(in, image.get(), &binary)
+        || binary
+        || !PGM_IO::read_plain_data(begin + buffer.position(), end, image.get())
+    )
+    {
+        return nullptr;
+    }
+    return image;
+}
 
-    return in;
+shared_ptr<struct Image> read_pgm_header(const string& path)
+{
+    std::ifstream in{path, std::ios::in | std::ios::binary};
+    shared_ptr<struct Image> image =
+        make_shared<struct Image>(Image{0, 0, 0, {}});
+    bool binary = false;
+    if (!in || !PGM_IO::read_header(in, image.get(), &binary))
+    {
+        return nullptr;
+    }
+    return image;
 }
 
 }
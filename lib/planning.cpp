@@ -0,0 +1,412 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <planning.hpp>
+#include <arc_consistency.hpp>
+#include <availability.hpp>
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <pyramid.hpp>
+#include <tiling.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _OPENMP
+#define MAX_THREADS_NUMBER (static_cast<ULONG>(omp_get_max_threads()))
+#else
+#define MAX_THREADS_NUMBER (1ul)
+#endif
+
+namespace sp::planning
+{
+
+using sp::graph::arc_consistency::support_counter_bytes;
+using sp::graph::availability::NodesAvailability;
+using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::image::Pixels;
+using sp::pyramid::coarse_disparity_levels;
+using sp::tiling::HaloTile;
+using sp::tiling::plan_tiles;
+using sp::types::FLOAT;
+using std::invalid_argument;
+
+namespace
+{
+
+/**
+ * \brief Bytes of a disparity map with values up to `disparity_levels`.
+ */
+ULONG disparity_map_bytes(ULONG pixels, ULONG disparity_levels)
+{
+    return pixels * Pixels(0, disparity_levels).bytes_per_pixel();
+}
+
+/**
+ * \brief Peak footprint of sp::planning::Layout::pyramid_levels
+ * levels solved coarse-to-fine, ignoring tiles.
+ */
+struct Footprint estimate_images(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    const struct Layout* layout
+)
+{
+    std::vector<ULONG> widths{width};
+    std::vector<ULONG> heights{height};
+    std::vector<ULONG> levels_disparities{disparity_levels};
+    ULONG images = 2 * width * height * bytes_per_pixel;
+    while (widths.size() <= layout->pyramid_levels)
+    {
+        widths.push_back((widths.back() + 1) / 2);
+        heights.push_back((heights.back() + 1) / 2);
+        levels_disparities.push_back(
+            coarse_disparity_levels(levels_disparities.back())
+        );
+        images += 2 * widths.back() * heights.back() * bytes_per_pixel;
+    }
+
+    struct Footprint result;
+    for (ULONG level = 0; level < widths.size(); ++level)
+    {
+        const BOOL windows = level + 1 < widths.size()
+            && layout->window < levels_disparities[level];
+        struct Footprint footprint = estimate_level(
+            widths[level],
+            heights[level],
+            windows ? layout->window : levels_disparities[level],
+            bytes_per_pixel,
+            windows,
+            layout->cache_node_penalties
+        );
+        if (level + 1 < widths.size())
+        {
+            footprint.disparity_maps += disparity_map_bytes(
+                widths[level + 1] * heights[level + 1],
+                levels_disparities[level + 1]
+            );
+        }
+        if (total(&footprint) > total(&result))
+        {
+            result = footprint;
+        }
+    }
+    result.images += images;
+    return result;
+}
+
+/**
+ * \brief Check whether the layout fits into the budget.
+ */
+BOOL fits(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    ULONG budget,
+    const struct Layout* layout
+)
+{
+    struct Footprint footprint = estimate_footprint(
+        width,
+        height,
+        disparity_levels,
+        bytes_per_pixel,
+        layout
+    );
+    return total(&footprint) <= budget;
+}
+
+}
+
+ULONG total(const struct Footprint* footprint)
+{
+    return footprint->images
+        + footprint->disparity_graph
+        + footprint->lowest_penalties
+        + footprint->threshold_search
+        + footprint->threshold_candidates
+        + footprint->constraint_graph
+        + footprint->arc_consistency
+        + footprint->disparity_maps;
+}
+
+struct Footprint estimate_level(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    BOOL windows,
+    BOOL cache_node_penalties
+)
+{
+    const ULONG pixels = width * height;
+    const ULONG nodes = pixels * disparity_levels;
+    const ULONG availability = pixels
+        * (
+            (disparity_levels + NodesAvailability::WORD_BITS - 1)
+            / NodesAvailability::WORD_BITS
+        )
+        * sizeof(NodesAvailability::WORD);
+
+    struct Footprint result;
+    result.images = 2 * pixels * bytes_per_pixel;
+    result.disparity_graph = nodes * NEIGHBORS_COUNT * sizeof(FLOAT);
+    if (cache_node_penalties)
+    {
+        result.disparity_graph += nodes * sizeof(FLOAT);
+    }
+    if (windows)
+    {
+        result.disparity_graph += pixels * sizeof(ULONG);
+    }
+    result.lowest_penalties = pixels * (1 + NEIGHBORS_COUNT) * sizeof(FLOAT);
+    result.threshold_search = nodes * sizeof(FLOAT) + availability;
+    const ULONG candidates = nodes
+        + pixels * NEIGHBORS_COUNT * disparity_levels * disparity_levels;
+    result.threshold_candidates = (
+        2 * candidates
+        + MAX_THREADS_NUMBER * disparity_levels * disparity_levels
+    ) * sizeof(FLOAT);
+    result.constraint_graph = 2 * availability;
+    result.arc_consistency = availability
+        + nodes * NEIGHBORS_COUNT * support_counter_bytes(disparity_levels)
+        + 2 * pixels * sizeof(ULONG);
+    result.disparity_maps = disparity_map_bytes(pixels, disparity_levels);
+    return result;
+}
+
+struct Footprint estimate_footprint(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    const struct Layout* layout
+)
+{
+    if (layout->tile_width == 0 || layout->tile_height == 0)
+    {
+        return estimate_images(
+            width,
+            height,
+            disparity_levels,
+            bytes_per_pixel,
+            layout
+        );
+    }
+
+    struct Footprint result;
+    for (
+        const struct HaloTile& tile : plan_tiles(
+            width,
+            height,
+            disparity_levels,
+            layout->tile_width,
+            layout->tile_height,
+            layout->halo
+        )
+    )
+    {
+        struct Footprint footprint = estimate_images(
+            tile.extended.width,
+            tile.extended.height,
+            std::min(disparity_levels, tile.extended.width),
+            bytes_per_pixel,
+            layout
+        );
+        if (total(&footprint) > total(&result))
+        {
+            result = footprint;
+        }
+    }
+    result.images += 2 * width * height * bytes_per_pixel;
+    result.disparity_maps
+        += disparity_map_bytes(width * height, disparity_levels);
+    return result;
+}
+
+struct Layout plan_layout(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG bytes_per_pixel,
+    ULONG budget,
+    const struct Layout& preferred,
+    BOOL allow_pyramid
+)
+{
+    struct Layout layout{preferred};
+    if (fits(width, height, disparity_levels, bytes_per_pixel, budget, &layout))
+    {
+        return layout;
+    }
+
+    layout.cache_node_penalties = false;
+    if (fits(width, height, disparity_levels, bytes_per_pixel, budget, &layout))
+    {
+        return layout;
+    }
+
+    if (allow_pyramid && layout.tile_width == 0)
+    {
+        struct Layout pyramid{layout};
+        ULONG coarse_width = width;
+        ULONG coarse_disparities = disparity_levels;
+        for (ULONG level = 0; level < layout.pyramid_levels; ++level)
+        {
+            coarse_width = (coarse_width + 1) / 2;
+            coarse_disparities = coarse_disparity_levels(coarse_disparities);
+        }
+        for (
+            pyramid.pyramid_levels = layout.pyramid_levels + 1;
+            coarse_width > 1 && coarse_disparities > pyramid.window;
+            ++pyramid.pyramid_levels
+        )
+        {
+            if (
+                fits(
+                    width,
+                    height,
+                    disparity_levels,
+                    bytes_per_pixel,
+                    budget,
+                    &pyramid
+                )
+            )
+            {
+                return pyramid;
+            }
+            coarse_width = (coarse_width + 1) / 2;
+            coarse_disparities = coarse_disparity_levels(coarse_disparities);
+        }
+    }
+
+    layout.tile_width = 1;
+    layout.tile_height = 1;
+    struct Footprint smallest_tiles = estimate_footprint(
+        width,
+        height,
+        disparity_levels,
+        bytes_per_pixel,
+        &layout
+    );
+    if (total(&smallest_tiles) > budget)
+    {
+        throw invalid_argument(
+            "Even the smallest tiles need "
+            + std::to_string(total(&smallest_tiles))
+            + " bytes, which exceeds the budget of "
+            + std::to_string(budget) + " bytes."
+        );
+    }
+    ULONG smallest = 1;
+    ULONG largest = std::max(width, height);
+    while (smallest < largest)
+    {
+        layout.tile_width = (smallest + largest + 1) / 2;
+        layout.tile_height = layout.tile_width;
+        if (
+            fits(
+                width,
+                height,
+                disparity_levels,
+                bytes_per_pixel,
+                budget,
+                &layout
+            )
+        )
+        {
+            smallest = layout.tile_width;
+        }
+        else
+        {
+            largest = layout.tile_width - 1;
+        }
+    }
+    layout.tile_width = smallest;
+    layout.tile_height = smallest;
+    return layout;
+}
+
+ULONG parse_memory_size(const std::string& size)
+{
+    std::size_t digits = 0;
+    while (
+        digits < size.size()
+        && std::isdigit(static_cast<unsigned char>(size[digits]))
+    )
+    {
+        ++digits;
+    }
+    if (digits == 0 || size.size() > digits + 1)
+    {
+        throw invalid_argument(
+            "Memory size `" + size + "` should be a number of bytes "
+            "optionally followed by K, M or G."
+        );
+    }
+    ULONG multiplier = 1;
+    if (size.size() == digits + 1)
+    {
+        switch (std::toupper(static_cast<unsigned char>(size[digits])))
+        {
+            case 'K':
+                multiplier = 1ul << 10u;
+                break;
+            case 'M':
+                multiplier = 1ul << 20u;
+                break;
+            case 'G':
+                multiplier = 1ul << 30u;
+                break;
+            default:
+                throw invalid_argument(
+                    "Unknown suffix of memory size `" + size + "`."
+                );
+        }
+    }
+    const ULONG maximum = std::numeric_limits<ULONG>::max() / multiplier;
+    ULONG value = 0;
+    for (std::size_t index = 0; index < digits; ++index)
+    {
+        const ULONG digit = static_cast<ULONG>(size[index] - '0');
+        if (value > (maximum - digit) / 10)
+        {
+            throw invalid_argument("Memory size `" + size + "` is too large.");
+        }
+        value = value * 10 + digit;
+    }
+    return value * multiplier;
+}
+
+}
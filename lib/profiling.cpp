@@ -0,0 +1,201 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <counters.hpp>
+#include <profiling.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <iomanip>
+
+namespace sp::profiling
+{
+
+ULONG peak_rss()
+{
+    #if defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<ULONG>(usage.ru_maxrss);
+    #elif defined(__unix__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<ULONG>(usage.ru_maxrss) * 1024;
+    #else
+    return 0;
+    #endif
+}
+
+void start_stage(struct Profile* profile, const std::string& name)
+{
+    profile->stages.push_back({name, 0, 0, 0, {}});
+    profile->cpu_start = std::clock();
+    profile->wall_start = std::chrono::steady_clock::now();
+}
+
+void finish_stage(struct Profile* profile)
+{
+    struct Stage& stage = profile->stages.back();
+    stage.wall_time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - profile->wall_start
+    ).count();
+    stage.cpu_time
+        = static_cast<double>(std::clock() - profile->cpu_start)
+        / CLOCKS_PER_SEC;
+    stage.peak_rss = peak_rss();
+}
+
+void count(struct Profile* profile, const std::string& name, double value)
+{
+    profile->stages.back().counters.emplace_back(name, value);
+}
+
+void count_engine_counters(struct Profile* profile)
+{
+    const auto counters = sp::counters::collect_counters();
+    for (ULONG counter = 0; counter < counters.size(); ++counter)
+    {
+        if (counters[counter] != 0)
+        {
+            count(
+                profile,
+                sp::counters::COUNTER_NAMES[counter],
+                static_cast<double>(counters[counter])
+            );
+        }
+    }
+    sp::counters::reset_counters();
+}
+
+void merge_stages(
+    struct Profile* profile,
+    const struct Profile* part,
+    const std::vector<std::string>& maximal_counters
+)
+{
+    for (const struct Stage& stage : part->stages)
+    {
+        auto merged = std::find_if(
+            profile->stages.begin(),
+            profile->stages.end(),
+            [&stage](const struct Stage& other)
+            {
+                return other.name == stage.name;
+            }
+        );
+        if (merged == profile->stages.end())
+        {
+            profile->stages.push_back(stage);
+            continue;
+        }
+        merged->wall_time += stage.wall_time;
+        merged->cpu_time += stage.cpu_time;
+        merged->peak_rss = std::max(merged->peak_rss, stage.peak_rss);
+        for (const auto& counter : stage.counters)
+        {
+            auto merged_counter = std::find_if(
+                merged->counters.begin(),
+                merged->counters.end(),
+                [&counter](const std::pair<std::string, double>& other)
+                {
+                    return other.first == counter.first;
+                }
+            );
+            if (merged_counter == merged->counters.end())
+            {
+                merged->counters.push_back(counter);
+            }
+            else if (
+                std::find(
+                    maximal_counters.begin(),
+                    maximal_counters.end(),
+                    counter.first
+                ) != maximal_counters.end()
+            )
+            {
+                merged_counter->second
+                    = std::max(merged_counter->second, counter.second);
+            }
+            else
+            {
+                merged_counter->second += counter.second;
+            }
+        }
+    }
+}
+
+void write_text_report(std::ostream& stream, const struct Profile* profile)
+{
+    stream
+        << std::left << std::setw(28) << "stage"
+        << std::right << std::setw(12) << "wall, s"
+        << std::setw(12) << "cpu, s"
+        << std::setw(14) << "peak rss, MB"
+        << "  counters" << std::endl;
+    for (const struct Stage& stage : profile->stages)
+    {
+        stream
+            << std::left << std::setw(28) << stage.name
+            << std::right << std::fixed << std::setprecision(4)
+            << std::setw(12) << stage.wall_time
+            << std::setw(12) << stage.cpu_time
+            << std::setprecision(1)
+            << std::setw(14) << stage.peak_rss / (1024. * 1024.)
+            << std::defaultfloat << std::setprecision(9) << " ";
+        for (const auto& counter : stage.counters)
+        {
+            stream << " " << counter.first << "=" << counter.second;
+        }
+        stream << std::endl;
+    }
+}
+
+void write_json_report(std::ostream& stream, const struct Profile* profile)
+{
+    stream << "{\"stages\": [";
+    for (ULONG index = 0; index < profile->stages.size(); ++index)
+    {
+        const struct Stage& stage = profile->stages[index];
+        stream
+            << (index == 0 ? "" : ", ")
+            << "{\"name\": \"" << stage.name << "\""
+            << ", \"wall_time\": " << std::setprecision(9) << stage.wall_time
+            << ", \"cpu_time\": " << stage.cpu_time
+            << ", \"peak_rss\": " << stage.peak_rss
+            << ", \"counters\": {";
+        for (ULONG counter = 0; counter < stage.counters.size(); ++counter)
+        {
+            stream
+                << (counter == 0 ? "" : ", ")
+                << "\"" << stage.counters[counter].first << "\": "
+                << stage.counters[counter].second;
+        }
+        stream << "}}";
+    }
+    stream << "]}" << std::endl;
+}
+
+}
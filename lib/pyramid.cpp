@@ -0,0 +1,151 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <pyramid.hpp>
+#include <indexing.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace sp::pyramid
+{
+
+using sp::image::Pixels;
+using sp::indexing::pixel_index;
+using sp::indexing::pixel_value;
+using sp::types::Pixel;
+using std::invalid_argument;
+using std::to_string;
+
+struct Image downsample(const struct Image& image)
+{
+    const ULONG width = (image.width + 1) / 2;
+    const ULONG height = (image.height + 1) / 2;
+    struct Image result{
+        width,
+        height,
+        image.max_value,
+        Pixels(width * height, image.max_value)
+    };
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long y = 0; y < static_cast<long>(height); ++y)
+    {
+        struct Pixel pixel;
+        pixel.y = static_cast<ULONG>(y);
+        for (pixel.x = 0; pixel.x < width; ++pixel.x)
+        {
+            ULONG sum = 0;
+            ULONG count = 0;
+            struct Pixel source;
+            for (
+                source.y = 2 * pixel.y;
+                source.y < std::min(2 * pixel.y + 2, image.height);
+                ++source.y
+            )
+            {
+                for (
+                    source.x = 2 * pixel.x;
+                    source.x < std::min(2 * pixel.x + 2, image.width);
+                    ++source.x
+                )
+                {
+                    sum += pixel_value(&image, source);
+                    ++count;
+                }
+            }
+            result.data[pixel_index(&result, pixel)]
+                = (sum + count / 2) / count;
+        }
+    }
+    return result;
+}
+
+ULONG coarse_disparity_levels(ULONG disparity_levels)
+{
+    return (disparity_levels + 1) / 2;
+}
+
+ULONG_ARRAY upsample_minimal_disparities(
+    const struct Image& coarse_disparity_map,
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG window
+)
+{
+    if (window < 2)
+    {
+        throw invalid_argument(
+            "Window of disparities should contain at least two of them. "
+            "Provided " + to_string(window) + "."
+        );
+    }
+    if (
+        coarse_disparity_map.width != (width + 1) / 2
+        || coarse_disparity_map.height != (height + 1) / 2
+    )
+    {
+        throw invalid_argument(
+            "Disparity map of size "
+            + to_string(coarse_disparity_map.width)
+            + "x"
+            + to_string(coarse_disparity_map.height)
+            + " cannot be upsampled to "
+            + to_string(width)
+            + "x"
+            + to_string(height)
+            + "."
+        );
+    }
+    const ULONG highest_minimum
+        = disparity_levels > window ? disparity_levels - window : 0;
+    ULONG_ARRAY result(width * height);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long y = 0; y < static_cast<long>(height); ++y)
+    {
+        struct Pixel pixel;
+        pixel.y = static_cast<ULONG>(y);
+        for (pixel.x = 0; pixel.x < width; ++pixel.x)
+        {
+            struct Pixel coarse_pixel;
+            coarse_pixel.x = pixel.x / 2;
+            coarse_pixel.y = pixel.y / 2;
+            const ULONG center
+                = 2 * pixel_value(&coarse_disparity_map, coarse_pixel);
+            ULONG minimum = center > window / 2 ? center - window / 2 : 0;
+            minimum = std::min(
+                minimum,
+                std::min(highest_minimum, width - 1 - pixel.x)
+            );
+            result[pixel.x + width * pixel.y] = minimum;
+        }
+    }
+    return result;
+}
+
+}
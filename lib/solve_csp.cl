@@ -12,8 +12,8 @@ void populate_structures_gpu(
     struct LowestPenalties* lowest_penalties,
     struct ConstraintGraph* constraint_graph,
     __global int* nodes_availability,
-    __global ulong* left_image,
-    __global ulong* right_image,
+    __global ushort* left_image,
+    __global ushort* right_image,
     __global float* min_penalties_pixels,
     __global float* min_penalties_edges,
     __global float* reparametrization,
@@ -74,8 +74,8 @@ void csp_solution_iteration_gpu(
 __kernel void csp_iteration(
     __global int* nodes_availability,
     __global int* changed,
-    __global ulong* left_image,
-    __global ulong* right_image,
+    __global ushort* left_image,
+    __global ushort* right_image,
     __global float* min_penalties_pixels,
     __global float* min_penalties_edges,
     __global float* reparametrization,
@@ -130,8 +130,8 @@ __kernel void csp_iteration(
 
 __kernel void choose_best_node_gpu(
     __global int* nodes_availability,
-    __global ulong* left_image,
-    __global ulong* right_image,
+    __global ushort* left_image,
+    __global ushort* right_image,
     __global float* min_penalties_pixels,
     __global float* min_penalties_edges,
     __global float* reparametrization,
@@ -54,8 +54,8 @@ __device__ void populate_structures_gpu(
     struct LowestPenalties* lowest_penalties,
     struct ConstraintGraph* constraint_graph,
     int* nodes_availability,
-    unsigned* left_image,
-    unsigned* right_image,
+    unsigned short* left_image,
+    unsigned short* right_image,
     FLOAT* min_penalties_pixels,
     FLOAT* min_penalties_edges,
     FLOAT* reparametrization,
@@ -117,8 +117,8 @@ __device__ void csp_solution_iteration_gpu(
 __global__ void csp_iteration_cuda(
     int* nodes_availability,
     int* changed,
-    unsigned* left_image,
-    unsigned* right_image,
+    unsigned short* left_image,
+    unsigned short* right_image,
     FLOAT* min_penalties_pixels,
     FLOAT* min_penalties_edges,
     FLOAT* reparametrization,
@@ -155,8 +155,8 @@ __global__ void csp_iteration_cuda(
     );
 
     struct Pixel pixel;
-    pixel.x = blockIdx.x;
-    pixel.y = threadIdx.x;
+    pixel.x = threadIdx.x;
+    pixel.y = blockIdx.x;
 
     csp_solution_iteration_gpu(
         &constraint_graph,
@@ -167,8 +167,8 @@ __global__ void csp_iteration_cuda(
 
 __global__ void choose_best_node_gpu(
     int* nodes_availability,
-    unsigned* left_image,
-    unsigned* right_image,
+    unsigned short* left_image,
+    unsigned short* right_image,
     FLOAT* min_penalties_pixels,
     FLOAT* min_penalties_edges,
     FLOAT* reparametrization,
@@ -0,0 +1,342 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stream.hpp>
+#include <indexing.hpp>
+#include <indexing_checks.hpp>
+#include <lowest_penalties.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace sp::stream
+{
+
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::edge_penalty;
+using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::graph::lowest_penalties::lowest_neighborhood_penalty;
+using sp::indexing::checks::edge_exists;
+using sp::indexing::checks::neighborhood_exists_fast;
+using sp::indexing::checks::node_exists;
+using sp::indexing::minimal_disparity;
+using sp::indexing::neighbor_by_index;
+using sp::indexing::node_index;
+using sp::indexing::pixel_value;
+using sp::labeling::finder::calculate_approximate_consistent_threshold;
+using sp::labeling::finder::calculate_minimal_consistent_threshold;
+using sp::labeling::finder::probe_threshold;
+using sp::types::Edge;
+using sp::types::Node;
+using sp::types::Pixel;
+
+namespace
+{
+
+/**
+ * \brief Set disparity of the node of the pixel
+ * to the value of the disparity map relative to the window of the pixel.
+ *
+ * @return
+ *  `false` if the value is below the window.
+ */
+BOOL to_node_disparity(
+    const struct DisparityGraph* graph,
+    const struct Image* disparity_map,
+    struct Node* node
+)
+{
+    const ULONG value = pixel_value(disparity_map, node->pixel);
+    const ULONG minimum = minimal_disparity(graph, node->pixel);
+    if (value < minimum)
+    {
+        return false;
+    }
+    node->disparity = value - minimum;
+    return true;
+}
+
+}
+
+BOOL is_compatible(
+    const struct WarmStart* warm_start,
+    const struct DisparityGraph* graph
+)
+{
+    return warm_start->frames > 0
+        && warm_start->width == graph->right.width
+        && warm_start->height == graph->right.height
+        && warm_start->disparity_levels == graph->disparity_levels
+        && warm_start->reparametrization.size()
+            == graph->reparametrization.size();
+}
+
+BOOL seed_reparametrization(
+    const struct WarmStart* warm_start,
+    struct DisparityGraph* graph
+)
+{
+    if (
+        !is_compatible(warm_start, graph)
+        || warm_start->minimal_disparities != graph->minimal_disparities
+    )
+    {
+        return false;
+    }
+    std::copy(
+        warm_start->reparametrization.begin(),
+        warm_start->reparametrization.end(),
+        graph->reparametrization.begin()
+    );
+    if (!graph->node_penalties.empty())
+    {
+        cache_node_penalties(graph);
+    }
+    return true;
+}
+
+FLOAT calculate_labeling_slack(
+    const struct ThresholdSearch* search,
+    const struct Image* disparity_map
+)
+{
+    const struct DisparityGraph* graph = search->disparity_graph;
+    const FLOAT infinity = std::numeric_limits<FLOAT>::infinity();
+    if (
+        disparity_map->width != graph->right.width
+        || disparity_map->height != graph->right.height
+    )
+    {
+        return infinity;
+    }
+
+    FLOAT slack = -infinity;
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(max:slack)
+    #endif
+    for (long y = 0; y < static_cast<long>(graph->right.height); ++y)
+    {
+        struct Edge edge;
+        edge.node.pixel.y = static_cast<ULONG>(y);
+        for (
+            edge.node.pixel.x = 0;
+            edge.node.pixel.x < graph->right.width;
+            ++edge.node.pixel.x
+        )
+        {
+            if (!to_node_disparity(graph, disparity_map, &edge.node))
+            {
+                slack = infinity;
+                continue;
+            }
+            if (!node_exists(graph, edge.node))
+            {
+                slack = infinity;
+                continue;
+            }
+            slack = std::max(
+                slack,
+                search->nodes_slacks[node_index(graph, edge.node)]
+            );
+            for (
+                ULONG neighbor_index = 0;
+                neighbor_index < NEIGHBORS_COUNT;
+                ++neighbor_index
+            )
+            {
+                if (
+                    !neighborhood_exists_fast(
+                        graph,
+                        edge.node.pixel,
+                        neighbor_index
+                    )
+                )
+                {
+                    continue;
+                }
+                edge.neighbor.pixel = neighbor_by_index(
+                    edge.node.pixel,
+                    neighbor_index
+                );
+                if (
+                    !to_node_disparity(graph, disparity_map, &edge.neighbor)
+                    || !edge_exists(graph, edge)
+                )
+                {
+                    slack = infinity;
+                    continue;
+                }
+                slack = std::max(
+                    slack,
+                    edge_penalty(graph, edge)
+                        - lowest_neighborhood_penalty(
+                            search->lowest_penalties,
+                            edge
+                        )
+                );
+            }
+        }
+    }
+    return slack;
+}
+
+FLOAT calculate_warm_threshold(
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties,
+    FLOAT guess,
+    FLOAT upper_bound,
+    FLOAT tolerance
+)
+{
+    const ULONG size = available_penalties.size();
+    ULONG start = 0;
+    ULONG end = std::min(
+        static_cast<ULONG>(
+            std::lower_bound(
+                available_penalties.begin(),
+                available_penalties.end(),
+                upper_bound
+            ) - available_penalties.begin()
+        ),
+        size - 1
+    );
+    ULONG center = std::min(
+        static_cast<ULONG>(
+            std::lower_bound(
+                available_penalties.begin(),
+                available_penalties.end(),
+                guess
+            ) - available_penalties.begin()
+        ),
+        end
+    );
+
+    if (center == end || probe_threshold(search, available_penalties[center]))
+    {
+        end = center;
+        for (ULONG step = 1; start < end; step *= 2)
+        {
+            if (step > (end - start) / 2)
+            {
+                break;
+            }
+            ULONG current_index = end - step;
+            if (!probe_threshold(search, available_penalties[current_index]))
+            {
+                start = current_index + 1;
+                break;
+            }
+            end = current_index;
+        }
+    }
+    else
+    {
+        start = center + 1;
+        for (ULONG step = 1; start < end; step *= 2)
+        {
+            if (step > (end - start) / 2)
+            {
+                break;
+            }
+            ULONG current_index = start + step - 1;
+            if (probe_threshold(search, available_penalties[current_index]))
+            {
+                end = current_index;
+                break;
+            }
+            start = current_index + 1;
+        }
+    }
+
+    while (
+        start < end
+        && (
+            start == 0
+            || available_penalties[end] - available_penalties[start - 1]
+                > tolerance
+        )
+    )
+    {
+        ULONG current_index = (start + end) / 2;
+        if (probe_threshold(search, available_penalties[current_index]))
+        {
+            end = current_index;
+        }
+        else
+        {
+            start = current_index + 1;
+        }
+    }
+    return available_penalties[end];
+}
+
+FLOAT calculate_stream_threshold(
+    const struct WarmStart* warm_start,
+    struct ThresholdSearch* search,
+    const FLOAT_ARRAY& available_penalties,
+    FLOAT tolerance
+)
+{
+    if (!is_compatible(warm_start, search->disparity_graph))
+    {
+        return tolerance > 0
+            ? calculate_approximate_consistent_threshold(
+                search,
+                available_penalties,
+                tolerance
+            )
+            : calculate_minimal_consistent_threshold(
+                search,
+                available_penalties
+            );
+    }
+    return calculate_warm_threshold(
+        search,
+        available_penalties,
+        warm_start->threshold,
+        calculate_labeling_slack(search, &warm_start->disparity_map),
+        tolerance
+    );
+}
+
+void remember_frame(
+    struct WarmStart* warm_start,
+    const struct DisparityGraph* graph,
+    FLOAT threshold,
+    const struct Image& disparity_map
+)
+{
+    ++warm_start->frames;
+    warm_start->width = graph->right.width;
+    warm_start->height = graph->right.height;
+    warm_start->disparity_levels = graph->disparity_levels;
+    warm_start->threshold = threshold;
+    warm_start->minimal_disparities = graph->minimal_disparities;
+    warm_start->reparametrization.assign(
+        graph->reparametrization.begin(),
+        graph->reparametrization.end()
+    );
+    warm_start->disparity_map = disparity_map;
+}
+
+}
@@ -0,0 +1,258 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <tile_scheduler.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _OPENMP
+#define MAX_THREADS_NUMBER (static_cast<ULONG>(omp_get_max_threads()))
+#define THREADS_NUMBER (static_cast<ULONG>(omp_get_num_threads()))
+#define THREAD_ID (static_cast<ULONG>(omp_get_thread_num()))
+#else
+#define MAX_THREADS_NUMBER (1ul)
+#define THREADS_NUMBER (1ul)
+#define THREAD_ID (0ul)
+#endif
+
+namespace sp::scheduling
+{
+
+using std::lock_guard;
+using std::memory_order_relaxed;
+using std::mutex;
+
+TileScheduler::TileScheduler(
+    ULONG width,
+    ULONG height,
+    ULONG tile_width,
+    ULONG tile_height,
+    ULONG threads
+)
+    : width{width}
+    , height{height}
+    , tile_width{tile_width}
+    , tile_height{tile_height}
+    , columns{tile_width > 0 ? (width + tile_width - 1) / tile_width : 0}
+    , rows{tile_height > 0 ? (height + tile_height - 1) / tile_height : 0}
+    , threads{threads > 0 ? threads : MAX_THREADS_NUMBER}
+{
+    if (width == 0 || height == 0)
+    {
+        throw std::invalid_argument("Cannot split an empty image into tiles.");
+    }
+    if (tile_width == 0 || tile_height == 0)
+    {
+        throw std::invalid_argument("Tiles should contain at least one pixel.");
+    }
+    this->order.reserve(this->get_tiles());
+    this->dirty.reset(new std::atomic<BOOL>[this->get_tiles()]);
+    this->queues.reset(new Queue[this->threads]);
+    this->mark_all_dirty();
+}
+
+ULONG TileScheduler::get_tiles() const
+{
+    return this->columns * this->rows;
+}
+
+ULONG TileScheduler::get_threads() const
+{
+    return this->threads;
+}
+
+ULONG TileScheduler::get_sweeps() const
+{
+    return this->sweeps;
+}
+
+struct Tile TileScheduler::tile(ULONG index) const
+{
+    struct Tile result;
+    result.x = (index % this->columns) * this->tile_width;
+    result.y = (index / this->columns) * this->tile_height;
+    result.width = std::min(this->tile_width, this->width - result.x);
+    result.height = std::min(this->tile_height, this->height - result.y);
+    return result;
+}
+
+void TileScheduler::mark_dirty(ULONG index)
+{
+    this->dirty[index].store(true, memory_order_relaxed);
+}
+
+void TileScheduler::mark_all_dirty()
+{
+    for (ULONG index = 0; index < this->get_tiles(); ++index)
+    {
+        this->mark_dirty(index);
+    }
+}
+
+BOOL TileScheduler::any_dirty() const
+{
+    for (ULONG index = 0; index < this->get_tiles(); ++index)
+    {
+        if (this->dirty[index].load(memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TileScheduler::stop()
+{
+    this->stopped.store(true, memory_order_relaxed);
+}
+
+BOOL TileScheduler::is_stopped() const
+{
+    return this->stopped.load(memory_order_relaxed);
+}
+
+void TileScheduler::run(const Task& task)
+{
+    this->sweeps = 0;
+    this->stopped.store(false, memory_order_relaxed);
+    BOOL finished = false;
+
+    #ifdef _OPENMP
+    #pragma omp parallel num_threads(this->threads)
+    #endif
+    {
+        const ULONG thread = THREAD_ID;
+        const ULONG team = THREADS_NUMBER;
+        while (true)
+        {
+            #ifdef _OPENMP
+            #pragma omp single
+            #endif
+            {
+                finished = this->is_stopped() || !this->prepare_sweep(team);
+            }
+            if (finished)
+            {
+                break;
+            }
+
+            ULONG index = 0;
+            while (this->take(thread, team, &index))
+            {
+                if (this->is_stopped())
+                {
+                    this->mark_dirty(index);
+                    continue;
+                }
+                if (task(this->tile(index)))
+                {
+                    this->mark_changed(index);
+                }
+            }
+            #ifdef _OPENMP
+            #pragma omp barrier
+            #endif
+        }
+    }
+}
+
+BOOL TileScheduler::take(ULONG thread, ULONG team, ULONG* tile)
+{
+    {
+        Queue& own = this->queues[thread];
+        lock_guard<mutex> lock{own.mutex};
+        if (own.begin < own.end)
+        {
+            *tile = this->order[own.begin++];
+            return true;
+        }
+    }
+    for (ULONG shift = 1; shift < team; ++shift)
+    {
+        Queue& victim = this->queues[(thread + shift) % team];
+        lock_guard<mutex> lock{victim.mutex};
+        if (victim.begin < victim.end)
+        {
+            *tile = this->order[--victim.end];
+            return true;
+        }
+    }
+    return false;
+}
+
+void TileScheduler::mark_changed(ULONG index)
+{
+    const ULONG column = index % this->columns;
+    const ULONG row = index / this->columns;
+    this->mark_dirty(index);
+    if (column > 0)
+    {
+        this->mark_dirty(index - 1);
+    }
+    if (column + 1 < this->columns)
+    {
+        this->mark_dirty(index + 1);
+    }
+    if (row > 0)
+    {
+        this->mark_dirty(index - this->columns);
+    }
+    if (row + 1 < this->rows)
+    {
+        this->mark_dirty(index + this->columns);
+    }
+}
+
+BOOL TileScheduler::prepare_sweep(ULONG team)
+{
+    this->order.clear();
+    for (ULONG index = 0; index < this->get_tiles(); ++index)
+    {
+        if (this->dirty[index].exchange(false, memory_order_relaxed))
+        {
+            this->order.push_back(index);
+        }
+    }
+    if (this->order.empty())
+    {
+        return false;
+    }
+    ++this->sweeps;
+
+    const ULONG size = this->order.size();
+    for (ULONG thread = 0; thread < team; ++thread)
+    {
+        Queue& queue = this->queues[thread];
+        lock_guard<mutex> lock{queue.mutex};
+        queue.begin = size * thread / team;
+        queue.end = size * (thread + 1) / team;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <tiling.hpp>
+#include <indexing.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace sp::tiling
+{
+
+using sp::image::Pixels;
+using sp::indexing::pixel_index;
+using sp::indexing::pixel_value;
+using sp::types::Pixel;
+using std::invalid_argument;
+using std::to_string;
+
+std::vector<struct HaloTile> plan_tiles(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    ULONG tile_width,
+    ULONG tile_height,
+    ULONG halo
+)
+{
+    if (width == 0 || height == 0)
+    {
+        throw invalid_argument("Cannot split an empty image into tiles.");
+    }
+    if (tile_width == 0 || tile_height == 0)
+    {
+        throw invalid_argument("Tiles should contain at least one pixel.");
+    }
+    const ULONG margin = disparity_levels > 0 ? disparity_levels - 1 : 0;
+    std::vector<struct HaloTile> result;
+    for (ULONG y = 0; y < height; y += tile_height)
+    {
+        for (ULONG x = 0; x < width; x += tile_width)
+        {
+            struct HaloTile tile;
+            tile.core.x = x;
+            tile.core.y = y;
+            tile.core.width = std::min(tile_width, width - x);
+            tile.core.height = std::min(tile_height, height - y);
+            tile.extended.x = x > halo ? x - halo : 0;
+            tile.extended.y = y > halo ? y - halo : 0;
+            tile.extended.width = std::min(
+                tile.core.x + tile.core.width + halo + margin,
+                width
+            ) - tile.extended.x;
+            tile.extended.height = std::min(
+                tile.core.y + tile.core.height + halo,
+                height
+            ) - tile.extended.y;
+            result.push_back(tile);
+        }
+    }
+    return result;
+}
+
+struct Image crop(const struct Image& image, const struct Tile& tile)
+{
+    if (
+        tile.x + tile.width > image.width
+        || tile.y + tile.height > image.height
+    )
+    {
+        throw invalid_argument(
+            "Tile "
+            + to_string(tile.width)
+            + "x"
+            + to_string(tile.height)
+            + " at <"
+            + to_string(tile.x)
+            + ", "
+            + to_string(tile.y)
+            + "> exceeds the image "
+            + to_string(image.width)
+            + "x"
+            + to_string(image.height)
+            + "."
+        );
+    }
+    struct Image result{
+        tile.width,
+        tile.height,
+        image.max_value,
+        Pixels(tile.width * tile.height, image.max_value)
+    };
+    struct Pixel pixel;
+    for (pixel.y = 0; pixel.y < tile.height; ++pixel.y)
+    {
+        for (pixel.x = 0; pixel.x < tile.width; ++pixel.x)
+        {
+            result.data[pixel_index(&result, pixel)] = pixel_value(
+                &image,
+                {tile.x + pixel.x, tile.y + pixel.y}
+            );
+        }
+    }
+    return result;
+}
+
+void stitch(
+    struct Image* disparity_map,
+    const struct Image& tile_map,
+    const struct HaloTile& tile
+)
+{
+    struct Pixel pixel;
+    for (
+        pixel.y = tile.core.y;
+        pixel.y < tile.core.y + tile.core.height;
+        ++pixel.y
+    )
+    {
+        for (
+            pixel.x = tile.core.x;
+            pixel.x < tile.core.x + tile.core.width;
+            ++pixel.x
+        )
+        {
+            disparity_map->data[pixel_index(disparity_map, pixel)]
+                = pixel_value(
+                    &tile_map,
+                    {pixel.x - tile.extended.x, pixel.y - tile.extended.y}
+                );
+        }
+    }
+}
+
+}
@@ -0,0 +1,352 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <arc_consistency.hpp>
+#include <constraint_graph.hpp>
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <labeling_finder.hpp>
+#include <lowest_penalties.hpp>
+#include <pgm_io.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(ArcConsistencyTest)
+
+using sp::graph::arc_consistency::ArcConsistency;
+using sp::graph::arc_consistency::support_counter_bytes;
+using sp::graph::arc_consistency::Propagation;
+using sp::graph::arc_consistency::propagate;
+using sp::graph::arc_consistency::propagate_from;
+using sp::graph::arc_consistency::solve_csp_worklist;
+using sp::graph::constraint::ConstraintGraph;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::lowest_penalties::LowestPenalties;
+using sp::image::Image;
+using sp::image::PGM_IO;
+using sp::labeling::finder::fetch_available_penalties;
+using sp::types::FLOAT;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+BOOST_AUTO_TEST_CASE(check_removal)
+{
+    PGM_IO pgm_io;
+    std::istringstream left_image_content{R"image(
+    P2
+    3 2
+    10
+    4 5 10
+    0 0 0
+    )image"};
+    std::istringstream right_image_content{R"image(
+    P2
+    3 2
+    10
+    10 7 0
+    0 0 0
+    )image"};
+
+    left_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image left_image{*pgm_io.get_image()};
+
+    right_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image right_image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 3, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    struct ConstraintGraph constraint_graph{&disparity_graph, &lowest_penalties, 16};
+
+    BOOST_CHECK(solve_csp_worklist(&constraint_graph));
+
+    BOOST_CHECK(!is_node_available(&constraint_graph, {{0, 0}, 0}));
+    BOOST_CHECK(!is_node_available(&constraint_graph, {{0, 0}, 1}));
+    BOOST_CHECK(is_node_available(&constraint_graph, {{0, 0}, 2}));
+
+    BOOST_CHECK(!is_node_available(&constraint_graph, {{1, 0}, 0}));
+    BOOST_CHECK(is_node_available(&constraint_graph, {{1, 0}, 1}));
+}
+
+BOOST_AUTO_TEST_CASE(check_unsolvable)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{R"image(
+    P2
+    4 3
+    1
+    0 0 0 0
+    0 0 0 0
+    0 0 0 0
+    )image"};
+
+    image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{image, image, 4, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    struct ConstraintGraph constraint_graph{&disparity_graph, &lowest_penalties, 9};
+
+    for (ULONG disparity = 0; disparity < 3; ++disparity)
+    {
+        make_node_unavailable(&constraint_graph, {{1, 1}, disparity});
+    }
+
+    BOOST_CHECK(!solve_csp_worklist(&constraint_graph));
+    BOOST_CHECK(!check_nodes_left(&constraint_graph));
+}
+
+BOOST_AUTO_TEST_CASE(check_propagate_from)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{R"image(
+    P2
+    4 3
+    1
+    0 0 0 0
+    0 0 0 0
+    0 0 0 0
+    )image"};
+
+    image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{image, image, 4, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    struct ConstraintGraph sweep{&disparity_graph, &lowest_penalties, 1};
+    BOOST_CHECK(solve_csp(&sweep));
+    struct ConstraintGraph worklist{sweep};
+
+    struct ArcConsistency state{&worklist};
+    BOOST_CHECK(propagate(&state));
+    BOOST_CHECK_EQUAL(state.propagation.removed_nodes, 0);
+
+    for (ULONG disparity = 1; disparity < 4; ++disparity)
+    {
+        make_node_unavailable(&sweep, {{0, 1}, disparity});
+        make_node_unavailable(&worklist, {{0, 1}, disparity});
+    }
+    BOOST_CHECK(solve_csp(&sweep));
+
+    ULONG nodes_count = worklist.nodes_availability.count();
+    struct Propagation propagation = propagate_from(&state, {0, 1});
+    BOOST_CHECK(propagation.solvable);
+    BOOST_CHECK_EQUAL(
+        propagation.removed_nodes,
+        nodes_count + 3 - worklist.nodes_availability.count()
+    );
+    BOOST_CHECK_EQUAL(propagation.first.x, 0);
+    BOOST_CHECK_EQUAL(propagation.first.y, 0);
+    BOOST_CHECK_EQUAL(propagation.last.x, 1);
+    BOOST_CHECK_EQUAL(propagation.last.y, 2);
+
+    std::vector<int> expected = sweep.nodes_availability.flatten<int>();
+    std::vector<int> actual = worklist.nodes_availability.flatten<int>();
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        actual.begin(), actual.end(),
+        expected.begin(), expected.end()
+    );
+
+    propagation = propagate_from(&state, {0, 1});
+    BOOST_CHECK(propagation.solvable);
+    BOOST_CHECK_EQUAL(propagation.removed_nodes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(check_same_as_sweep)
+{
+    PGM_IO pgm_io;
+    std::istringstream left_image_content{R"image(
+    P2
+    6 4
+    10
+    4 5 10 3 2 9
+    0 1 7 7 8 2
+    3 3 0 9 4 4
+    10 6 5 1 0 8
+    )image"};
+    std::istringstream right_image_content{R"image(
+    P2
+    6 4
+    10
+    10 7 0 3 2 1
+    1 7 6 8 2 2
+    3 0 9 9 4 5
+    6 5 1 0 8 8
+    )image"};
+
+    left_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image left_image{*pgm_io.get_image()};
+
+    right_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image right_image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 4, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+
+    for (FLOAT threshold : fetch_available_penalties(&lowest_penalties))
+    {
+        struct ConstraintGraph sweep{&disparity_graph, &lowest_penalties, threshold};
+        struct ConstraintGraph worklist{sweep};
+
+        BOOST_CHECK_EQUAL(solve_csp(&sweep), solve_csp_worklist(&worklist));
+
+        std::vector<int> expected = sweep.nodes_availability.flatten<int>();
+        std::vector<int> actual = worklist.nodes_availability.flatten<int>();
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            actual.begin(), actual.end(),
+            expected.begin(), expected.end()
+        );
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_wide_supports)
+{
+    BOOST_CHECK_EQUAL(support_counter_bytes(1), 2);
+    BOOST_CHECK_EQUAL(support_counter_bytes(65535), 2);
+    BOOST_CHECK_EQUAL(support_counter_bytes(65536), 4);
+
+    struct Image left_image{
+        6, 4, 10,
+        ULONG_ARRAY{
+            4, 5, 10, 3, 2, 9,
+            0, 1, 7, 7, 8, 2,
+            3, 3, 0, 9, 4, 4,
+            10, 6, 5, 1, 0, 8
+        }
+    };
+    struct Image right_image{
+        6, 4, 10,
+        ULONG_ARRAY{
+            10, 7, 0, 3, 2, 1,
+            1, 7, 6, 8, 2, 2,
+            3, 0, 9, 9, 4, 5,
+            6, 5, 1, 0, 8, 8
+        }
+    };
+    struct DisparityGraph disparity_graph{left_image, right_image, 4, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+
+    for (FLOAT threshold : fetch_available_penalties(&lowest_penalties))
+    {
+        struct ConstraintGraph narrow{
+            &disparity_graph,
+            &lowest_penalties,
+            threshold
+        };
+        struct ConstraintGraph wide{narrow};
+        struct ArcConsistency narrow_state{&narrow};
+        struct ArcConsistency wide_state{&wide, 4};
+        BOOST_CHECK(narrow_state.wide_supports.empty());
+        BOOST_CHECK(wide_state.supports.empty());
+        BOOST_CHECK_EQUAL(
+            wide_state.wide_supports.size(),
+            narrow_state.supports.size()
+        );
+
+        BOOST_CHECK_EQUAL(propagate(&narrow_state), propagate(&wide_state));
+        std::vector<int> expected = narrow.nodes_availability.flatten<int>();
+        std::vector<int> actual = wide.nodes_availability.flatten<int>();
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            actual.begin(), actual.end(),
+            expected.begin(), expected.end()
+        );
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_domains)
+{
+    PGM_IO pgm_io;
+    std::istringstream left_image_content{R"image(
+    P2
+    6 4
+    10
+    4 5 10 3 2 9
+    0 1 7 7 8 2
+    3 3 0 9 4 4
+    10 6 5 1 0 8
+    )image"};
+    std::istringstream right_image_content{R"image(
+    P2
+    6 4
+    10
+    10 7 0 3 2 1
+    1 7 6 8 2 2
+    3 0 9 9 4 5
+    6 5 1 0 8 8
+    )image"};
+
+    left_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image left_image{*pgm_io.get_image()};
+
+    right_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image right_image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 4, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+
+    auto available_penalties = fetch_available_penalties(&lowest_penalties);
+    struct ConstraintGraph constraint_graph{
+        &disparity_graph,
+        &lowest_penalties,
+        available_penalties[available_penalties.size() / 2]
+    };
+    const struct ConstraintGraph initial{constraint_graph};
+    struct ArcConsistency state{&constraint_graph};
+
+    BOOST_REQUIRE_EQUAL(state.domain_offsets.size(), 6 * 4 + 1);
+    BOOST_CHECK_EQUAL(state.domain_offsets.front(), 0);
+    BOOST_CHECK_EQUAL(state.supports.size(), state.domain_offsets.back() * 4);
+    BOOST_CHECK_LT(state.supports.size(), 6 * 4 * 4 * 4);
+    for (ULONG pixel = 0; pixel < 6 * 4; ++pixel)
+    {
+        const ULONG size
+            = state.domain_offsets[pixel + 1] - state.domain_offsets[pixel];
+        const ULONG first = state.domain_first[pixel];
+        for (ULONG disparity = 0; disparity < 4; ++disparity)
+        {
+            if (initial.nodes_availability.test(pixel, disparity))
+            {
+                BOOST_CHECK_GE(disparity, first);
+                BOOST_CHECK_LT(disparity, first + size);
+            }
+        }
+        if (size > 0)
+        {
+            BOOST_CHECK(initial.nodes_availability.test(pixel, first));
+            BOOST_CHECK(
+                initial.nodes_availability.test(pixel, first + size - 1)
+            );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <availability.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(AvailabilityTest)
+
+using sp::graph::availability::NodesAvailability;
+
+BOOST_AUTO_TEST_CASE(check_markers)
+{
+    NodesAvailability availability{3, 70};
+
+    BOOST_CHECK_EQUAL(availability.size(), 210);
+    BOOST_CHECK(!availability.any());
+
+    availability.set(1, 0);
+    availability.set(1, 69);
+    availability.set(2, 64);
+
+    BOOST_CHECK(availability.test(1, 0));
+    BOOST_CHECK(availability.test(1, 69));
+    BOOST_CHECK(availability.test(2, 64));
+    BOOST_CHECK(!availability.test(0, 0));
+    BOOST_CHECK(!availability.test(2, 0));
+    BOOST_CHECK(!availability.any(0));
+    BOOST_CHECK(availability.any(1));
+    BOOST_CHECK_EQUAL(availability.count(), 3);
+    BOOST_CHECK_EQUAL(availability.count(1), 2);
+
+    BOOST_CHECK(availability.reset(1, 69));
+    BOOST_CHECK(!availability.reset(1, 69));
+    BOOST_CHECK(!availability.test(1, 69));
+    BOOST_CHECK(availability.test(1, 0));
+
+    availability.reset_all();
+    BOOST_CHECK(!availability.any());
+}
+
+BOOST_AUTO_TEST_CASE(check_next)
+{
+    NodesAvailability availability{3, 130};
+    availability.set(0, 3);
+    availability.set(0, 63);
+    availability.set(0, 64);
+    availability.set(0, 129);
+    availability.set(2, 0);
+
+    std::vector<unsigned long> found;
+    for (
+        unsigned long disparity = availability.next(0, 0);
+        disparity < 130;
+        disparity = availability.next(0, disparity + 1)
+    )
+    {
+        found.push_back(disparity);
+    }
+    std::vector<unsigned long> expected{3, 63, 64, 129};
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        found.begin(), found.end(),
+        expected.begin(), expected.end()
+    );
+    BOOST_CHECK_EQUAL(availability.next(0, 65), 129);
+    BOOST_CHECK_EQUAL(availability.next(0, 130), 130);
+    BOOST_CHECK_EQUAL(availability.next(1, 0), 130);
+    BOOST_CHECK_EQUAL(availability.next(2, 0), 0);
+    BOOST_CHECK_EQUAL(availability.next(2, 1), 130);
+}
+
+BOOST_AUTO_TEST_CASE(check_flatten)
+{
+    NodesAvailability availability{2, 3};
+    availability.set(0, 1);
+    availability.set(1, 2);
+
+    std::vector<int> expected{0, 1, 0, 0, 0, 1};
+    std::vector<int> flat = availability.flatten<int>();
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        flat.begin(), flat.end(),
+        expected.begin(), expected.end()
+    );
+
+    NodesAvailability copy{2, 3};
+    copy.assign(flat.begin(), flat.end());
+    BOOST_CHECK(copy.test(0, 1));
+    BOOST_CHECK(copy.test(1, 2));
+    BOOST_CHECK_EQUAL(copy.count(), 2);
+
+    NodesAvailability deep_copy{availability};
+    availability.reset(0, 1);
+    BOOST_CHECK(deep_copy.test(0, 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
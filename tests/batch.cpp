@@ -0,0 +1,227 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <batch.hpp>
+#include <image.hpp>
+#include <pgm_io.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+BOOST_AUTO_TEST_SUITE(BatchTest)
+
+using sp::batch::read_batch;
+using sp::batch::read_manifest;
+using sp::batch::run_batch;
+using sp::batch::StereoPair;
+using sp::image::Image;
+using sp::image::PGM_IO;
+using sp::types::ULONG;
+
+BOOST_AUTO_TEST_CASE(read_pairs_from_manifest)
+{
+    std::istringstream manifest{R"manifest(
+    # left right output
+    a/left.pgm a/right.pgm a/result.pgm
+
+    /data/left.pgm /data/right.pgm
+    )manifest"};
+
+    std::vector<struct StereoPair> pairs = read_manifest(manifest, "base", "out");
+    BOOST_REQUIRE_EQUAL(pairs.size(), 2);
+    BOOST_CHECK_EQUAL(pairs[0].left, "base/a/left.pgm");
+    BOOST_CHECK_EQUAL(pairs[0].right, "base/a/right.pgm");
+    BOOST_CHECK_EQUAL(pairs[0].output, "base/a/result.pgm");
+    BOOST_CHECK_EQUAL(pairs[1].left, "/data/left.pgm");
+    BOOST_CHECK_EQUAL(pairs[1].right, "/data/right.pgm");
+    BOOST_CHECK_EQUAL(pairs[1].output, "out/left.pgm");
+
+    std::istringstream without_output{"left.pgm right.pgm\n"};
+    BOOST_CHECK_THROW(
+        read_manifest(without_output, "", ""),
+        std::invalid_argument
+    );
+    std::istringstream single_path{"left.pgm\n"};
+    BOOST_CHECK_THROW(
+        read_manifest(single_path, "", "out"),
+        std::invalid_argument
+    );
+    std::istringstream same_names{
+        "a/left.pgm a/right.pgm\n"
+        "b/left.pgm b/right.pgm\n"
+    };
+    BOOST_CHECK_THROW(
+        read_manifest(same_names, "", "out"),
+        std::invalid_argument
+    );
+    std::istringstream same_outputs{
+        "a/left.pgm a/right.pgm out/a.pgm\n"
+        "b/left.pgm b/right.pgm out/./a.pgm\n"
+    };
+    BOOST_CHECK_THROW(
+        read_manifest(same_outputs, "", "out"),
+        std::invalid_argument
+    );
+    std::istringstream distinct_outputs{
+        "a/left.pgm a/right.pgm a.pgm\n"
+        "b/left.pgm b/right.pgm\n"
+    };
+    BOOST_CHECK_EQUAL(read_manifest(distinct_outputs, "", "out").size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(read_pairs_from_directory)
+{
+    namespace filesystem = std::filesystem;
+    const filesystem::path directory{"batch_test_pairs"};
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory / "left");
+    filesystem::create_directories(directory / "right");
+    for (const char* name : {"b.pgm", "a.pgm"})
+    {
+        std::ofstream{directory / "left" / name} << "P2 1 1 1 0\n";
+        std::ofstream{directory / "right" / name} << "P2 1 1 1 0\n";
+    }
+
+    std::vector<struct StereoPair> pairs
+        = read_batch(directory.string(), "out");
+    BOOST_REQUIRE_EQUAL(pairs.size(), 2);
+    BOOST_CHECK_EQUAL(pairs[0].left, (directory / "left" / "a.pgm").string());
+    BOOST_CHECK_EQUAL(pairs[0].right, (directory / "right" / "a.pgm").string());
+    BOOST_CHECK_EQUAL(pairs[0].output, "out/a.pgm");
+    BOOST_CHECK_EQUAL(pairs[1].left, (directory / "left" / "b.pgm").string());
+
+    std::ofstream{directory / "left" / "c.pgm"} << "P2 1 1 1 0\n";
+    BOOST_CHECK_THROW(
+        read_batch(directory.string(), "out"),
+        std::invalid_argument
+    );
+
+    filesystem::remove_all(directory);
+    BOOST_CHECK_THROW(
+        read_batch(directory.string(), "out"),
+        std::invalid_argument
+    );
+}
+
+BOOST_AUTO_TEST_CASE(solve_each_pair_once)
+{
+    const std::string large_image{"batch_test_large.pgm"};
+    {
+        std::ofstream image_file(large_image, std::ios::out | std::ios::binary);
+        image_file << PGM_IO{
+            std::make_shared<struct Image>(
+                Image{4, 4, 1, sp::image::Pixels(16, 1)}
+            ),
+            true
+        };
+    }
+
+    std::vector<struct StereoPair> pairs{
+        {"missing_0.pgm", "missing_0.pgm", "out_0.pgm"},
+        {large_image, large_image, "out_1.pgm"},
+        {"missing_2.pgm", "missing_2.pgm", "out_2.pgm"},
+        {"missing_3.pgm", "missing_3.pgm", "out_3.pgm"}
+    };
+    std::unique_ptr<std::atomic<ULONG>[]> calls{new std::atomic<ULONG>[4]};
+    for (ULONG index = 0; index < 4; ++index)
+    {
+        calls[index] = 0;
+    }
+    std::atomic<ULONG> solved_first{4};
+
+    ULONG failed = run_batch(
+        pairs,
+        16,
+        [&calls, &solved_first](ULONG index)
+        {
+            ULONG expected = 4;
+            solved_first.compare_exchange_strong(expected, index);
+            ++calls[index];
+            return index != 2;
+        }
+    );
+    std::remove(large_image.c_str());
+
+    BOOST_CHECK_EQUAL(failed, 1);
+    BOOST_CHECK_EQUAL(solved_first.load(), 1);
+    for (ULONG index = 0; index < 4; ++index)
+    {
+        BOOST_CHECK_EQUAL(calls[index], 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(solve_small_pairs_by_one_thread)
+{
+    std::vector<struct StereoPair> pairs{
+        {"missing_0.pgm", "missing_0.pgm", "out_0.pgm"},
+        {"missing_1.pgm", "missing_1.pgm", "out_1.pgm"},
+        {"missing_2.pgm", "missing_2.pgm", "out_2.pgm"}
+    };
+    #ifdef _OPENMP
+    const int max_active_levels = omp_get_max_active_levels();
+    #endif
+    std::atomic<ULONG> max_threads{0};
+
+    ULONG failed = run_batch(
+        pairs,
+        16,
+        [&max_threads](ULONG)
+        {
+            ULONG threads = 1;
+            #ifdef _OPENMP
+            #pragma omp parallel
+            {
+                #pragma omp single
+                threads = static_cast<ULONG>(omp_get_num_threads());
+            }
+            #endif
+            ULONG current = max_threads.load();
+            while (
+                current < threads
+                && !max_threads.compare_exchange_weak(current, threads)
+            )
+            {
+            }
+            return true;
+        }
+    );
+
+    BOOST_CHECK_EQUAL(failed, 0);
+    BOOST_CHECK_EQUAL(max_threads.load(), 1);
+    #ifdef _OPENMP
+    BOOST_CHECK_EQUAL(omp_get_max_active_levels(), max_active_levels);
+    #endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -30,14 +30,19 @@
 #include <lowest_penalties.hpp>
 #include <pgm_io.hpp>
 
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(ConstraintGraphTest)
 
 using sp::graph::constraint::ConstraintGraph;
+using sp::graph::constraint::CspSchedule;
 using sp::graph::disparity::DisparityGraph;
 using sp::graph::lowest_penalties::LowestPenalties;
 using sp::image::Image;
 using sp::image::PGM_IO;
 using sp::indexing::node_index;
+using sp::types::BOOL;
+using sp::types::FLOAT;
 using sp::types::Node;
 
 BOOST_AUTO_TEST_CASE(check_nodes_indexing)
@@ -61,9 +66,9 @@ BOOST_AUTO_TEST_CASE(check_nodes_indexing)
 
     BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{0, 0}, 0}), 0);
     BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{0, 0}, 2}), 2);
-    BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{0, 1}, 0}), 3);
-    BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{0, 1}, 2}), 5);
-    BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{1, 0}, 0}), 6);
+    BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{0, 1}, 0}), 9);
+    BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{0, 1}, 2}), 11);
+    BOOST_CHECK_EQUAL(node_index(constraint_graph.disparity_graph, {{1, 0}, 0}), 3);
 }
 
 BOOST_AUTO_TEST_CASE(check_black_images)
@@ -337,4 +342,76 @@ BOOST_AUTO_TEST_CASE(check_unconstrained_disparities)
     BOOST_CHECK(is_node_available(&constraint_graph, {{1, 1}, 0}));
 }
 
+BOOST_AUTO_TEST_CASE(check_schedules)
+{
+    PGM_IO pgm_io;
+    std::istringstream left_image_content{R"image(
+    P2
+    6 4
+    10
+    4 5 10 3 2 9
+    0 1 7 7 8 2
+    3 3 0 9 4 4
+    10 6 5 1 0 8
+    )image"};
+    std::istringstream right_image_content{R"image(
+    P2
+    6 4
+    10
+    10 7 0 3 2 1
+    1 7 6 8 2 2
+    3 0 9 9 4 5
+    6 5 1 0 8 8
+    )image"};
+
+    left_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image left_image{*pgm_io.get_image()};
+
+    right_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image right_image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 4, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+
+    for (FLOAT threshold : {0.0f, 1.0f, 5.0f, 20.0f, 50.0f, 100.0f})
+    {
+        struct ConstraintGraph expected_graph{
+            &disparity_graph,
+            &lowest_penalties,
+            threshold
+        };
+        const BOOL expected_result = solve_csp(&expected_graph);
+        const std::vector<int> expected
+            = expected_graph.nodes_availability.flatten<int>();
+
+        for (
+            const struct CspSchedule& schedule : {
+                CspSchedule{1, 1, 1},
+                CspSchedule{3, 2, 3},
+                CspSchedule{4, 1, 4},
+                CspSchedule{2, 100, 100}
+            }
+        )
+        {
+            struct ConstraintGraph constraint_graph{
+                &disparity_graph,
+                &lowest_penalties,
+                threshold
+            };
+            BOOST_CHECK_EQUAL(
+                solve_csp(&constraint_graph, &schedule),
+                expected_result
+            );
+            const std::vector<int> actual
+                = constraint_graph.nodes_availability.flatten<int>();
+            BOOST_CHECK_EQUAL_COLLECTIONS(
+                actual.begin(), actual.end(),
+                expected.begin(), expected.end()
+            );
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,124 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <constraint_graph.hpp>
+#include <counters.hpp>
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <lowest_penalties.hpp>
+#include <pgm_io.hpp>
+
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(CountersTest)
+
+using sp::counters::collect_counters;
+using sp::counters::counters_enabled;
+using sp::counters::COUNTERS_COUNT;
+using sp::counters::CSP_SWEEPS;
+using sp::counters::EDGE_CHECKS;
+using sp::counters::increment;
+using sp::counters::NODES_EXAMINED;
+using sp::counters::NODES_REMOVED;
+using sp::counters::reset_counters;
+using sp::graph::constraint::ConstraintGraph;
+using sp::graph::constraint::solve_csp;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::lowest_penalties::LowestPenalties;
+using sp::image::Image;
+using sp::image::PGM_IO;
+using sp::types::ULONG;
+
+BOOST_AUTO_TEST_CASE(check_aggregation)
+{
+    reset_counters();
+    std::vector<std::thread> threads;
+    for (ULONG thread = 0; thread < 4; ++thread)
+    {
+        threads.emplace_back([]()
+        {
+            for (ULONG step = 0; step < 1000; ++step)
+            {
+                increment(NODES_REMOVED, 1);
+            }
+            increment(EDGE_CHECKS, 5);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto counters = collect_counters();
+    BOOST_REQUIRE_EQUAL(counters.size(), COUNTERS_COUNT);
+    BOOST_CHECK_EQUAL(counters[NODES_REMOVED], 4000);
+    BOOST_CHECK_EQUAL(counters[EDGE_CHECKS], 20);
+    BOOST_CHECK_EQUAL(counters[CSP_SWEEPS], 0);
+
+    reset_counters();
+    counters = collect_counters();
+    BOOST_CHECK_EQUAL(counters[NODES_REMOVED], 0);
+    BOOST_CHECK_EQUAL(counters[EDGE_CHECKS], 0);
+}
+
+BOOST_AUTO_TEST_CASE(check_csp)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{R"image(
+    P2
+    3 2
+    10
+    4 5 10
+    0 0 0
+    )image"};
+    image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{image, image, 3, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    struct ConstraintGraph constraint_graph{
+        &disparity_graph,
+        &lowest_penalties,
+        0
+    };
+
+    reset_counters();
+    BOOST_REQUIRE(solve_csp(&constraint_graph));
+    auto counters = collect_counters();
+    if (counters_enabled())
+    {
+        BOOST_CHECK_GE(counters[CSP_SWEEPS], 1);
+        BOOST_CHECK_GE(counters[NODES_EXAMINED], 6);
+        BOOST_CHECK_GE(counters[EDGE_CHECKS], counters[NODES_EXAMINED]);
+    }
+    else
+    {
+        BOOST_CHECK_EQUAL(counters[CSP_SWEEPS], 0);
+        BOOST_CHECK_EQUAL(counters[NODES_EXAMINED], 0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
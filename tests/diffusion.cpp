@@ -0,0 +1,190 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <diffusion.hpp>
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include "random_images.hpp"
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(DiffusionTest)
+
+using random_images::make_shifted_images;
+using sp::graph::diffusion::calculate_lower_bound;
+using sp::graph::diffusion::calculate_lowest_edge_penalty;
+using sp::graph::diffusion::diffusion;
+using sp::graph::diffusion::diffusion_iteration;
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::calculate_node_penalty;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::disparity::edge_penalty;
+using sp::graph::disparity::node_penalty;
+using sp::image::Image;
+using sp::types::Edge;
+using sp::types::FLOAT;
+using sp::types::Node;
+using sp::types::Pixel;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+struct DisparityGraph build_graph()
+{
+    struct Image left_image;
+    struct Image right_image;
+    make_shifted_images(1, 1, &left_image, &right_image);
+    return DisparityGraph{left_image, right_image, 6, 1, 1};
+}
+
+FLOAT labeling_energy(
+    const struct DisparityGraph* graph,
+    const ULONG_ARRAY& labeling
+)
+{
+    FLOAT energy = 0;
+    struct Pixel pixel{0, 0};
+    for (pixel.y = 0; pixel.y < graph->right.height; ++pixel.y)
+    {
+        for (pixel.x = 0; pixel.x < graph->right.width; ++pixel.x)
+        {
+            ULONG index = pixel.x + graph->right.width * pixel.y;
+            struct Edge edge{{pixel, labeling[index]}, {pixel, 0}};
+            energy += node_penalty(graph, edge.node);
+            if (pixel.x + 1 < graph->right.width)
+            {
+                edge.neighbor.pixel = {pixel.x + 1, pixel.y};
+                edge.neighbor.disparity = labeling[index + 1];
+                energy += edge_penalty(graph, edge);
+            }
+            if (pixel.y + 1 < graph->right.height)
+            {
+                edge.neighbor.pixel = {pixel.x, pixel.y + 1};
+                edge.neighbor.disparity = labeling[index + graph->right.width];
+                energy += edge_penalty(graph, edge);
+            }
+        }
+    }
+    return energy;
+}
+
+BOOST_AUTO_TEST_CASE(check_lowest_edge_penalty)
+{
+    struct DisparityGraph graph{build_graph()};
+    BOOST_CHECK_EQUAL(
+        calculate_lowest_edge_penalty(&graph, {{10, 2}, 5}, 0),
+        graph.smoothness
+    );
+    BOOST_CHECK_EQUAL(
+        calculate_lowest_edge_penalty(&graph, {{10, 2}, 5}, 2),
+        0
+    );
+    BOOST_CHECK_EQUAL(
+        calculate_lowest_edge_penalty(&graph, {{10, 2}, 5}, 1),
+        0
+    );
+}
+
+BOOST_AUTO_TEST_CASE(check_equivalence)
+{
+    struct DisparityGraph graph{build_graph()};
+    ULONG_ARRAY zero_labeling(graph.right.width * graph.right.height, 0);
+    ULONG_ARRAY shifted_labeling(graph.right.width * graph.right.height, 1);
+    for (ULONG y = 0; y < graph.right.height; ++y)
+    {
+        shifted_labeling[graph.right.width - 1 + graph.right.width * y] = 0;
+    }
+
+    FLOAT zero_energy = labeling_energy(&graph, zero_labeling);
+    FLOAT shifted_energy = labeling_energy(&graph, shifted_labeling);
+    FLOAT lower_bound = calculate_lower_bound(&graph);
+    BOOST_REQUIRE_LE(lower_bound, shifted_energy);
+
+    diffusion_iteration(&graph);
+    BOOST_CHECK_CLOSE(labeling_energy(&graph, zero_labeling), zero_energy, 1e-3);
+    BOOST_CHECK_CLOSE(
+        labeling_energy(&graph, shifted_labeling),
+        shifted_energy,
+        1e-3
+    );
+
+    diffusion(&graph, 20, 0);
+    BOOST_CHECK_CLOSE(labeling_energy(&graph, zero_labeling), zero_energy, 1e-3);
+    BOOST_CHECK_CLOSE(
+        labeling_energy(&graph, shifted_labeling),
+        shifted_energy,
+        1e-3
+    );
+    BOOST_CHECK_GT(calculate_lower_bound(&graph), lower_bound);
+    BOOST_CHECK_LE(calculate_lower_bound(&graph), shifted_energy * (1 + 1e-5));
+}
+
+BOOST_AUTO_TEST_CASE(check_monotonicity)
+{
+    struct DisparityGraph graph{build_graph()};
+    FLOAT lower_bound = calculate_lower_bound(&graph);
+    for (ULONG iteration = 0; iteration < 10; ++iteration)
+    {
+        diffusion_iteration(&graph);
+        FLOAT next_lower_bound = calculate_lower_bound(&graph);
+        BOOST_CHECK_GE(next_lower_bound, lower_bound - 1e-3);
+        lower_bound = next_lower_bound;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_convergence)
+{
+    struct DisparityGraph graph{build_graph()};
+    BOOST_CHECK_EQUAL(diffusion(&graph, 0, 0), 0);
+    BOOST_CHECK_EQUAL(diffusion(&graph, 3, 0), 3);
+    BOOST_CHECK_EQUAL(diffusion(&graph, 100, 1e9), 1);
+}
+
+BOOST_AUTO_TEST_CASE(check_cached_penalties)
+{
+    struct DisparityGraph graph{build_graph()};
+    cache_node_penalties(&graph);
+    diffusion(&graph, 5, 0);
+    struct Node node{{0, 0}, 0};
+    for (node.pixel.y = 0; node.pixel.y < graph.right.height; ++node.pixel.y)
+    {
+        for (node.pixel.x = 0; node.pixel.x < graph.right.width; ++node.pixel.x)
+        {
+            for (
+                node.disparity = 0;
+                node.pixel.x + node.disparity < graph.left.width
+                    && node.disparity < graph.disparity_levels;
+                ++node.disparity
+            )
+            {
+                BOOST_CHECK_EQUAL(
+                    node_penalty(&graph, node),
+                    calculate_node_penalty(&graph, node)
+                );
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -29,17 +29,24 @@
 #include <indexing_checks.hpp>
 #include <pgm_io.hpp>
 
+#include <algorithm>
+
 BOOST_AUTO_TEST_SUITE(DisparityGraphTest)
 
 using sp::graph::disparity::DisparityGraph;
 using sp::image::Image;
+using sp::image::Pixels;
 using sp::image::PGM_IO;
 using sp::indexing::checks::edge_exists;
 using sp::indexing::checks::neighborhood_exists;
 using sp::indexing::checks::node_exists;
 using sp::indexing::reparametrization_index;
 using sp::indexing::reparametrization_index_fast;
+using sp::types::BOOL;
+using sp::types::FLOAT;
+using sp::types::FLOAT_ARRAY;
 using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
 
 BOOST_AUTO_TEST_CASE(check_nodes_existence)
 {
@@ -94,21 +101,21 @@ BOOST_AUTO_TEST_CASE(check_reparametrization_indexing)
     struct DisparityGraph disparity_graph{image, image, 3, 1, 1};
 
     BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 0}, 0), 0);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 0}, 0), 1);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 1}, 0), 2);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 2}, 0), 4);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 2}, 0), 5);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 0}, 1), 6);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 0}, 1), 7);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 1}, 1), 8);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 1}, 1), 9);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 2}, 1), 10);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 2}, 1), 11);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 0}, 2), 12);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 0}, 3), 18);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 2}, 3), 23);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{1, 0}, 0}, 0), 24);
-    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{1, 1}, 2}, 3), 47);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 0}, 0), 36);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 1}, 0), 1);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 2}, 0), 2);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 2}, 0), 38);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 0}, 1), 3);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 0}, 1), 39);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 1}, 1), 4);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 1}, 1), 40);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 2}, 1), 5);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 2}, 1), 41);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 0}, 2), 6);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 0}, 0}, 3), 9);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{0, 1}, 2}, 3), 47);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{1, 0}, 0}, 0), 12);
+    BOOST_CHECK_EQUAL(reparametrization_index_fast(&disparity_graph, {{1, 1}, 2}, 3), 59);
 }
 
 BOOST_AUTO_TEST_CASE(check_neighborhood)
@@ -435,4 +442,204 @@ BOOST_AUTO_TEST_CASE(check_nodes_penalties)
     BOOST_CHECK_CLOSE(node_penalty(&disparity_graph, {{1, 0}, 0}), 10, 1);
 }
 
+BOOST_AUTO_TEST_CASE(check_cached_nodes_penalties)
+{
+    PGM_IO pgm_io;
+    std::istringstream left_image_content{R"left_image(
+    P2
+    3 2
+    2
+    0 1 2
+    2 0 1
+    )left_image"};
+    std::istringstream right_image_content{R"right_image(
+    P2
+    3 2
+    2
+    1 0 2
+    2 0 1
+    )right_image"};
+
+    left_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image left_image{*pgm_io.get_image()};
+
+    right_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image right_image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 3, 10, 1};
+    cache_node_penalties(&disparity_graph);
+    BOOST_CHECK_EQUAL(disparity_graph.node_penalties.size(), 3 * 2 * 3);
+
+    for (ULONG x = 0; x < 3; ++x)
+    {
+        for (ULONG y = 0; y < 2; ++y)
+        {
+            for (ULONG d = 0; x + d < 3; ++d)
+            {
+                BOOST_CHECK_EQUAL(
+                    node_penalty(&disparity_graph, {{x, y}, d}),
+                    calculate_node_penalty(&disparity_graph, {{x, y}, d})
+                );
+            }
+        }
+    }
+
+    disparity_graph.reparametrization[
+        reparametrization_index(&disparity_graph, {{0, 0}, 0}, {1, 0})
+    ] = -2;
+    BOOST_CHECK_CLOSE(node_penalty(&disparity_graph, {{0, 0}, 0}), 10, 1);
+
+    update_cached_node_penalties(&disparity_graph, {0, 0});
+    BOOST_CHECK_CLOSE(node_penalty(&disparity_graph, {{0, 0}, 0}), 8, 1);
+    BOOST_CHECK_CLOSE(node_penalty(&disparity_graph, {{0, 0}, 1}), 0, 1);
+
+    drop_cached_node_penalties(&disparity_graph);
+    BOOST_CHECK(disparity_graph.node_penalties.empty());
+    BOOST_CHECK_CLOSE(node_penalty(&disparity_graph, {{0, 0}, 0}), 8, 1);
+}
+
+BOOST_AUTO_TEST_CASE(calculate_pixel_node_penalties)
+{
+    struct Image left_image{40, 3, 300, Pixels(40 * 3, 300)};
+    struct Image right_image{40, 3, 300, Pixels(40 * 3, 300)};
+    for (ULONG index = 0; index < 40 * 3; ++index)
+    {
+        left_image.data[index] = index * 37 % 301;
+        right_image.data[index] = index * 53 % 301;
+    }
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 33, 3, 1};
+    for (ULONG index = 0; index < disparity_graph.reparametrization.size(); ++index)
+    {
+        disparity_graph.reparametrization[index]
+            = static_cast<FLOAT>(index % 17) / 7 - 1;
+    }
+
+    FLOAT_ARRAY buffer;
+    for (BOOL cached : {false, true})
+    {
+        if (cached)
+        {
+            cache_node_penalties(&disparity_graph);
+        }
+        for (ULONG y = 0; y < 3; ++y)
+        {
+            for (ULONG x = 0; x < 40; ++x)
+            {
+                const FLOAT* penalties
+                    = pixel_node_penalties(&disparity_graph, {x, y}, &buffer);
+                ULONG disparities = pixel_disparities(&disparity_graph, {x, y});
+                BOOST_CHECK_EQUAL(disparities, std::min<ULONG>(33, 40 - x));
+                for (ULONG d = 0; d < disparities; ++d)
+                {
+                    BOOST_CHECK_EQUAL(
+                        penalties[d],
+                        calculate_node_penalty(&disparity_graph, {{x, y}, d})
+                    );
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_minimal_disparities)
+{
+    struct Image left_image{12, 2, 300, Pixels(12 * 2, 300)};
+    struct Image right_image{12, 2, 300, Pixels(12 * 2, 300)};
+    for (ULONG index = 0; index < left_image.data.size(); ++index)
+    {
+        left_image.data[index] = index * 37 % 301;
+        right_image.data[index] = index * 53 % 301;
+    }
+
+    ULONG_ARRAY minimal_disparities(12 * 2);
+    for (ULONG index = 0; index < minimal_disparities.size(); ++index)
+    {
+        minimal_disparities[index]
+            = std::min<ULONG>(index % 5, 11 - index % 12);
+    }
+    struct DisparityGraph full_graph{left_image, right_image, 12, 3, 1};
+    struct DisparityGraph window_graph{left_image, right_image, 3, 3, 1};
+    cache_node_penalties(&window_graph);
+    set_minimal_disparities(&window_graph, minimal_disparities);
+    BOOST_CHECK(window_graph.minimal_disparities == minimal_disparities);
+
+    FLOAT_ARRAY buffer;
+    for (ULONG y = 0; y < 2; ++y)
+    {
+        for (ULONG x = 0; x < 12; ++x)
+        {
+            const ULONG minimum = minimal_disparities[x + 12 * y];
+            const ULONG disparities
+                = pixel_disparities(&window_graph, {x, y});
+            BOOST_CHECK_EQUAL(
+                disparities,
+                std::min<ULONG>(3, 12 - x - minimum)
+            );
+            const FLOAT* penalties
+                = pixel_node_penalties(&window_graph, {x, y}, &buffer);
+            for (ULONG d = 0; d < 4; ++d)
+            {
+                BOOST_CHECK_EQUAL(
+                    node_exists(&window_graph, {{x, y}, d}),
+                    d < disparities
+                );
+                if (d >= disparities)
+                {
+                    continue;
+                }
+                BOOST_CHECK_EQUAL(
+                    penalties[d],
+                    calculate_node_penalty(&full_graph, {{x, y}, minimum + d})
+                );
+                if (x + 1 == 12)
+                {
+                    continue;
+                }
+                const ULONG neighbor_minimum
+                    = minimal_disparities[x + 1 + 12 * y];
+                for (ULONG neighbor_d = 0; neighbor_d < 3; ++neighbor_d)
+                {
+                    BOOST_CHECK_EQUAL(
+                        edge_exists(
+                            &window_graph,
+                            {{{x, y}, d}, {{x + 1, y}, neighbor_d}}
+                        ),
+                        edge_exists(
+                            &full_graph,
+                            {
+                                {{x, y}, minimum + d},
+                                {{x + 1, y}, neighbor_minimum + neighbor_d}
+                            }
+                        )
+                        && node_exists(
+                            &window_graph,
+                            {{x + 1, y}, neighbor_d}
+                        )
+                    );
+                }
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(
+        edge_penalty(&window_graph, {{{3, 0}, 1}, {{3, 1}, 2}}),
+        edge_penalty(&full_graph, {{{3, 0}, 4}, {{3, 1}, 2}})
+    );
+
+    set_minimal_disparities(&window_graph, {});
+    BOOST_CHECK_EQUAL(pixel_disparities(&window_graph, {5, 0}), 3);
+
+    BOOST_CHECK_THROW(
+        set_minimal_disparities(&window_graph, ULONG_ARRAY(5)),
+        std::invalid_argument
+    );
+    minimal_disparities[11] = 1;
+    BOOST_CHECK_THROW(
+        set_minimal_disparities(&window_graph, minimal_disparities),
+        std::invalid_argument
+    );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
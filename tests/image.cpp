@@ -29,6 +29,7 @@
 BOOST_AUTO_TEST_SUITE(ImageTest)
 
 using sp::image::Image;
+using sp::image::Pixels;
 using sp::indexing::pixel_index;
 using sp::indexing::pixel_value;
 using sp::types::ULONG;
@@ -94,4 +95,45 @@ BOOST_AUTO_TEST_CASE(check_pixel_value)
     BOOST_CHECK_EQUAL(pixel_value(&image, {2, 1}), 0);
 }
 
+BOOST_AUTO_TEST_CASE(compact_pixels)
+{
+    BOOST_CHECK_EQUAL(Pixels({0, 255}).bytes_per_pixel(), 1);
+    BOOST_CHECK_EQUAL(Pixels({0, 256}).bytes_per_pixel(), 2);
+    BOOST_CHECK_EQUAL(Pixels({0, 65536}).bytes_per_pixel(), sizeof(ULONG));
+    BOOST_CHECK_EQUAL(Pixels(4, 255).bytes_per_pixel(), 1);
+    BOOST_CHECK_EQUAL(Pixels(4, 65535).bytes_per_pixel(), 2);
+    BOOST_CHECK_EQUAL(Pixels(4, 65535).size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(widen_pixels)
+{
+    Pixels pixels(3, 1);
+    pixels[0] = 7;
+    pixels[1] = pixels[0];
+    BOOST_CHECK_EQUAL(pixels.bytes_per_pixel(), 1);
+    pixels[2] = 1000;
+    BOOST_CHECK_EQUAL(pixels.bytes_per_pixel(), 2);
+    BOOST_CHECK(pixels == Pixels({7, 7, 1000}));
+    pixels.set(0, 100000);
+    BOOST_CHECK_EQUAL(pixels.bytes_per_pixel(), sizeof(ULONG));
+    BOOST_CHECK(pixels.to_vector() == std::vector<ULONG>({100000, 7, 1000}));
+}
+
+BOOST_AUTO_TEST_CASE(visit_pixels)
+{
+    const Pixels pixels{3, 1, 2};
+    ULONG sum = pixels.visit(
+        [&pixels](const auto* data)
+        {
+            ULONG result = 0;
+            for (ULONG index = 0; index < pixels.size(); ++index)
+            {
+                result += data[index];
+            }
+            return result;
+        }
+    );
+    BOOST_CHECK_EQUAL(sum, 6);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -26,23 +26,35 @@
 #include <constraint_graph.hpp>
 #include <disparity_graph.hpp>
 #include <image.hpp>
+#include <indexing.hpp>
 #include <labeling_finder.hpp>
 #include <lowest_penalties.hpp>
 #include <pgm_io.hpp>
+#include "random_images.hpp"
+
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(LabelingFinder)
 
+using random_images::make_shifted_images;
 using sp::graph::constraint::ConstraintGraph;
 using sp::graph::disparity::DisparityGraph;
 using sp::graph::lowest_penalties::LowestPenalties;
 using sp::image::Image;
 using sp::image::PGM_IO;
+using sp::indexing::node_index;
+using sp::labeling::finder::APPROXIMATE_THRESHOLD_BINS;
+using sp::labeling::finder::calculate_approximate_consistent_threshold;
 using sp::labeling::finder::calculate_minimal_consistent_threshold;
 using sp::labeling::finder::fetch_available_penalties;
 using sp::labeling::finder::fetch_edge_available_penalties;
 using sp::labeling::finder::fetch_pixel_available_penalties;
 using sp::labeling::finder::find_labeling;
+using sp::labeling::finder::probe_threshold;
+using sp::labeling::finder::ThresholdSearch;
+using sp::labeling::finder::quantize_available_penalties;
 using sp::types::FLOAT;
+using sp::types::ULONG;
 
 BOOST_AUTO_TEST_CASE(check_black_images)
 {
@@ -219,6 +231,23 @@ BOOST_AUTO_TEST_CASE(basic_check)
     BOOST_CHECK_CLOSE(available_penalties[4], 25, 1);
     BOOST_CHECK_CLOSE(available_penalties[5], 36, 1);
 
+    auto quantized_penalties = quantize_available_penalties(
+        available_penalties,
+        3
+    );
+    BOOST_CHECK_EQUAL(quantized_penalties.size(), 2);
+    BOOST_CHECK_CLOSE(quantized_penalties[0], 5, 1);
+    BOOST_CHECK_CLOSE(quantized_penalties[1], 36, 1);
+
+    BOOST_CHECK_EQUAL(
+        quantize_available_penalties(available_penalties, 0).size(),
+        6
+    );
+    BOOST_CHECK_EQUAL(
+        quantize_available_penalties(available_penalties, 6).size(),
+        6
+    );
+
     FLOAT threshold = calculate_minimal_consistent_threshold(
         &lowest_penalties,
         &disparity_graph,
@@ -235,4 +264,101 @@ BOOST_AUTO_TEST_CASE(basic_check)
     BOOST_CHECK_EQUAL(find_labeling(&constraint_graph), &constraint_graph);
 }
 
+BOOST_AUTO_TEST_CASE(check_threshold_probes)
+{
+    PGM_IO pgm_io;
+    std::istringstream left_image_content{R"image(
+    P2
+    3 2
+    10
+    4 5 10
+    0 0 0
+    )image"};
+    std::istringstream right_image_content{R"image(
+    P2
+    3 2
+    10
+    10 7 0
+    0 0 0
+    )image"};
+
+    left_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image left_image{*pgm_io.get_image()};
+
+    right_image_content >> pgm_io;
+    BOOST_REQUIRE(pgm_io.get_image());
+    struct Image right_image{*pgm_io.get_image()};
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 3, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    struct ThresholdSearch search{&disparity_graph, &lowest_penalties};
+
+    BOOST_CHECK_CLOSE(search.nodes_slacks[node_index(&disparity_graph, {{0, 0}, 0})], 36, 1);
+    BOOST_CHECK_CLOSE(search.nodes_slacks[node_index(&disparity_graph, {{0, 0}, 2})], 0, 1);
+    BOOST_CHECK_GT(search.nodes_slacks[node_index(&disparity_graph, {{2, 0}, 1})], 1e30);
+
+    BOOST_CHECK_EQUAL(search.consistent_nodes.count(), 0);
+    BOOST_CHECK(probe_threshold(&search, 36));
+    ULONG nodes_count = search.consistent_nodes.count();
+    BOOST_CHECK_GT(nodes_count, 0);
+
+    BOOST_CHECK(!probe_threshold(&search, 4));
+    BOOST_CHECK_EQUAL(search.consistent_nodes.count(), nodes_count);
+
+    BOOST_CHECK(probe_threshold(&search, 5));
+    struct ConstraintGraph constraint_graph{&disparity_graph, &lowest_penalties, 5};
+    BOOST_CHECK(solve_csp(&constraint_graph));
+    std::vector<int> expected = constraint_graph.nodes_availability.flatten<int>();
+    std::vector<int> actual = search.consistent_nodes.flatten<int>();
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        actual.begin(), actual.end(),
+        expected.begin(), expected.end()
+    );
+}
+
+BOOST_AUTO_TEST_CASE(check_approximate_threshold)
+{
+    struct Image left_image;
+    struct Image right_image;
+    make_shifted_images(1, 1, &left_image, &right_image);
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 6, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    auto available_penalties = fetch_available_penalties(&lowest_penalties);
+    BOOST_REQUIRE_GT(available_penalties.size(), APPROXIMATE_THRESHOLD_BINS);
+
+    FLOAT threshold = calculate_minimal_consistent_threshold(
+        &lowest_penalties,
+        &disparity_graph,
+        available_penalties
+    );
+    BOOST_CHECK_EQUAL(
+        calculate_approximate_consistent_threshold(
+            &lowest_penalties,
+            &disparity_graph,
+            available_penalties,
+            0
+        ),
+        threshold
+    );
+
+    FLOAT approximate_threshold = calculate_approximate_consistent_threshold(
+        &lowest_penalties,
+        &disparity_graph,
+        available_penalties,
+        1000
+    );
+    BOOST_CHECK_GE(approximate_threshold, threshold);
+    BOOST_CHECK_LE(approximate_threshold, threshold + 1000);
+
+    struct ThresholdSearch search{&disparity_graph, &lowest_penalties};
+    BOOST_CHECK_EQUAL(
+        calculate_minimal_consistent_threshold(&search, available_penalties),
+        threshold
+    );
+    BOOST_CHECK_GT(search.probes, 0);
+    BOOST_CHECK_LE(search.probes, available_penalties.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
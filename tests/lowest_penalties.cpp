@@ -33,13 +33,21 @@
 BOOST_AUTO_TEST_SUITE(LowestPenaltiesTest)
 
 using sp::graph::disparity::DisparityGraph;
+using sp::graph::disparity::edge_penalty;
+using sp::graph::disparity::NEIGHBORS_COUNT;
+using sp::graph::lowest_penalties::calculate_lowest_neighborhood_penalty_slow;
 using sp::graph::lowest_penalties::LowestPenalties;
 using sp::image::Image;
 using sp::image::PGM_IO;
+using sp::image::Pixels;
 using sp::indexing::checks::neighborhood_exists_fast;
+using sp::indexing::neighbor_by_index;
 using sp::indexing::neighborhood_index;
 using sp::indexing::neighborhood_index_fast;
 using sp::indexing::reparametrization_index;
+using sp::types::Edge;
+using sp::types::FLOAT;
+using sp::types::ULONG;
 
 BOOST_AUTO_TEST_CASE(check_neighborhoods_indexing)
 {
@@ -97,36 +105,36 @@ BOOST_AUTO_TEST_CASE(check_neighborhoods_indexing)
 
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {0, 1}, 0),
-        4
+        12
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {0, 1}, {1, 1}),
-        4
+        12
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {0, 1}, 0)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {0, 1}, 1),
-        5
+        13
     );
     BOOST_CHECK(
         !neighborhood_exists_fast(lowest_penalties.graph, {0, 1}, 1)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {0, 1}, 2),
-        6
+        14
     );
     BOOST_CHECK(
         !neighborhood_exists_fast(lowest_penalties.graph, {0, 1}, 2)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {0, 1}, 3),
-        7
+        15
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {0, 1}, {0, 0}),
-        7
+        15
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {0, 1}, 3)
@@ -134,40 +142,40 @@ BOOST_AUTO_TEST_CASE(check_neighborhoods_indexing)
 
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 0}, 0),
-        8
+        4
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {1, 0}, {2, 0}),
-        8
+        4
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {1, 0}, 0)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 0}, 1),
-        9
+        5
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {1, 0}, {0, 0}),
-        9
+        5
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {1, 0}, 1)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 0}, 2),
-        10
+        6
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {1, 0}, {1, 1}),
-        10
+        6
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {1, 0}, 2)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 0}, 3),
-        11
+        7
     );
     BOOST_CHECK(
         !neighborhood_exists_fast(lowest_penalties.graph, {1, 0}, 3)
@@ -175,40 +183,40 @@ BOOST_AUTO_TEST_CASE(check_neighborhoods_indexing)
 
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 1}, 0),
-        12
+        16
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {1, 1}, {2, 1}),
-        12
+        16
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {1, 1}, 0)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 1}, 1),
-        13
+        17
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {1, 1}, {0, 1}),
-        13
+        17
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {1, 1}, 1)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 1}, 2),
-        14
+        18
     );
     BOOST_CHECK(
         !neighborhood_exists_fast(lowest_penalties.graph, {1, 1}, 2)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {1, 1}, 3),
-        15
+        19
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {1, 1}, {1, 0}),
-        15
+        19
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {1, 1}, 3)
@@ -216,36 +224,36 @@ BOOST_AUTO_TEST_CASE(check_neighborhoods_indexing)
 
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {2, 0}, 0),
-        16
+        8
     );
     BOOST_CHECK(
         !neighborhood_exists_fast(lowest_penalties.graph, {2, 0}, 0)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {2, 0}, 1),
-        17
+        9
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {2, 0}, {1, 0}),
-        17
+        9
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {2, 0}, 1)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {2, 0}, 2),
-        18
+        10
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index(lowest_penalties.graph, {2, 0}, {2, 1}),
-        18
+        10
     );
     BOOST_CHECK(
         neighborhood_exists_fast(lowest_penalties.graph, {2, 0}, 2)
     );
     BOOST_CHECK_EQUAL(
         neighborhood_index_fast(lowest_penalties.graph, {2, 0}, 3),
-        19
+        11
     );
     BOOST_CHECK(
         !neighborhood_exists_fast(lowest_penalties.graph, {2, 0}, 3)
@@ -470,4 +478,96 @@ BOOST_AUTO_TEST_CASE(check_lowest_neighborhood_penalty)
     );
 }
 
+BOOST_AUTO_TEST_CASE(lowest_neighborhood_penalty_matches_exhaustive_search)
+{
+    struct Image left_image{40, 3, 300, Pixels(40 * 3, 300)};
+    struct Image right_image{40, 3, 300, Pixels(40 * 3, 300)};
+    for (ULONG index = 0; index < 40 * 3; ++index)
+    {
+        left_image.data[index] = index * 37 % 301;
+        right_image.data[index] = index * 53 % 301;
+    }
+
+    for (FLOAT smoothness : {0.0f, 0.03f, 1.0f, 25.0f})
+    {
+        struct DisparityGraph disparity_graph{
+            left_image,
+            right_image,
+            33,
+            1,
+            smoothness
+        };
+        for (
+            ULONG index = 0;
+            index < disparity_graph.reparametrization.size();
+            ++index
+        )
+        {
+            disparity_graph.reparametrization[index]
+                = static_cast<FLOAT>(index * 7919 % 1013) / 11 - 40;
+        }
+
+        for (ULONG y = 0; y < 3; ++y)
+        {
+            for (ULONG x = 0; x < 40; ++x)
+            {
+                for (
+                    ULONG neighbor_index = 0;
+                    neighbor_index < NEIGHBORS_COUNT;
+                    ++neighbor_index
+                )
+                {
+                    if (
+                        !neighborhood_exists_fast(
+                            &disparity_graph,
+                            {x, y},
+                            neighbor_index
+                        )
+                    )
+                    {
+                        continue;
+                    }
+                    struct Edge edge{
+                        {{x, y}, 0},
+                        {neighbor_by_index({x, y}, neighbor_index), 0}
+                    };
+                    FLOAT expected = edge_penalty(&disparity_graph, edge);
+                    for (
+                        edge.node.disparity = 0;
+                        edge.node.pixel.x + edge.node.disparity < 40
+                            && edge.node.disparity < 33;
+                        ++edge.node.disparity
+                    )
+                    {
+                        for (
+                            edge.neighbor.disparity
+                                = edge.neighbor.pixel.x == x
+                                    || edge.node.disparity <= 1
+                                ? 0
+                                : edge.node.disparity - 1;
+                            edge.neighbor.pixel.x + edge.neighbor.disparity < 40
+                                && edge.neighbor.disparity < 33;
+                            ++edge.neighbor.disparity
+                        )
+                        {
+                            expected = std::min(
+                                expected,
+                                edge_penalty(&disparity_graph, edge)
+                            );
+                        }
+                    }
+                    BOOST_CHECK_SMALL(
+                        calculate_lowest_neighborhood_penalty_slow(
+                            &disparity_graph,
+                            {x, y},
+                            neighbor_index
+                        ) - expected,
+                        1e-3f
+                    );
+                }
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
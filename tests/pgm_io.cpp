@@ -27,6 +27,8 @@
 #include <indexing.hpp>
 #include <pgm_io.hpp>
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -34,9 +36,17 @@
 
 BOOST_AUTO_TEST_SUITE(PGM_IO_test)
 
+using sp::image::checked_multiply;
 using sp::image::Image;
 using sp::image::PGM_IO;
+using sp::image::PGMView;
+using sp::image::pgm_view_value;
+using sp::image::read_pgm;
+using sp::image::read_pgm_header;
+using sp::image::view_binary_pgm;
 using sp::indexing::pixel_value;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
 
 BOOST_AUTO_TEST_CASE(read_image)
 {
@@ -179,6 +189,60 @@ BOOST_AUTO_TEST_CASE(read_intensity_letter)
     BOOST_CHECK(!image_content);
 }
 
+BOOST_AUTO_TEST_CASE(read_too_big_number)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{R"image(
+    P2
+    99999999999999999999999999 1
+    5
+    0
+    )image"};
+    image_content >> pgm_io;
+    BOOST_CHECK(!pgm_io.get_image());
+    BOOST_CHECK(!image_content);
+}
+
+BOOST_AUTO_TEST_CASE(read_intensity_with_suffix)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{R"image(
+    P2
+    3 2
+    5
+    0 1 2
+    3 4 5x
+    )image"};
+    image_content >> pgm_io;
+    BOOST_CHECK(!pgm_io.get_image());
+    BOOST_CHECK(!image_content);
+}
+
+BOOST_AUTO_TEST_CASE(read_write_large_image)
+{
+    ULONG_ARRAY values;
+    for (ULONG index = 0; index < 1024 * 512; ++index)
+    {
+        values.push_back(index * 7919 % 65536);
+    }
+    struct Image image{1024, 512, 65535, values};
+    std::ostringstream image_output;
+    image_output << PGM_IO{std::make_shared<struct Image>(image)};
+    BOOST_REQUIRE(image_output);
+    BOOST_REQUIRE(image_output.str().size() > PGM_IO::PARALLEL_PARSING_SIZE);
+
+    PGM_IO pgm_io;
+    std::istringstream image_input{image_output.str()};
+    image_input >> pgm_io;
+    BOOST_CHECK(image_input);
+    BOOST_REQUIRE(pgm_io.get_image());
+    BOOST_CHECK(pgm_io.get_image()->data == image.data);
+
+    std::istringstream broken_input{image_output.str() + " 0"};
+    broken_input >> pgm_io;
+    BOOST_CHECK(!broken_input);
+}
+
 BOOST_AUTO_TEST_CASE(write_image)
 {
     std::shared_ptr<struct Image> image = std::make_shared<struct Image>(
@@ -264,4 +328,196 @@ BOOST_AUTO_TEST_CASE(read_write_imagelong)
     BOOST_CHECK(image_output);
 }
 
+BOOST_AUTO_TEST_CASE(read_binary_image)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{std::string{
+        "P5\n# 3 columns and 2 rows\n3 2\n10\n\x00\x01\x02\x03\x0a\x05",
+        39
+    }};
+    image_content >> pgm_io;
+    BOOST_CHECK(image_content);
+    BOOST_CHECK(pgm_io.is_binary());
+    BOOST_REQUIRE(pgm_io.get_image());
+    BOOST_CHECK_EQUAL(pgm_io.get_image()->width, 3);
+    BOOST_CHECK_EQUAL(pgm_io.get_image()->height, 2);
+    BOOST_CHECK_EQUAL(pgm_io.get_image()->max_value, 10);
+
+    struct Image image{*pgm_io.get_image()};
+    BOOST_CHECK_EQUAL(pixel_value(&image, {0, 0}), 0);
+    BOOST_CHECK_EQUAL(pixel_value(&image, {1, 0}), 1);
+    BOOST_CHECK_EQUAL(pixel_value(&image, {2, 0}), 2);
+    BOOST_CHECK_EQUAL(pixel_value(&image, {0, 1}), 3);
+    BOOST_CHECK_EQUAL(pixel_value(&image, {1, 1}), 10);
+    BOOST_CHECK_EQUAL(pixel_value(&image, {2, 1}), 5);
+}
+
+BOOST_AUTO_TEST_CASE(read_binary_wrong_max_value)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{std::string{"P5\n2 1\n10\n\x01\x0b", 12}};
+    image_content >> pgm_io;
+    BOOST_CHECK(!pgm_io.get_image());
+    BOOST_CHECK(!image_content);
+}
+
+BOOST_AUTO_TEST_CASE(read_binary_incomplete_data)
+{
+    PGM_IO pgm_io;
+    std::istringstream image_content{std::string{"P5\n2 2\n300\n\x01\x00\x00", 14}};
+    image_content >> pgm_io;
+    BOOST_CHECK(!pgm_io.get_image());
+    BOOST_CHECK(!image_content);
+}
+
+BOOST_AUTO_TEST_CASE(read_overflowing_size)
+{
+    for (
+        const std::string& contents : {
+            std::string{"P5\n4611686018427387904 4\n255\n\x01\x02"},
+            std::string{"P5\n4611686018427387904 2\n300\n\x01\x02"},
+            std::string{"P2\n4611686018427387904 4\n255\n1 2 3 4\n"}
+        }
+    )
+    {
+        PGM_IO pgm_io;
+        std::istringstream image_content{contents};
+        image_content >> pgm_io;
+        BOOST_CHECK(!pgm_io.get_image());
+        BOOST_CHECK(!image_content);
+
+        struct PGMView view{0, 0, 0, nullptr};
+        BOOST_CHECK(
+            !view_binary_pgm(
+                contents.data(),
+                contents.data() + contents.size(),
+                &view
+            )
+        );
+
+        std::string path{"pgm_io_overflow_test_image.pgm"};
+        {
+            std::ofstream image_file(path, std::ios::out | std::ios::binary);
+            image_file << contents;
+        }
+        BOOST_CHECK(!read_pgm(path));
+        BOOST_CHECK(!read_pgm_header(path));
+        std::remove(path.c_str());
+    }
+
+    ULONG product = 0;
+    BOOST_CHECK(checked_multiply(1ul << 31u, 1ul << 32u, &product));
+    BOOST_CHECK_EQUAL(product, 1ul << 63u);
+    BOOST_CHECK(!checked_multiply(1ul << 32u, 1ul << 32u, &product));
+    BOOST_CHECK(checked_multiply(0, 1ul << 63u, &product));
+    BOOST_CHECK_EQUAL(product, 0);
+}
+
+BOOST_AUTO_TEST_CASE(write_binary_big_max_value)
+{
+    PGM_IO pgm_io{
+        std::make_shared<struct Image>(Image{1, 1, 65536, {65536}}),
+        true
+    };
+    std::ostringstream image_output;
+    image_output << pgm_io;
+    BOOST_CHECK(!image_output);
+}
+
+BOOST_AUTO_TEST_CASE(read_write_binary_image)
+{
+    for (ULONG max_value : {255ul, 65535ul})
+    {
+        ULONG_ARRAY values;
+        for (ULONG index = 0; index < 4 * 3; ++index)
+        {
+            values.push_back(index * max_value / 11);
+        }
+        struct Image image{4, 3, max_value, values};
+        PGM_IO pgm_io{std::make_shared<struct Image>(image), true};
+
+        std::ostringstream image_output;
+        image_output << pgm_io;
+        BOOST_CHECK(image_output);
+        BOOST_CHECK_EQUAL(
+            image_output.str().size(),
+            std::string{"P5\n4 3\n"}.size()
+            + std::to_string(max_value).size() + 1
+            + image.data.size() * image.data.bytes_per_pixel()
+        );
+
+        PGM_IO read_io;
+        std::istringstream image_input{image_output.str()};
+        image_input >> read_io;
+        BOOST_CHECK(image_input);
+        BOOST_CHECK(read_io.is_binary());
+        BOOST_REQUIRE(read_io.get_image());
+        BOOST_CHECK_EQUAL(read_io.get_image()->max_value, max_value);
+        BOOST_CHECK(read_io.get_image()->data == image.data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(view_binary_image)
+{
+    std::string contents{"P5 2 1 1000\n\x03\xe8\x00\x07", 16};
+    struct PGMView view{0, 0, 0, nullptr};
+    BOOST_REQUIRE(
+        view_binary_pgm(
+            contents.data(),
+            contents.data() + contents.size(),
+            &view
+        )
+    );
+    BOOST_CHECK_EQUAL(view.width, 2);
+    BOOST_CHECK_EQUAL(view.height, 1);
+    BOOST_CHECK_EQUAL(view.max_value, 1000);
+    BOOST_CHECK_EQUAL(pgm_view_value(&view, 0), 1000);
+    BOOST_CHECK_EQUAL(pgm_view_value(&view, 1), 7);
+
+    BOOST_CHECK(
+        !view_binary_pgm(
+            contents.data(),
+            contents.data() + contents.size() - 1,
+            &view
+        )
+    );
+}
+
+BOOST_AUTO_TEST_CASE(read_pgm_file)
+{
+    std::string path{"pgm_io_test_image.pgm"};
+    struct Image image{3, 2, 300, {0, 1, 2, 100, 200, 300}};
+    for (bool binary : {false, true})
+    {
+        {
+            std::ofstream image_file(path, std::ios::out | std::ios::binary);
+            image_file << PGM_IO{std::make_shared<struct Image>(image), binary};
+        }
+        std::shared_ptr<struct Image> read_image = read_pgm(path);
+        BOOST_REQUIRE(read_image);
+        BOOST_CHECK_EQUAL(read_image->width, image.width);
+        BOOST_CHECK_EQUAL(read_image->height, image.height);
+        BOOST_CHECK_EQUAL(read_image->max_value, image.max_value);
+        BOOST_CHECK(read_image->data == image.data);
+
+        std::shared_ptr<struct Image> header = read_pgm_header(path);
+        BOOST_REQUIRE(header);
+        BOOST_CHECK_EQUAL(header->width, image.width);
+        BOOST_CHECK_EQUAL(header->height, image.height);
+        BOOST_CHECK_EQUAL(header->max_value, image.max_value);
+        BOOST_CHECK_EQUAL(header->data.size(), 0);
+    }
+
+    {
+        std::ofstream image_file(path);
+        image_file << "P3\n1 1\n1\n0\n";
+    }
+    BOOST_CHECK(!read_pgm(path));
+    BOOST_CHECK(!read_pgm_header(path));
+    std::remove(path.c_str());
+    BOOST_CHECK(!read_pgm_header(path));
+
+    BOOST_CHECK_THROW(read_pgm(path), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
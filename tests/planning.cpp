@@ -0,0 +1,281 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <labeling_finder.hpp>
+#include <lowest_penalties.hpp>
+#include <planning.hpp>
+#include "random_images.hpp"
+
+#include <stdexcept>
+
+BOOST_AUTO_TEST_SUITE(PlanningTest)
+
+using random_images::fill_noise;
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::lowest_penalties::LowestPenalties;
+using sp::image::Image;
+using sp::labeling::finder::fetch_available_penalties;
+using sp::labeling::finder::ThresholdSearch;
+using sp::planning::estimate_footprint;
+using sp::planning::estimate_level;
+using sp::planning::Footprint;
+using sp::planning::Layout;
+using sp::planning::parse_memory_size;
+using sp::planning::plan_layout;
+using sp::planning::total;
+using sp::types::FLOAT;
+using sp::types::FLOAT_ARRAY;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+namespace
+{
+
+/**
+ * \brief Total estimated footprint of the layout.
+ */
+ULONG estimate(
+    ULONG width,
+    ULONG height,
+    ULONG disparity_levels,
+    const struct Layout& layout
+)
+{
+    struct Footprint footprint = estimate_footprint(
+        width,
+        height,
+        disparity_levels,
+        1,
+        &layout
+    );
+    return total(&footprint);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(level_matches_allocations)
+{
+    struct Image left_image{16, 8, 255, ULONG_ARRAY(16 * 8)};
+    struct Image right_image{16, 8, 255, ULONG_ARRAY(16 * 8)};
+    struct DisparityGraph disparity_graph{left_image, right_image, 6, 1, 1};
+    cache_node_penalties(&disparity_graph);
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    struct ThresholdSearch search{&disparity_graph, &lowest_penalties};
+
+    struct Footprint footprint = estimate_level(16, 8, 6, 1, false, true);
+    BOOST_CHECK_EQUAL(
+        footprint.images,
+        2 * left_image.data.size() * left_image.data.bytes_per_pixel()
+    );
+    BOOST_CHECK_EQUAL(
+        footprint.disparity_graph,
+        (
+            disparity_graph.reparametrization.size()
+            + disparity_graph.node_penalties.size()
+        ) * sizeof(FLOAT)
+    );
+    BOOST_CHECK_EQUAL(
+        footprint.lowest_penalties,
+        (
+            lowest_penalties.pixels.size()
+            + lowest_penalties.neighborhoods.size()
+        ) * sizeof(FLOAT)
+    );
+    BOOST_CHECK_GE(
+        footprint.threshold_search,
+        search.nodes_slacks.size() * sizeof(FLOAT)
+    );
+
+    struct Footprint uncached = estimate_level(16, 8, 6, 1, false, false);
+    BOOST_CHECK_EQUAL(
+        footprint.disparity_graph - uncached.disparity_graph,
+        disparity_graph.node_penalties.size() * sizeof(FLOAT)
+    );
+    struct Footprint windows = estimate_level(16, 8, 6, 1, true, false);
+    BOOST_CHECK_EQUAL(
+        windows.disparity_graph - uncached.disparity_graph,
+        16 * 8 * sizeof(ULONG)
+    );
+
+    struct Footprint narrow = estimate_level(1, 1, 65535, 1, false, false);
+    struct Footprint wide = estimate_level(1, 1, 65536, 1, false, false);
+    BOOST_CHECK_EQUAL(
+        wide.arc_consistency - narrow.arc_consistency,
+        65536 * 4 * 4 - 65535 * 4 * 2
+    );
+}
+
+BOOST_AUTO_TEST_CASE(candidates_fit_estimation)
+{
+    struct Image left_image{12, 8, 255, ULONG_ARRAY(12 * 8)};
+    struct Image right_image{12, 8, 255, ULONG_ARRAY(12 * 8)};
+    fill_noise(&left_image, 17);
+    fill_noise(&right_image, 29);
+    struct DisparityGraph disparity_graph{left_image, right_image, 5, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    FLOAT_ARRAY candidates = fetch_available_penalties(&lowest_penalties);
+
+    struct Footprint footprint = estimate_level(12, 8, 5, 1, false, false);
+    BOOST_CHECK_GE(
+        footprint.threshold_candidates,
+        2 * candidates.size() * sizeof(FLOAT)
+    );
+    BOOST_CHECK_EQUAL(
+        total(&footprint) - footprint.threshold_candidates,
+        footprint.images
+            + footprint.disparity_graph
+            + footprint.lowest_penalties
+            + footprint.threshold_search
+            + footprint.constraint_graph
+            + footprint.arc_consistency
+            + footprint.disparity_maps
+    );
+}
+
+BOOST_AUTO_TEST_CASE(frugal_layouts_need_less)
+{
+    struct Layout dense;
+    struct Layout uncached;
+    uncached.cache_node_penalties = false;
+    struct Layout pyramid{uncached};
+    pyramid.pyramid_levels = 2;
+    pyramid.window = 4;
+    struct Layout tiles{uncached};
+    tiles.tile_width = 16;
+    tiles.tile_height = 16;
+    tiles.halo = 2;
+
+    const ULONG dense_bytes = estimate(128, 96, 48, dense);
+    const ULONG uncached_bytes = estimate(128, 96, 48, uncached);
+    BOOST_CHECK_LT(uncached_bytes, dense_bytes);
+    BOOST_CHECK_LT(estimate(128, 96, 48, pyramid), uncached_bytes);
+    BOOST_CHECK_LT(estimate(128, 96, 48, tiles), uncached_bytes);
+    BOOST_CHECK_LT(estimate(64, 96, 48, dense), dense_bytes);
+    BOOST_CHECK_LT(estimate(128, 96, 24, dense), dense_bytes);
+}
+
+BOOST_AUTO_TEST_CASE(layout_fits_budget)
+{
+    const ULONG width = 128;
+    const ULONG height = 96;
+    const ULONG disparity_levels = 48;
+    struct Layout preferred;
+    struct Layout uncached;
+    uncached.cache_node_penalties = false;
+
+    struct Layout layout = plan_layout(
+        width,
+        height,
+        disparity_levels,
+        1,
+        estimate(width, height, disparity_levels, preferred),
+        preferred,
+        true
+    );
+    BOOST_CHECK(layout.cache_node_penalties);
+    BOOST_CHECK_EQUAL(layout.pyramid_levels, 0);
+    BOOST_CHECK_EQUAL(layout.tile_width, 0);
+
+    layout = plan_layout(
+        width,
+        height,
+        disparity_levels,
+        1,
+        estimate(width, height, disparity_levels, uncached),
+        preferred,
+        true
+    );
+    BOOST_CHECK(!layout.cache_node_penalties);
+    BOOST_CHECK_EQUAL(layout.pyramid_levels, 0);
+    BOOST_CHECK_EQUAL(layout.tile_width, 0);
+
+    const ULONG small_budget
+        = estimate(width, height, disparity_levels, uncached) / 3;
+    layout = plan_layout(
+        width,
+        height,
+        disparity_levels,
+        1,
+        small_budget,
+        preferred,
+        true
+    );
+    BOOST_CHECK_GT(layout.pyramid_levels, 0);
+    BOOST_CHECK_EQUAL(layout.tile_width, 0);
+    BOOST_CHECK_LE(
+        estimate(width, height, disparity_levels, layout),
+        small_budget
+    );
+
+    layout = plan_layout(
+        width,
+        height,
+        disparity_levels,
+        1,
+        small_budget,
+        preferred,
+        false
+    );
+    BOOST_CHECK_EQUAL(layout.pyramid_levels, 0);
+    BOOST_CHECK_GT(layout.tile_width, 0);
+    BOOST_CHECK_EQUAL(layout.tile_width, layout.tile_height);
+    BOOST_CHECK_LE(
+        estimate(width, height, disparity_levels, layout),
+        small_budget
+    );
+    struct Layout larger_tiles{layout};
+    ++larger_tiles.tile_width;
+    ++larger_tiles.tile_height;
+    BOOST_CHECK_GT(
+        estimate(width, height, disparity_levels, larger_tiles),
+        small_budget
+    );
+
+    BOOST_CHECK_THROW(
+        plan_layout(width, height, disparity_levels, 1, 1024, preferred, true),
+        std::invalid_argument
+    );
+}
+
+BOOST_AUTO_TEST_CASE(check_memory_size)
+{
+    BOOST_CHECK_EQUAL(parse_memory_size("4096"), 4096);
+    BOOST_CHECK_EQUAL(parse_memory_size("512K"), 512ul << 10u);
+    BOOST_CHECK_EQUAL(parse_memory_size("256m"), 256ul << 20u);
+    BOOST_CHECK_EQUAL(parse_memory_size("2G"), 2ul << 30u);
+    BOOST_CHECK_THROW(parse_memory_size(""), std::invalid_argument);
+    BOOST_CHECK_THROW(parse_memory_size("G"), std::invalid_argument);
+    BOOST_CHECK_THROW(parse_memory_size("12X"), std::invalid_argument);
+    BOOST_CHECK_THROW(parse_memory_size("1GB"), std::invalid_argument);
+    BOOST_CHECK_THROW(
+        parse_memory_size("99999999999999999999"),
+        std::invalid_argument
+    );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
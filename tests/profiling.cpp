@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <profiling.hpp>
+
+#include <sstream>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(ProfilingTest)
+
+using sp::profiling::count;
+using sp::profiling::finish_stage;
+using sp::profiling::merge_stages;
+using sp::profiling::Profile;
+using sp::profiling::start_stage;
+using sp::profiling::write_json_report;
+using sp::profiling::write_text_report;
+
+BOOST_AUTO_TEST_CASE(check_stages)
+{
+    struct Profile profile;
+    start_stage(&profile, "first");
+    count(&profile, "items", 3);
+    finish_stage(&profile);
+    start_stage(&profile, "second");
+    finish_stage(&profile);
+
+    BOOST_REQUIRE_EQUAL(profile.stages.size(), 2);
+    BOOST_CHECK_EQUAL(profile.stages[0].name, "first");
+    BOOST_CHECK_EQUAL(profile.stages[1].name, "second");
+    BOOST_REQUIRE_EQUAL(profile.stages[0].counters.size(), 1);
+    BOOST_CHECK_EQUAL(profile.stages[0].counters[0].first, "items");
+    BOOST_CHECK_EQUAL(profile.stages[0].counters[0].second, 3);
+    BOOST_CHECK(profile.stages[1].counters.empty());
+    BOOST_CHECK_GE(profile.stages[0].wall_time, 0);
+    BOOST_CHECK_GE(profile.stages[0].cpu_time, 0);
+    BOOST_CHECK_GE(profile.stages[1].peak_rss, profile.stages[0].peak_rss);
+}
+
+BOOST_AUTO_TEST_CASE(check_merge)
+{
+    struct Profile profile;
+    struct Profile part;
+    start_stage(&part, "first");
+    count(&part, "items", 3);
+    finish_stage(&part);
+    part.stages[0].wall_time = 0.5;
+    part.stages[0].cpu_time = 1;
+    part.stages[0].peak_rss = 1024;
+    merge_stages(&profile, &part);
+    merge_stages(&profile, &part);
+
+    start_stage(&part, "second");
+    count(&part, "other", 1);
+    finish_stage(&part);
+    part.stages[0].peak_rss = 2048;
+    part.stages[0].counters[0].first = "more";
+    merge_stages(&profile, &part);
+    part.stages[0].counters[0].second = 5;
+    merge_stages(&profile, &part, {"more"});
+
+    BOOST_REQUIRE_EQUAL(profile.stages.size(), 2);
+    BOOST_CHECK_EQUAL(profile.stages[0].name, "first");
+    BOOST_CHECK_EQUAL(profile.stages[0].wall_time, 2);
+    BOOST_CHECK_EQUAL(profile.stages[0].cpu_time, 4);
+    BOOST_CHECK_EQUAL(profile.stages[0].peak_rss, 2048);
+    BOOST_REQUIRE_EQUAL(profile.stages[0].counters.size(), 2);
+    BOOST_CHECK_EQUAL(profile.stages[0].counters[0].first, "items");
+    BOOST_CHECK_EQUAL(profile.stages[0].counters[0].second, 6);
+    BOOST_CHECK_EQUAL(profile.stages[0].counters[1].first, "more");
+    BOOST_CHECK_EQUAL(profile.stages[0].counters[1].second, 5);
+    BOOST_CHECK_EQUAL(profile.stages[1].name, "second");
+    BOOST_REQUIRE_EQUAL(profile.stages[1].counters.size(), 1);
+    BOOST_CHECK_EQUAL(profile.stages[1].counters[0].second, 2);
+}
+
+BOOST_AUTO_TEST_CASE(check_reports)
+{
+    struct Profile profile;
+    start_stage(&profile, "stage");
+    count(&profile, "items", 42);
+    finish_stage(&profile);
+    profile.stages[0].wall_time = 0.5;
+    profile.stages[0].cpu_time = 1.5;
+    profile.stages[0].peak_rss = 1024;
+
+    std::ostringstream json;
+    write_json_report(json, &profile);
+    BOOST_CHECK_EQUAL(
+        json.str(),
+        "{\"stages\": [{\"name\": \"stage\", \"wall_time\": 0.5"
+        ", \"cpu_time\": 1.5, \"peak_rss\": 1024"
+        ", \"counters\": {\"items\": 42}}]}\n"
+    );
+
+    std::ostringstream text;
+    write_text_report(text, &profile);
+    BOOST_CHECK_NE(text.str().find("items=42"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <constraint_graph.hpp>
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <labeling_finder.hpp>
+#include <lowest_penalties.hpp>
+#include <pyramid.hpp>
+#include "random_images.hpp"
+
+#include <stdexcept>
+
+BOOST_AUTO_TEST_SUITE(PyramidTest)
+
+using random_images::make_shifted_images;
+using sp::graph::constraint::ConstraintGraph;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::disparity::set_minimal_disparities;
+using sp::graph::lowest_penalties::LowestPenalties;
+using sp::image::Image;
+using sp::labeling::finder::build_disparity_map;
+using sp::labeling::finder::calculate_minimal_consistent_threshold;
+using sp::labeling::finder::fetch_available_penalties;
+using sp::labeling::finder::find_labeling_relaxed;
+using sp::pyramid::coarse_disparity_levels;
+using sp::pyramid::downsample;
+using sp::pyramid::upsample_minimal_disparities;
+using sp::types::FLOAT;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+namespace
+{
+
+/**
+ * \brief Solve the graph with the minimal consistent threshold.
+ */
+struct Image solve(struct DisparityGraph* disparity_graph)
+{
+    struct LowestPenalties lowest_penalties{disparity_graph};
+    auto available_penalties = fetch_available_penalties(&lowest_penalties);
+    FLOAT threshold = calculate_minimal_consistent_threshold(
+        &lowest_penalties,
+        disparity_graph,
+        available_penalties
+    );
+    struct ConstraintGraph constraint_graph{
+        disparity_graph,
+        &lowest_penalties,
+        threshold
+    };
+    BOOST_REQUIRE(solve_csp(&constraint_graph));
+    BOOST_REQUIRE(
+        find_labeling_relaxed(&constraint_graph, available_penalties)
+    );
+    return build_disparity_map(&constraint_graph);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(downsample_averages_squares)
+{
+    struct Image image{3, 3, 9, ULONG_ARRAY{
+        0, 2, 9,
+        4, 5, 8,
+        1, 6, 7
+    }};
+    struct Image result = downsample(image);
+    BOOST_CHECK_EQUAL(result.width, 2);
+    BOOST_CHECK_EQUAL(result.height, 2);
+    BOOST_CHECK_EQUAL(result.max_value, 9);
+    BOOST_CHECK(result.data == ULONG_ARRAY({3, 9, 4, 7}));
+
+    BOOST_CHECK_EQUAL(coarse_disparity_levels(16), 8);
+    BOOST_CHECK_EQUAL(coarse_disparity_levels(15), 8);
+    BOOST_CHECK_EQUAL(coarse_disparity_levels(1), 1);
+}
+
+BOOST_AUTO_TEST_CASE(upsample_windows_around_coarse_disparities)
+{
+    struct Image coarse_map{3, 1, 8, ULONG_ARRAY{0, 3, 1}};
+    ULONG_ARRAY minimal_disparities
+        = upsample_minimal_disparities(coarse_map, 6, 2, 10, 4);
+    BOOST_CHECK(
+        minimal_disparities
+            == ULONG_ARRAY({0, 0, 3, 2, 0, 0, 0, 0, 3, 2, 0, 0})
+    );
+
+    minimal_disparities
+        = upsample_minimal_disparities(coarse_map, 5, 1, 7, 4);
+    BOOST_CHECK(minimal_disparities == ULONG_ARRAY({0, 0, 2, 1, 0}));
+
+    struct Image wide_map{4, 1, 8, ULONG_ARRAY{3, 1, 1, 0}};
+    minimal_disparities
+        = upsample_minimal_disparities(wide_map, 8, 1, 7, 4);
+    BOOST_CHECK(
+        minimal_disparities == ULONG_ARRAY({3, 3, 0, 0, 0, 0, 0, 0})
+    );
+    minimal_disparities
+        = upsample_minimal_disparities(wide_map, 8, 1, 16, 2);
+    BOOST_CHECK(
+        minimal_disparities == ULONG_ARRAY({5, 5, 1, 1, 1, 1, 0, 0})
+    );
+
+    BOOST_CHECK_THROW(
+        upsample_minimal_disparities(coarse_map, 6, 2, 10, 1),
+        std::invalid_argument
+    );
+    BOOST_CHECK_THROW(
+        upsample_minimal_disparities(coarse_map, 4, 2, 10, 4),
+        std::invalid_argument
+    );
+}
+
+BOOST_AUTO_TEST_CASE(finer_level_is_consistent_in_windows)
+{
+    struct Image left_image;
+    struct Image right_image;
+    make_shifted_images(1, 2, &left_image, &right_image);
+
+    struct Image coarse_left = downsample(left_image);
+    struct Image coarse_right = downsample(right_image);
+    struct DisparityGraph coarse_graph{
+        coarse_left,
+        coarse_right,
+        coarse_disparity_levels(9),
+        1,
+        1
+    };
+    struct Image coarse_map = solve(&coarse_graph);
+
+    for (ULONG window : {2, 3, 4})
+    {
+        ULONG_ARRAY minimal_disparities = upsample_minimal_disparities(
+            coarse_map,
+            left_image.width,
+            left_image.height,
+            9,
+            window
+        );
+        struct DisparityGraph fine_graph{
+            left_image,
+            right_image,
+            window,
+            1,
+            1
+        };
+        set_minimal_disparities(&fine_graph, minimal_disparities);
+        struct Image fine_map = solve(&fine_graph);
+        for (ULONG index = 0; index < fine_map.data.size(); ++index)
+        {
+            BOOST_CHECK_GE(fine_map.data[index], minimal_disparities[index]);
+            BOOST_CHECK_LT(
+                fine_map.data[index],
+                minimal_disparities[index] + window
+            );
+        }
+    }
+
+    struct DisparityGraph full_graph{left_image, right_image, 9, 1, 1};
+    struct DisparityGraph zero_graph{left_image, right_image, 9, 1, 1};
+    set_minimal_disparities(
+        &zero_graph,
+        ULONG_ARRAY(left_image.width * left_image.height)
+    );
+    BOOST_CHECK(solve(&zero_graph).data == solve(&full_graph).data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef TESTS_RANDOM_IMAGES_HPP
+#define TESTS_RANDOM_IMAGES_HPP
+
+#include <image.hpp>
+#include <types.hpp>
+
+#include <algorithm>
+
+/**
+ * \brief Reproducible random images for tests and benchmarks.
+ */
+namespace random_images
+{
+
+using sp::image::Image;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+/**
+ * \brief Fill the image with a noise
+ * generated by a linear congruential generator from the seed,
+ * so the image is the same on each run.
+ */
+inline void fill_noise(struct Image* image, ULONG seed)
+{
+    for (ULONG index = 0; index < image->data.size(); ++index)
+    {
+        seed = (seed * 1103515245 + 12345) % 2147483648;
+        image->data[index] = (seed >> 16) % (image->max_value + 1);
+    }
+}
+
+/**
+ * \brief Make a pair of 16x8 noise images,
+ * where the right one is the left one shifted by `shift` pixels
+ * (pixels near the right border keep their intensities).
+ */
+inline void make_shifted_images(
+    ULONG seed,
+    ULONG shift,
+    struct Image* left_image,
+    struct Image* right_image
+)
+{
+    const ULONG width = 16;
+    const ULONG height = 8;
+    *left_image = {width, height, 255, ULONG_ARRAY(width * height)};
+    *right_image = {width, height, 255, ULONG_ARRAY(width * height)};
+    fill_noise(left_image, seed);
+    for (ULONG index = 0; index < right_image->data.size(); ++index)
+    {
+        right_image->data[index] = left_image->data[
+            index % width + shift >= width ? index : index + shift
+        ];
+    }
+}
+
+}
+
+#endif
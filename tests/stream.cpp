@@ -0,0 +1,324 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <constraint_graph.hpp>
+#include <disparity_graph.hpp>
+#include <image.hpp>
+#include <labeling_finder.hpp>
+#include <lowest_penalties.hpp>
+#include <stream.hpp>
+#include "random_images.hpp"
+
+#include <limits>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(StreamTest)
+
+using random_images::make_shifted_images;
+using sp::graph::constraint::ConstraintGraph;
+using sp::graph::disparity::cache_node_penalties;
+using sp::graph::disparity::DisparityGraph;
+using sp::graph::disparity::set_minimal_disparities;
+using sp::graph::lowest_penalties::LowestPenalties;
+using sp::image::Image;
+using sp::labeling::finder::build_disparity_map;
+using sp::labeling::finder::calculate_minimal_consistent_threshold;
+using sp::labeling::finder::fetch_available_penalties;
+using sp::labeling::finder::find_labeling;
+using sp::labeling::finder::find_labeling_relaxed;
+using sp::labeling::finder::ThresholdSearch;
+using sp::stream::calculate_labeling_slack;
+using sp::stream::calculate_stream_threshold;
+using sp::stream::calculate_warm_threshold;
+using sp::stream::is_compatible;
+using sp::stream::remember_frame;
+using sp::stream::seed_reparametrization;
+using sp::stream::WarmStart;
+using sp::types::FLOAT;
+using sp::types::FLOAT_ARRAY;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+BOOST_AUTO_TEST_CASE(warm_threshold_matches_cold_search)
+{
+    struct Image left_image;
+    struct Image right_image;
+    make_shifted_images(1, 1, &left_image, &right_image);
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 6, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    auto available_penalties = fetch_available_penalties(&lowest_penalties);
+    FLOAT threshold = calculate_minimal_consistent_threshold(
+        &lowest_penalties,
+        &disparity_graph,
+        available_penalties
+    );
+
+    const FLOAT infinity = std::numeric_limits<FLOAT>::infinity();
+    std::vector<FLOAT> guesses{
+        -infinity,
+        0,
+        threshold / 2,
+        threshold,
+        threshold * 2,
+        available_penalties[available_penalties.size() / 2],
+        infinity
+    };
+    for (FLOAT guess : guesses)
+    {
+        struct ThresholdSearch search{&disparity_graph, &lowest_penalties};
+        BOOST_CHECK_EQUAL(
+            calculate_warm_threshold(
+                &search,
+                available_penalties,
+                guess,
+                infinity,
+                0
+            ),
+            threshold
+        );
+
+        struct ThresholdSearch bounded_search{
+            &disparity_graph,
+            &lowest_penalties
+        };
+        BOOST_CHECK_EQUAL(
+            calculate_warm_threshold(
+                &bounded_search,
+                available_penalties,
+                guess,
+                threshold,
+                0
+            ),
+            threshold
+        );
+
+        struct ThresholdSearch approximate_search{
+            &disparity_graph,
+            &lowest_penalties
+        };
+        FLOAT approximate_threshold = calculate_warm_threshold(
+            &approximate_search,
+            available_penalties,
+            guess,
+            infinity,
+            1000
+        );
+        BOOST_CHECK_GE(approximate_threshold, threshold);
+        BOOST_CHECK_LE(approximate_threshold, threshold + 1000);
+    }
+
+    struct ThresholdSearch search{&disparity_graph, &lowest_penalties};
+    calculate_warm_threshold(
+        &search,
+        available_penalties,
+        threshold,
+        threshold,
+        0
+    );
+    BOOST_CHECK_LE(search.probes, 1);
+}
+
+BOOST_AUTO_TEST_CASE(labeling_slack_bounds_threshold)
+{
+    struct Image left_image;
+    struct Image right_image;
+    make_shifted_images(1, 1, &left_image, &right_image);
+
+    struct DisparityGraph disparity_graph{left_image, right_image, 6, 1, 1};
+    struct LowestPenalties lowest_penalties{&disparity_graph};
+    auto available_penalties = fetch_available_penalties(&lowest_penalties);
+    FLOAT threshold = calculate_minimal_consistent_threshold(
+        &lowest_penalties,
+        &disparity_graph,
+        available_penalties
+    );
+    struct ConstraintGraph constraint_graph{
+        &disparity_graph,
+        &lowest_penalties,
+        threshold
+    };
+    BOOST_REQUIRE(solve_csp(&constraint_graph));
+    BOOST_REQUIRE(find_labeling(&constraint_graph));
+    struct Image disparity_map = build_disparity_map(&constraint_graph);
+
+    struct ThresholdSearch search{&disparity_graph, &lowest_penalties};
+    FLOAT slack = calculate_labeling_slack(&search, &disparity_map);
+    BOOST_CHECK_GE(slack, threshold);
+    BOOST_CHECK_LE(slack, constraint_graph.threshold);
+
+    struct Image overflow{disparity_map};
+    overflow.data[15] = 1;
+    BOOST_CHECK_GT(calculate_labeling_slack(&search, &overflow), 1e30);
+
+    struct Image small{2, 2, 5, ULONG_ARRAY(4)};
+    BOOST_CHECK_GT(calculate_labeling_slack(&search, &small), 1e30);
+}
+
+BOOST_AUTO_TEST_CASE(next_frame_is_seeded_by_previous)
+{
+    struct Image left_image;
+    struct Image right_image;
+    make_shifted_images(1, 1, &left_image, &right_image);
+
+    struct DisparityGraph first_graph{left_image, right_image, 6, 1, 1};
+    for (ULONG index = 0; index < first_graph.reparametrization.size(); ++index)
+    {
+        first_graph.reparametrization[index] = static_cast<FLOAT>(index % 7) - 3;
+    }
+    struct LowestPenalties first_penalties{&first_graph};
+    auto first_available = fetch_available_penalties(&first_penalties);
+    FLOAT first_threshold = calculate_minimal_consistent_threshold(
+        &first_penalties,
+        &first_graph,
+        first_available
+    );
+    struct ConstraintGraph constraint_graph{
+        &first_graph,
+        &first_penalties,
+        first_threshold
+    };
+    BOOST_REQUIRE(solve_csp(&constraint_graph));
+    BOOST_REQUIRE(find_labeling_relaxed(&constraint_graph, first_available));
+
+    struct WarmStart warm_start;
+    BOOST_CHECK(!is_compatible(&warm_start, &first_graph));
+    remember_frame(
+        &warm_start,
+        &first_graph,
+        first_threshold,
+        build_disparity_map(&constraint_graph)
+    );
+    BOOST_CHECK_EQUAL(warm_start.frames, 1);
+
+    make_shifted_images(2, 1, &left_image, &right_image);
+    struct DisparityGraph next_graph{left_image, right_image, 6, 1, 1};
+    cache_node_penalties(&next_graph);
+    BOOST_REQUIRE(seed_reparametrization(&warm_start, &next_graph));
+    BOOST_CHECK(next_graph.reparametrization == first_graph.reparametrization);
+    struct DisparityGraph expected_graph{left_image, right_image, 6, 1, 1};
+    expected_graph.reparametrization = first_graph.reparametrization;
+    cache_node_penalties(&expected_graph);
+    BOOST_CHECK(next_graph.node_penalties == expected_graph.node_penalties);
+
+    struct LowestPenalties next_penalties{&next_graph};
+    auto next_available = fetch_available_penalties(&next_penalties);
+    struct ThresholdSearch search{&next_graph, &next_penalties};
+    BOOST_CHECK_EQUAL(
+        calculate_stream_threshold(&warm_start, &search, next_available, 0),
+        calculate_minimal_consistent_threshold(
+            &next_penalties,
+            &next_graph,
+            next_available
+        )
+    );
+
+    struct DisparityGraph other_graph{left_image, right_image, 5, 1, 1};
+    BOOST_CHECK(!is_compatible(&warm_start, &other_graph));
+    BOOST_CHECK(!seed_reparametrization(&warm_start, &other_graph));
+}
+
+BOOST_AUTO_TEST_CASE(other_windows_keep_only_threshold_seed)
+{
+    struct Image left_image;
+    struct Image right_image;
+    make_shifted_images(3, 1, &left_image, &right_image);
+    const ULONG pixels = right_image.width * right_image.height;
+    ULONG_ARRAY first_windows(pixels, 1);
+    ULONG_ARRAY next_windows(pixels, 0);
+    for (ULONG index = 0; index < pixels; ++index)
+    {
+        const ULONG x = index % right_image.width;
+        if (x + 1 == right_image.width)
+        {
+            first_windows[index] = 0;
+        }
+        else if (x % 2 == 0 && x + 2 < right_image.width)
+        {
+            next_windows[index] = 2;
+        }
+    }
+
+    struct DisparityGraph first_graph{left_image, right_image, 3, 1, 1};
+    set_minimal_disparities(&first_graph, first_windows);
+    for (ULONG index = 0; index < first_graph.reparametrization.size(); ++index)
+    {
+        first_graph.reparametrization[index] = static_cast<FLOAT>(index % 5) - 2;
+    }
+    struct LowestPenalties first_penalties{&first_graph};
+    auto first_available = fetch_available_penalties(&first_penalties);
+    FLOAT first_threshold = calculate_minimal_consistent_threshold(
+        &first_penalties,
+        &first_graph,
+        first_available
+    );
+    struct ConstraintGraph constraint_graph{
+        &first_graph,
+        &first_penalties,
+        first_threshold
+    };
+    BOOST_REQUIRE(solve_csp(&constraint_graph));
+    BOOST_REQUIRE(find_labeling_relaxed(&constraint_graph, first_available));
+
+    struct WarmStart warm_start;
+    remember_frame(
+        &warm_start,
+        &first_graph,
+        first_threshold,
+        build_disparity_map(&constraint_graph)
+    );
+    BOOST_CHECK(
+        warm_start.minimal_disparities == first_graph.minimal_disparities
+    );
+
+    make_shifted_images(4, 1, &left_image, &right_image);
+    struct DisparityGraph same_graph{left_image, right_image, 3, 1, 1};
+    set_minimal_disparities(&same_graph, first_windows);
+    BOOST_CHECK(seed_reparametrization(&warm_start, &same_graph));
+    BOOST_CHECK(same_graph.reparametrization == first_graph.reparametrization);
+
+    struct DisparityGraph next_graph{left_image, right_image, 3, 1, 1};
+    set_minimal_disparities(&next_graph, next_windows);
+    BOOST_CHECK(is_compatible(&warm_start, &next_graph));
+    BOOST_CHECK(!seed_reparametrization(&warm_start, &next_graph));
+    BOOST_CHECK(
+        next_graph.reparametrization
+            == FLOAT_ARRAY(next_graph.reparametrization.size(), 0)
+    );
+
+    struct LowestPenalties next_penalties{&next_graph};
+    auto next_available = fetch_available_penalties(&next_penalties);
+    struct ThresholdSearch search{&next_graph, &next_penalties};
+    BOOST_CHECK_EQUAL(
+        calculate_stream_threshold(&warm_start, &search, next_available, 0),
+        calculate_minimal_consistent_threshold(
+            &next_penalties,
+            &next_graph,
+            next_available
+        )
+    );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,141 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <tile_scheduler.hpp>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+BOOST_AUTO_TEST_SUITE(TileSchedulerTest)
+
+using sp::scheduling::Tile;
+using sp::scheduling::TileScheduler;
+using sp::types::BOOL;
+using sp::types::ULONG;
+
+BOOST_AUTO_TEST_CASE(split_into_tiles)
+{
+    TileScheduler scheduler{10, 7, 4, 3, 2};
+    BOOST_CHECK_EQUAL(scheduler.get_tiles(), 9);
+    BOOST_CHECK_EQUAL(scheduler.get_threads(), 2);
+    BOOST_CHECK(scheduler.any_dirty());
+
+    struct Tile tile = scheduler.tile(0);
+    BOOST_CHECK_EQUAL(tile.x, 0);
+    BOOST_CHECK_EQUAL(tile.y, 0);
+    BOOST_CHECK_EQUAL(tile.width, 4);
+    BOOST_CHECK_EQUAL(tile.height, 3);
+
+    tile = scheduler.tile(8);
+    BOOST_CHECK_EQUAL(tile.x, 8);
+    BOOST_CHECK_EQUAL(tile.y, 6);
+    BOOST_CHECK_EQUAL(tile.width, 2);
+    BOOST_CHECK_EQUAL(tile.height, 1);
+
+    BOOST_CHECK_THROW((TileScheduler{0, 7, 4, 3, 2}), std::invalid_argument);
+    BOOST_CHECK_THROW((TileScheduler{10, 7, 4, 0, 2}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(process_each_pixel_once)
+{
+    TileScheduler scheduler{10, 7, 4, 3, 4};
+    std::unique_ptr<std::atomic<ULONG>[]> visits{new std::atomic<ULONG>[70]};
+    for (ULONG index = 0; index < 70; ++index)
+    {
+        visits[index] = 0;
+    }
+
+    scheduler.run(
+        [&visits](const struct Tile& tile)
+        {
+            for (ULONG y = tile.y; y < tile.y + tile.height; ++y)
+            {
+                for (ULONG x = tile.x; x < tile.x + tile.width; ++x)
+                {
+                    ++visits[x + 10 * y];
+                }
+            }
+            return false;
+        }
+    );
+
+    BOOST_CHECK_EQUAL(scheduler.get_sweeps(), 1);
+    BOOST_CHECK(!scheduler.is_stopped());
+    BOOST_CHECK(!scheduler.any_dirty());
+    for (ULONG index = 0; index < 70; ++index)
+    {
+        BOOST_CHECK_EQUAL(visits[index], 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sweep_neighbors_of_changed_tiles)
+{
+    TileScheduler scheduler{12, 12, 4, 4, 3};
+    std::unique_ptr<std::atomic<ULONG>[]> visits{new std::atomic<ULONG>[9]};
+    for (ULONG index = 0; index < 9; ++index)
+    {
+        visits[index] = 0;
+    }
+
+    scheduler.run(
+        [&visits](const struct Tile& tile)
+        {
+            const ULONG index = tile.x / 4 + 3 * (tile.y / 4);
+            return ++visits[index] == 1 && index == 0;
+        }
+    );
+
+    BOOST_CHECK_EQUAL(scheduler.get_sweeps(), 2);
+    BOOST_CHECK_EQUAL(visits[0], 2);
+    BOOST_CHECK_EQUAL(visits[1], 2);
+    BOOST_CHECK_EQUAL(visits[3], 2);
+    BOOST_CHECK_EQUAL(visits[4], 1);
+    BOOST_CHECK_EQUAL(visits[8], 1);
+}
+
+BOOST_AUTO_TEST_CASE(stop_sweeps)
+{
+    TileScheduler scheduler{8, 8, 1, 1, 2};
+    std::atomic<ULONG> processed{0};
+
+    scheduler.run(
+        [&scheduler, &processed](const struct Tile&)
+        {
+            if (++processed == 5)
+            {
+                scheduler.stop();
+            }
+            return true;
+        }
+    );
+
+    BOOST_CHECK(scheduler.is_stopped());
+    BOOST_CHECK_EQUAL(scheduler.get_sweeps(), 1);
+    BOOST_CHECK_LT(processed.load(), 64);
+    BOOST_CHECK(scheduler.any_dirty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2021 char-lie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <image.hpp>
+#include <tiling.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(TilingTest)
+
+using sp::image::Image;
+using sp::tiling::crop;
+using sp::tiling::HaloTile;
+using sp::tiling::plan_tiles;
+using sp::tiling::stitch;
+using sp::tiling::Tile;
+using sp::types::ULONG;
+using sp::types::ULONG_ARRAY;
+
+BOOST_AUTO_TEST_CASE(tiles_cover_image)
+{
+    const ULONG width = 23;
+    const ULONG height = 17;
+    const ULONG disparity_levels = 5;
+    const ULONG halo = 2;
+    std::vector<struct HaloTile> tiles
+        = plan_tiles(width, height, disparity_levels, 8, 6, halo);
+    BOOST_CHECK_EQUAL(tiles.size(), 3 * 3);
+
+    std::vector<int> covered(width * height, 0);
+    for (const struct HaloTile& tile : tiles)
+    {
+        BOOST_CHECK_LE(tile.extended.x, tile.core.x);
+        BOOST_CHECK_LE(tile.extended.y, tile.core.y);
+        BOOST_CHECK_LE(tile.extended.x + tile.extended.width, width);
+        BOOST_CHECK_LE(tile.extended.y + tile.extended.height, height);
+        BOOST_CHECK_EQUAL(
+            tile.extended.x + tile.extended.width,
+            std::min(
+                tile.core.x + tile.core.width + halo + disparity_levels - 1,
+                width
+            )
+        );
+        BOOST_CHECK_EQUAL(
+            tile.core.y - tile.extended.y,
+            std::min(tile.core.y, halo)
+        );
+        for (ULONG y = tile.core.y; y < tile.core.y + tile.core.height; ++y)
+        {
+            for (ULONG x = tile.core.x; x < tile.core.x + tile.core.width; ++x)
+            {
+                ++covered[x + width * y];
+            }
+        }
+    }
+    BOOST_CHECK(covered == std::vector<int>(width * height, 1));
+
+    BOOST_CHECK_THROW(plan_tiles(0, 5, 1, 2, 2, 0), std::invalid_argument);
+    BOOST_CHECK_THROW(plan_tiles(5, 5, 1, 0, 2, 0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(crop_and_stitch)
+{
+    struct Image image{4, 3, 11, ULONG_ARRAY{
+        0, 1, 2, 3,
+        4, 5, 6, 7,
+        8, 9, 10, 11
+    }};
+    struct Tile part{1, 1, 3, 2};
+    struct Image cropped = crop(image, part);
+    BOOST_CHECK_EQUAL(cropped.width, 3);
+    BOOST_CHECK_EQUAL(cropped.height, 2);
+    BOOST_CHECK_EQUAL(cropped.max_value, 11);
+    BOOST_CHECK(cropped.data == ULONG_ARRAY({5, 6, 7, 9, 10, 11}));
+    BOOST_CHECK_THROW(crop(image, {2, 1, 3, 2}), std::invalid_argument);
+
+    struct Image disparity_map{4, 3, 11, ULONG_ARRAY(4 * 3)};
+    struct HaloTile tile{{2, 1, 1, 2}, part};
+    stitch(&disparity_map, cropped, tile);
+    BOOST_CHECK(
+        disparity_map.data
+            == ULONG_ARRAY({0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 10, 0})
+    );
+}
+
+BOOST_AUTO_TEST_SUITE_END()